@@ -1,96 +1,237 @@
 #include "XML.h"
-#include <sstream>
+#include "XMLFile.h"
+#include "XMLArena.h"
+#include "XMLLexer.h"
+#include "XMLBuilder.h"
+#include "XMLScan.h"
+#include "XMLOutput.h"
+#include "XMLIndex.h"
+#include "XMLAtom.h"
+#include <cstring>
+#include <new>
+#include <cstddef>
+#include <algorithm>
 
 namespace XML{
-	
+
 //-------------------------Escape-Characters---------------------------------//
 	const std::string escapeCharacters = "\"'&><";
-	const std::string XML::escapeStrings[] = {"&quot;","&apos;","&amp;","&gt;","&lt;"};
+	const std::string escapeStrings[] = {"&quot;","&apos;","&amp;","&gt;","&lt;"};
 	const unsigned int NumberOfEscapeCharacters = escapeCharacters.length();
 	
-	inline bool ContainsAnEscapeCharacter(const std::string& str){
-		return (str.find_first_of(escapeCharacters) != std::string::npos);
+	//For every character, 0 if it is written as it is, otherwise 1 + the index of its escape string.
+	const unsigned char escapeIndex[256] = {
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,1,0,0,0,3,2,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,5,0,4,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+		0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
+	};
+	
+	//Text shorter than this is checked one character at a time, the scanner only pays off on longer text.
+	static const std::size_t ShortText = 32;
+	
+	inline bool ContainsAnEscapeCharacter(const char* begin, const char* end){
+		if(end - begin < (std::ptrdiff_t)ShortText){
+			for(; begin != end; ++begin){
+				if(escapeIndex[(unsigned char)*begin] != 0)	return true;
+			}
+			return false;
+		}
+		return (ScanForEscape(begin, end) != end);
+	}
+	
+	void AppendEscaped(std::string& output, const char* begin, const char* end){
+		const char* run = begin;
+		if(end - begin < (std::ptrdiff_t)ShortText){
+			for(const char* c = begin; c != end; ++c){
+				const unsigned char index = escapeIndex[(unsigned char)*c];
+				if(index != 0){
+					output.append(run, c);
+					output.append(escapeStrings[index - 1]);
+					run = c + 1;
+				}
+			}
+		}else{
+			for(const char* c = ScanForEscape(run, end); c != end; c = ScanForEscape(run, end)){
+				output.append(run, c);
+				output.append(escapeStrings[escapeIndex[(unsigned char)*c] - 1]);
+				run = c + 1;
+			}
+		}
+		output.append(run, end);
 	}
 	
-	std::string EscapeCharacterToString(char c){
-		for(unsigned int i = 0; i < NumberOfEscapeCharacters; ++i){
-			if(escapeCharacters[i] == c)	return escapeStrings[i];
+	//Write the code point as UTF-8, returns the number of bytes.
+	static unsigned int EncodeUTF8(unsigned long code, char* output){
+		if(code < 0x80){
+			output[0] = (char)code;
+			return 1;
+		}else if(code < 0x800){
+			output[0] = (char)(0xC0 | (code >> 6));
+			output[1] = (char)(0x80 | (code & 0x3F));
+			return 2;
+		}else if(code < 0x10000){
+			output[0] = (char)(0xE0 | (code >> 12));
+			output[1] = (char)(0x80 | ((code >> 6) & 0x3F));
+			output[2] = (char)(0x80 | (code & 0x3F));
+			return 3;
 		}
-		return std::string(1,c);
+		output[0] = (char)(0xF0 | (code >> 18));
+		output[1] = (char)(0x80 | ((code >> 12) & 0x3F));
+		output[2] = (char)(0x80 | ((code >> 6) & 0x3F));
+		output[3] = (char)(0x80 | (code & 0x3F));
+		return 4;
 	}
 	
-	std::ostream& WriteEscapeCharacterToStream(std::ostream& os, char c){
-		for(unsigned int i = 0; i < NumberOfEscapeCharacters; ++i){
-			if(escapeCharacters[i] == c){
-				os << escapeStrings[i];
-				break;
+	//Read the numeric character reference after "&#", ie. "65;" or "x41;".
+	//Returns the end of the reference, or NULL if it is not a valid one.
+	static const char* ReadCharacterReference(const char* s, const char* end, char* decoded, unsigned int& length){
+		unsigned long code = 0;
+		const bool hex = (s < end && (*s == 'x' || *s == 'X'));
+		if(hex)	++s;
+		const char* digits = s;
+		for(; s < end && *s != ';'; ++s){
+			const char c = *s;
+			unsigned int digit;
+			if(c >= '0' && c <= '9'){
+				digit = c - '0';
+			}else if(hex && c >= 'a' && c <= 'f'){
+				digit = c - 'a' + 10;
+			}else if(hex && c >= 'A' && c <= 'F'){
+				digit = c - 'A' + 10;
+			}else{
+				return NULL;
 			}
+			code = code * (hex ? 16 : 10) + digit;
+			if(code > 0x10FFFF)	return NULL;
 		}
-		return os;
+		if(s == end || s == digits || code == 0 || (code >= 0xD800 && code <= 0xDFFF)){
+			return NULL;
+		}
+		length = EncodeUTF8(code, decoded);
+		return s + 1;
 	}
 	
-	char EscapeStringToCharacter(const std::string& str){
-		for(unsigned int i = 0; i < NumberOfEscapeCharacters; ++i){
-			if(escapeStrings[i] == str)	return escapeCharacters[i];
+	//Decode the escape string or character reference starting at s, which points to a '&'.
+	//Returns the end of the reference, or NULL if it is not one. Nothing at or after end is read.
+	static const char* ReadReference(const char* s, const char* end, char* decoded, unsigned int& length){
+		const std::ptrdiff_t available = end - s;
+		if(available < 4){ //"&lt;" is the shortest
+			return NULL;
+		}
+		unsigned int index = NumberOfEscapeCharacters;
+		switch(s[1]){
+			case '#':
+				return ReadCharacterReference(s + 2, end, decoded, length);
+			case 'l':	index = 4;	break;
+			case 'g':	index = 3;	break;
+			case 'q':	index = 0;	break;
+			case 'a':	index = (s[2] == 'm') ? 2 : 1;	break;
+			default:
+				return NULL;
+		}
+		const std::string& escape = escapeStrings[index];
+		if((std::size_t)available < escape.length() || memcmp(s, escape.data(), escape.length()) != 0){
+			return NULL;
 		}
-		return '\0';
+		decoded[0] = escapeCharacters[index];
+		length = 1;
+		return s + escape.length();
 	}
 	
-	bool StrComp(const char * str1, const char * str2, unsigned int strlen){
-		while(strlen > 0){
-			strlen--;
-			if(str1[strlen] != str2[strlen]){
-				return false;
+	void AppendDeEscaped(std::string& output, const char* begin, const char* end){
+		char decoded[4];
+		unsigned int length;
+		const char* fnd = ScanForChar(begin, end, '&');
+		while(fnd != end){
+			const char* next = ReadReference(fnd, end, decoded, length);
+			if(next == NULL){ //not a reference, the '&' is kept
+				output.append(begin, fnd + 1);
+				begin = fnd + 1;
+			}else{
+				output.append(begin, fnd);
+				output.append(decoded, length);
+				begin = next;
 			}
+			fnd = ScanForChar(begin, end, '&');
 		}
-		return true;
+		output.append(begin, end);
 	}
 	
-	std::size_t IsEscapeString(const char * str){
-		for(unsigned int i = 0; i < NumberOfEscapeCharacters; ++i){
-			if(StrComp(str,escapeStrings[i].begin(), escapeStrings[i].length())){
-				return i;
+	std::size_t DeEscapeInPlace(char* data, std::size_t length){
+		const char* end = data + length;
+		const char* read = ScanForChar(data, end, '&');
+		char* write = data + (read - data);
+		unsigned int decodedLength;
+		while(read != end){
+			//a reference is always longer than its characters, so the output never catches up with the input
+			const char* next = (*read == '&') ? ReadReference(read, end, write, decodedLength) : NULL;
+			if(next == NULL){
+				*write++ = *read++;
+			}else{
+				write += decodedLength;
+				read = next;
 			}
 		}
-		return std::string::npos;
+		return write - data;
+	}
+	
+	void DeEscapeInPlace(std::string& str){
+		if(!str.empty()){
+			str.resize(DeEscapeInPlace(&str[0], str.length()));
+		}
 	}
 	
 	std::string EscapeString(const std::string& str){
-		std::stringstream output;
-		std::size_t pfnd = 0;
-        std::size_t fnd = str.find_first_of(escapeCharacters);
-		while(fnd != std::string::npos){
-			output.write(&str[pfnd],fnd-pfnd);
-			WriteEscapeCharacterToStream(output, str[fnd]);
-			pfnd = fnd+1;
-			fnd = str.find_first_of(escapeCharacters,pfnd);
+		if(!ContainsAnEscapeCharacter(str.data(), str.data() + str.length())){
+			return str;
+		}
+		std::string output;
+		output.reserve(str.length() + str.length() / 2);
+		AppendEscaped(output, str.data(), str.data() + str.length());
+		return output;
+	}
+	
+	const std::string& EscapeString(const std::string& str, std::string& buffer){
+		if(!ContainsAnEscapeCharacter(str.data(), str.data() + str.length())){
+			return str;
 		}
-		output.write(&str[pfnd],str.length()-pfnd);
-		return output.str();
+		buffer.clear();
+		AppendEscaped(buffer, str.data(), str.data() + str.length());
+		return buffer;
 	}
 	
 	std::string DeEscapeString(const std::string& str){
-        std::stringstream output;
-		std::size_t pfnd = 0;
-		std::size_t fnd = str.find('&');
-		while(fnd != std::string::npos){
-            std::size_t tmp_fnd = IsEscapeString(&str[fnd]);
-			if(tmp_fnd != std::string::npos){
-				output.write(&str[pfnd],fnd-pfnd);
-				output << escapeCharacters[tmp_fnd];
-				pfnd = fnd+escapeStrings[tmp_fnd].length();
-				fnd = str.find('&',pfnd);
-			}else{
-				fnd = str.find('&',fnd+1);
-			}
+		std::string output;
+		output.reserve(str.length());
+		AppendDeEscaped(output, str.data(), str.data() + str.length());
+		return output;
+	}
+	
+	const std::string& DeEscapeString(const std::string& str, std::string& buffer){
+		if(str.find('&') == std::string::npos){
+			return str;
 		}
-		output.write(&str[pfnd],str.length()-pfnd);
-        return output.str();
+		buffer.clear();
+		AppendDeEscaped(buffer, str.data(), str.data() + str.length());
+		return buffer;
 	}
-
+	
 //-------------------------------------PUBLIC------------------------------------------//
-
-	XML::Object* XML::Copy(const Object* other){
+	
+	XML::Object* Copy(const Object* other){
 		XML::Object* output;
 		if(other == NULL){
 			output = NULL;
@@ -111,15 +252,67 @@ namespace XML{
 	}
 	
 //-----------------------------------OBJECT-----------------------------------------------//
-
-	Object::Object():parent(NULL), type(XML_OBJECT){}
-	Object::Object(const std::string& Name, Tag * Parent):name(Name), parent(Parent), type(XML_OBJECT){}
-	Object::Object(const Object& other):name(other.name), parent(other.parent), type(other.type){}
+	
+	//room in front of every object for the arena it came from
+	static const std::size_t ObjectHeaderSize = sizeof(Arena*);
+	
+	//The operators only call these, so every operator new is paired with the operator delete of the same form.
+	static void* AllocateObject(std::size_t size, Arena* arena){
+		void* block = (arena == NULL) ? ::operator new(size + ObjectHeaderSize) : arena->allocate(size + ObjectHeaderSize);
+		*(Arena**)block = arena;
+		return (char*)block + ObjectHeaderSize;
+	}
+	
+	static void DeallocateObject(void* p, std::size_t size){
+		if(p != NULL){
+			void* block = (char*)p - ObjectHeaderSize;
+			Arena* arena = *(Arena**)block;
+			if(arena == NULL){
+				::operator delete(block);
+			}else{
+				arena->deallocate(block, size + ObjectHeaderSize);
+			}
+		}
+	}
+	
+	void* Object::operator new(std::size_t size){
+		return AllocateObject(size, NULL);
+	}
+	
+	void* Object::operator new(std::size_t size, Arena* arena){
+		return AllocateObject(size, arena);
+	}
+	
+	void Object::operator delete(void* p, std::size_t size){
+		DeallocateObject(p, size);
+	}
+	
+	//only used if a constructor throws
+	void Object::operator delete(void* p, Arena* arena){
+		if(arena == NULL){
+			DeallocateObject(p, 0);
+		}
+	}
+	
+	Object::Object():type(XML_OBJECT), parent(NULL){}
+	Object::Object(const std::string& Name, Tag * Parent):type(XML_OBJECT), parent(Parent), name(Name){}
+	Object::Object(const Object& other):type(other.type), parent(other.parent), name(other.name){}
+	
+	Object& Object::operator=(const Object& other){
+		type = other.type;
+		parent = other.parent;
+		name = other.name;
+		return *this;
+	}
 	
 	std::ostream& Object::writeToStream(std::ostream& os) const{
 		return os << name;
 	}
 	
+	void Object::writeToBuffer(OutputBuffer& output) const{
+		output.write(name);
+	}
+	
 	std::ostream& operator<<(std::ostream& os, const XML::Object& obj){
 		return obj.writeToStream(os);
 	}
@@ -127,7 +320,7 @@ namespace XML{
 	Object* Object::copy() const{
 		return new Object(*this);
 	}
-
+	
 //-----------------------------------STRING-----------------------------------------------//
 	
 	String::String():XML::Object(){}
@@ -136,6 +329,26 @@ namespace XML{
 	}
 	String::String(const String& other):Object(other){}
 	
+	String& String::operator=(const String& other){
+		Object::operator=(other);
+		return *this;
+	}
+	
+#ifdef XML_CPP11
+	String::String(String&& other):Object(){
+		type = XML_STRING;
+		name.swap(other.name);
+	}
+	
+	String& String::operator=(String&& other){
+		if(this != &other){
+			name.swap(other.name);
+			other.name.clear();
+		}
+		return *this;
+	}
+#endif
+	
 	String* String::copy() const{
 		return new String(*this);
 	}
@@ -151,7 +364,258 @@ namespace XML{
 	}
 	
 	std::ostream& String::writeToStream(std::ostream& os) const{
-		return os << XML::EscapeString(name);
+		OutputBuffer output(os);
+		writeToBuffer(output);
+		return os;
+	}
+	
+	void String::writeToBuffer(OutputBuffer& output) const{
+		output.writeEscaped(name);
+	}
+	
+//-----------------------------------SHARED NAME-----------------------------------------------//
+	
+	struct SharedName::Shared{
+#ifdef XML_CPP11
+		std::atomic<unsigned int> references;
+#else
+		unsigned int references;
+#endif
+		const std::string text;
+		
+		Shared(const char* Text, std::size_t length):references(1), text(Text, length){}
+	};
+	
+	static const std::string EmptyName;
+	
+	SharedName::SharedName(const std::string& text):shared(new Shared(text.data(), text.length())){}
+	
+	SharedName::SharedName(const char* text, std::size_t length):shared(new Shared(text, length)){}
+	
+	SharedName::SharedName(const SharedName& other):shared(other.shared){
+		if(shared != NULL){
+			++shared->references;
+		}
+	}
+	
+	SharedName::~SharedName(){
+		if(shared != NULL && --shared->references == 0){
+			delete shared;
+		}
+	}
+	
+	SharedName& SharedName::operator=(const SharedName& other){
+		SharedName copy(other);
+		swap(copy);
+		return *this;
+	}
+	
+	const std::string& SharedName::str() const{
+		return (shared == NULL) ? EmptyName : shared->text;
+	}
+	
+//-----------------------------------ATTRIBUTES-----------------------------------------------//
+	
+	Attributes::Attributes():items(NULL), used(0), capacity(InlineCapacity){
+		items = inlineItems();
+	}
+	
+	Attributes::Attributes(const Attributes& other):items(NULL), used(0), capacity(InlineCapacity){
+		items = inlineItems();
+		*this = other;
+	}
+	
+	Attributes::Attributes(const std::map<std::string, std::string>& other):items(NULL), used(0), capacity(InlineCapacity){
+		items = inlineItems();
+		reserve(other.size());
+		for(std::map<std::string, std::string>::const_iterator it = other.begin(); it != other.end(); ++it){
+			new (items + used) value_type(*it);
+			++used;
+		}
+	}
+	
+	Attributes::~Attributes(){
+		clear();
+		if(items != inlineItems()){
+			::operator delete(items);
+		}
+	}
+	
+	Attributes& Attributes::operator=(const Attributes& other){
+		if(this != &other){
+			clear();
+			reserve(other.used);
+			for(unsigned int i = 0; i < other.used; ++i){
+				new (items + i) value_type(other.items[i]);
+			}
+			used = other.used;
+		}
+		return *this;
+	}
+	
+#ifdef XML_CPP11
+	Attributes::Attributes(Attributes&& other):items(NULL), used(0), capacity(InlineCapacity){
+		items = inlineItems();
+		take(other);
+	}
+	
+	Attributes& Attributes::operator=(Attributes&& other){
+		if(this != &other){
+			clear();
+			if(items != inlineItems()){
+				::operator delete(items);
+				items = inlineItems();
+				capacity = InlineCapacity;
+			}
+			take(other);
+		}
+		return *this;
+	}
+	
+	void Attributes::take(Attributes& other){
+		if(other.items != other.inlineItems()){
+			items = other.items;
+			used = other.used;
+			capacity = other.capacity;
+			other.items = other.inlineItems();
+			other.used = 0;
+			other.capacity = InlineCapacity;
+		}else{
+			for(unsigned int i = 0; i < other.used; ++i){
+				new (items + i) value_type();
+				items[i].first.swap(other.items[i].first);
+				items[i].second.swap(other.items[i].second);
+			}
+			used = other.used;
+			other.clear();
+		}
+	}
+#endif
+	
+	void Attributes::clear(){
+		while(used > 0){
+			items[--used].~value_type();
+		}
+	}
+	
+	void Attributes::reserve(std::size_t size){
+		if(size > capacity){
+			grow(size);
+		}
+	}
+	
+	void Attributes::grow(std::size_t size){
+		std::size_t newCapacity = capacity * 2;
+		if(newCapacity < size){
+			newCapacity = size;
+		}
+		value_type* grown = (value_type*)::operator new(newCapacity * sizeof(value_type));
+		for(unsigned int i = 0; i < used; ++i){
+			new (grown + i) value_type();
+			grown[i].first.swap(items[i].first);
+			grown[i].second.swap(items[i].second);
+			items[i].~value_type();
+		}
+		if(items != inlineItems()){
+			::operator delete(items);
+		}
+		items = grown;
+		capacity = newCapacity;
+	}
+	
+	std::string& Attributes::value(const char* name, std::size_t length){
+		for(unsigned int i = 0; i < used; ++i){
+			if(items[i].first.length() == length && memcmp(items[i].first.data(), name, length) == 0){
+				return items[i].second;
+			}
+		}
+		if(used == capacity){
+			grow(used + 1);
+		}
+		value_type* attribute = new (items + used) value_type(SharedName(name, length), std::string());
+		++used;
+		return attribute->second;
+	}
+	
+	std::string& Attributes::value(const SharedName& name){
+		for(unsigned int i = 0; i < used; ++i){
+			if(items[i].first == name){
+				return items[i].second;
+			}
+		}
+		if(used == capacity){
+			grow(used + 1);
+		}
+		value_type* attribute = new (items + used) value_type(name, std::string());
+		++used;
+		return attribute->second;
+	}
+	
+	std::string& Attributes::operator[](const std::string& name){
+		return value(name.data(), name.length());
+	}
+	
+	Attributes::iterator Attributes::find(const std::string& name){
+		for(unsigned int i = 0; i < used; ++i){
+			if(items[i].first == name){
+				return items + i;
+			}
+		}
+		return end();
+	}
+	
+	Attributes::const_iterator Attributes::find(const std::string& name) const{
+		return const_cast<Attributes*>(this)->find(name);
+	}
+	
+	const std::string* Attributes::get(const std::string& name) const{
+		const_iterator it = find(name);
+		return (it == end()) ? NULL : &it->second;
+	}
+	
+	std::pair<Attributes::iterator, bool> Attributes::insert(const value_type& attribute){
+		iterator it = find(attribute.first);
+		if(it != end()){
+			return std::pair<iterator, bool>(it, false);
+		}
+		if(used == capacity){
+			grow(used + 1);
+		}
+		new (items + used) value_type(attribute);
+		return std::pair<iterator, bool>(items + used++, true);
+	}
+	
+	std::size_t Attributes::erase(const std::string& name){
+		iterator it = find(name);
+		if(it == end()){
+			return 0;
+		}
+		erase(it);
+		return 1;
+	}
+	
+	void Attributes::erase(iterator position){
+		for(iterator it = position; it + 1 != end(); ++it){
+			it->first.swap((it + 1)->first);
+			it->second.swap((it + 1)->second);
+		}
+		items[--used].~value_type();
+	}
+	
+	bool Attributes::operator==(const Attributes& other) const{
+		if(used != other.used){
+			return false;
+		}
+		for(unsigned int i = 0; i < used; ++i){
+			if(items[i] != other.items[i]){
+				return false;
+			}
+		}
+		return true;
+	}
+	
+	Attributes::operator std::map<std::string, std::string>() const{
+		return std::map<std::string, std::string>(begin(), end());
 	}
 	
 //-----------------------------------TAG-----------------------------------------------//
@@ -160,23 +624,68 @@ namespace XML{
 		if(deleteChildTagsOnDestruction){
 			clearChildren();
 		}
+		invalidateIndex();
 	}
 	
-	Tag::Tag():XML::Object(), deleteChildTagsOnDestruction(true){
+	Tag::Tag():XML::Object(), selfClosing(false), deleteChildTagsOnDestruction(true), atom(NoAtom), arena(NULL), atoms(NULL), index(NULL){
 		type = XML_TAG;
 	}
 	
-	Tag::Tag(const std::string& Name, Tag* Parent):XML::Object(Name,Parent), deleteChildTagsOnDestruction(true){
+	Tag::Tag(const std::string& Name, Tag* Parent):XML::Object(Name,Parent), selfClosing(false), deleteChildTagsOnDestruction(true), atom(NoAtom), arena(NULL), atoms(NULL), index(NULL){
 		type = XML_TAG;
 	}
 	
-	Tag::Tag(const Tag& other):XML::Object(other), deleteChildTagsOnDestruction(true){
+	Tag::Tag(const Tag& other):XML::Object(other), selfClosing(other.selfClosing), deleteChildTagsOnDestruction(true), atom(NoAtom), arena(NULL), atoms(NULL), index(NULL){
 		this->attributes = other.attributes;
 		for(unsigned int i = 0; i < other.children.size(); ++i){
 			this->children.push_back(XML::Copy(other.children[i]));
 		}
 	}
 	
+	Tag& Tag::operator=(const Tag& other){
+		XML::Object::operator=(other);
+		attributes = other.attributes;
+		selfClosing = other.selfClosing;
+		children = other.children;
+		deleteChildTagsOnDestruction = other.deleteChildTagsOnDestruction;
+		arena = other.arena;
+		atoms = other.atoms;
+		atom = other.atom;
+		invalidateIndex();
+		return *this;
+	}
+	
+#ifdef XML_CPP11
+	Tag::Tag(Tag&& other):XML::Object(), attributes(std::move(other.attributes)), children(std::move(other.children)), selfClosing(other.selfClosing), deleteChildTagsOnDestruction(other.deleteChildTagsOnDestruction), atom(other.atom), arena(other.arena), atoms(other.atoms), index(other.index.exchange(NULL)){
+		type = XML_TAG;
+		name.swap(other.name);
+		other.children.clear();
+		for(unsigned int i = 0; i < children.size(); ++i){
+			children[i]->parent = this;
+		}
+	}
+	
+	Tag& Tag::operator=(Tag&& other){
+		if(this != &other){
+			clearChildren();
+			name.swap(other.name);
+			other.name.clear();
+			attributes = std::move(other.attributes);
+			selfClosing = other.selfClosing;
+			children.swap(other.children);
+			deleteChildTagsOnDestruction = other.deleteChildTagsOnDestruction;
+			arena = other.arena;
+			atoms = other.atoms;
+			atom = other.atom;
+			index = other.index.exchange(NULL);
+			for(unsigned int i = 0; i < children.size(); ++i){
+				children[i]->parent = this;
+			}
+		}
+		return *this;
+	}
+#endif
+	
 	Tag* Tag::copy() const{
 		return new Tag(*this);
 	}
@@ -191,16 +700,52 @@ namespace XML{
 			obj = children.back();
 		}else{
 			children.push_back(obj);
+			ChildIndex* current = index;
+			if(current != NULL && (current->size() + 1 != children.size() || !current->add(children, children.size() - 1))){
+				invalidateIndex();
+			}
 		}
 		return obj;                
 	}
 	
+#ifdef XML_CPP11
+	Tag* Tag::addChild(Tag&& child){
+		return (Tag*)addChild(new (arena) Tag(std::move(child)));
+	}
+	
+	String* Tag::addChild(String&& child){
+		return (String*)addChild(new (arena) String(std::move(child)));
+	}
+#endif
+	
+	XML::Object* Tag::releaseChild(unsigned int position){
+		if(position >= children.size()){
+			return NULL;
+		}
+		XML::Object* child = children[position];
+		children.erase(children.begin() + position);
+		child->parent = NULL;
+		invalidateIndex();
+		return child;
+	}
+	
 	String* Tag::addChildString(const std::string& value){
-		return (String*)addChild(new String(value, this));
+		return (String*)addChild(new (arena) String(value, this));
 	}
 	
 	Tag* Tag::addChildTag(const std::string& childName){
-		return (Tag*)addChild(new Tag(childName, this));
+		Tag* child = new (arena) Tag(childName, this);
+		child->arena = arena;
+		child->atoms = atoms;
+		if(atoms != NULL){
+			child->atom = atoms->intern(childName);
+		}
+		return (Tag*)addChild(child);
+	}
+	
+	void Tag::setName(const std::string& Name){
+		name = Name;
+		atom = (atoms == NULL) ? NoAtom : atoms->intern(name);
 	}
 	
 	std::string& Tag::firstText(){
@@ -210,8 +755,9 @@ namespace XML{
 			if(children[0]->getType() == XML_STRING){
 				return children[0]->name;
 			}else{
-				String* newStr = new String("",this);
+				String* newStr = new (arena) String("",this);
 				children.insert(children.begin(),newStr);
+				invalidateIndex();
 				return newStr->name;
 			}
 		}
@@ -232,12 +778,121 @@ namespace XML{
 			}
 		}
 		children.clear();
+		invalidateIndex();
 	}
 	
 	void Tag::clear(){
 		name.clear();
 		clearChildren();
 		attributes.clear();
+		selfClosing = false;
+	}
+	
+	void Tag::invalidateIndex(){
+		ChildIndex* current = index;
+		index = NULL;
+		delete current;
+	}
+	
+	void Tag::buildIndex() const{
+		currentIndex();
+	}
+	
+	//Replace the index if it is still expected, otherwise set expected to the index another thread put there.
+#ifdef XML_CPP11
+	static bool PublishIndex(std::atomic<ChildIndex*>& index, ChildIndex*& expected, ChildIndex* replacement){
+		return index.compare_exchange_strong(expected, replacement);
+	}
+#else
+	static bool PublishIndex(ChildIndex*& index, ChildIndex*& expected, ChildIndex* replacement){
+		if(index != expected){
+			expected = index;
+			return false;
+		}
+		index = replacement;
+		return true;
+	}
+#endif
+	
+	const ChildIndex* Tag::currentIndex(const ChildIndex* stale) const{
+		if(children.size() < IndexThreshold){
+			return NULL;
+		}
+		ChildIndex* current = index;
+		if(current != NULL && current != stale && current->size() == children.size()){
+			return current;
+		}
+		//built on the side, so other threads reading the tag see either the old index or the whole new one
+		ChildIndex* built = new ChildIndex();
+		built->build(children, atoms);
+		built->previous = current;
+		if(!PublishIndex(index, current, built)){
+			built->previous = NULL;
+			delete built;
+			return (current != NULL && current != stale && current->size() == children.size()) ? current : NULL;
+		}
+		return built;
+	}
+	
+	unsigned int Tag::firstPositionWithName(const std::string& childName) const{
+		const ChildIndex* lookup = currentIndex();
+		if(lookup != NULL){
+			unsigned int position = lookup->first(childName, children);
+			if(position == ChildIndex::Stale && (lookup = currentIndex(lookup)) != NULL){
+				position = lookup->first(childName, children);
+			}
+			if(position != ChildIndex::Stale){
+				return (position == ChildIndex::NoChild) ? children.size() : position;
+			}
+		}
+		unsigned int i = 0;
+		while(i < children.size() && (children[i]->getType() != XML_TAG || children[i]->name != childName)){
+			++i;
+		}
+		return i;
+	}
+	
+	unsigned int Tag::firstPositionWithName(Atom childAtom) const{
+		const ChildIndex* lookup = currentIndex();
+		if(lookup != NULL && atoms != NULL){
+			unsigned int position = lookup->first(childAtom, children);
+			if(position == ChildIndex::Stale && (lookup = currentIndex(lookup)) != NULL){
+				position = lookup->first(childAtom, children);
+			}
+			if(position != ChildIndex::Stale){
+				return (position == ChildIndex::NoChild) ? children.size() : position;
+			}
+		}
+		unsigned int i = 0;
+		while(i < children.size() && (children[i]->getType() != XML_TAG || ((Tag*)children[i])->atom != childAtom)){
+			++i;
+		}
+		return i;
+	}
+	
+	unsigned int Tag::nextPositionWithName(unsigned int position) const{
+		const ChildIndex* lookup = currentIndex();
+		if(lookup != NULL){
+			unsigned int next = lookup->next(position, children);
+			if(next == ChildIndex::Stale && (lookup = currentIndex(lookup)) != NULL){
+				next = lookup->next(position, children);
+			}
+			if(next != ChildIndex::Stale){
+				return (next == ChildIndex::NoChild) ? children.size() : next;
+			}
+		}
+		const Tag* previous = (Tag*)children[position];
+		unsigned int i = position + 1;
+		if(previous->atom != NoAtom){ //children with atoms are compared by them
+			while(i < children.size() && (children[i]->getType() != XML_TAG || ((Tag*)children[i])->atom != previous->atom)){
+				++i;
+			}
+		}else{
+			while(i < children.size() && (children[i]->getType() != XML_TAG || children[i]->name != previous->name)){
+				++i;
+			}
+		}
+		return i;
 	}
 	
 	Tag* Tag::childWithName(const std::string& childName){
@@ -245,15 +900,25 @@ namespace XML{
 	}
 	
 	const Tag* Tag::childWithName(const std::string& childName) const{
-		for(unsigned int i = 0; i < children.size(); ++i){
-			if(children[i]->getType() == XML_TAG && children[i]->name == childName){
-				return (Tag*)children[i];
-			}
-		}
-		return NULL;
+		const unsigned int position = firstPositionWithName(childName);
+		return (position < children.size()) ? (Tag*)children[position] : NULL;
 	}
 	
 	Tag* Tag::lastChildWithName(const std::string& childName){
+		return const_cast<Tag*>(static_cast<const Tag*>(this)->lastChildWithName(childName));
+	}
+	
+	const Tag* Tag::lastChildWithName(const std::string& childName) const{
+		const ChildIndex* lookup = currentIndex();
+		if(lookup != NULL){
+			unsigned int position = lookup->last(childName, children);
+			if(position == ChildIndex::Stale && (lookup = currentIndex(lookup)) != NULL){
+				position = lookup->last(childName, children);
+			}
+			if(position != ChildIndex::Stale){
+				return (position == ChildIndex::NoChild) ? NULL : (Tag*)children[position];
+			}
+		}
 		unsigned int sz = children.size();
 		while(sz-- > 0){
 			if(children[sz]->getType() == XML_TAG && children[sz]->name == childName){
@@ -262,23 +927,58 @@ namespace XML{
 		}
 		return NULL;
 	}
-		
-	const Tag* Tag::lastChildWithName(const std::string& childName) const{
-		return lastChildWithName(childName);
+	
+	NamedChildren Tag::childrenWithName(const std::string& childName) const{
+		return NamedChildren(this, firstPositionWithName(childName), children.size());
 	}
 	
-	std::vector<Tag*> Tag::childrenWithName(const std::string& childName){
-		std::vector<Tag*> output;
-		for(unsigned int i = 0; i < children.size(); ++i){
-			if(children[i]->getType() == XML_TAG && children[i]->name == childName){
-				output.push_back((Tag*)children[i]);
+	Tag* Tag::childWithName(Atom childAtom){
+		return const_cast<Tag*>(static_cast<const Tag*>(this)->childWithName(childAtom));
+	}
+	
+	const Tag* Tag::childWithName(Atom childAtom) const{
+		const unsigned int position = firstPositionWithName(childAtom);
+		return (position < children.size()) ? (Tag*)children[position] : NULL;
+	}
+	
+	Tag* Tag::lastChildWithName(Atom childAtom){
+		return const_cast<Tag*>(static_cast<const Tag*>(this)->lastChildWithName(childAtom));
+	}
+	
+	const Tag* Tag::lastChildWithName(Atom childAtom) const{
+		const ChildIndex* lookup = currentIndex();
+		if(lookup != NULL && atoms != NULL){
+			unsigned int position = lookup->last(childAtom, children);
+			if(position == ChildIndex::Stale && (lookup = currentIndex(lookup)) != NULL){
+				position = lookup->last(childAtom, children);
+			}
+			if(position != ChildIndex::Stale){
+				return (position == ChildIndex::NoChild) ? NULL : (Tag*)children[position];
 			}
 		}
-		return output;
+		unsigned int sz = children.size();
+		while(sz-- > 0){
+			if(children[sz]->getType() == XML_TAG && ((Tag*)children[sz])->atom == childAtom){
+				return (Tag*)children[sz];
+			}
+		}
+		return NULL;
+	}
+	
+	NamedChildren Tag::childrenWithName(Atom childAtom) const{
+		return NamedChildren(this, firstPositionWithName(childAtom), children.size());
+	}
+	
+	std::size_t NamedChildren::size() const{
+		std::size_t count = 0;
+		for(iterator it = begin(); it != end(); ++it){
+			++count;
+		}
+		return count;
 	}
 	
-	const std::vector<Tag*> Tag::childrenWithName(const std::string& childName) const{
-		return childrenWithName(childName);
+	NamedChildren::operator std::vector<Tag*>() const{
+		return std::vector<Tag*>(begin(), end());
 	}
 	
 	std::vector<XML::String*> Tag::stringChildren(){
@@ -291,7 +991,7 @@ namespace XML{
 		return output;
 	}
 	const std::vector<String*> Tag::stringChildren() const{
-		return stringChildren();
+		return const_cast<Tag*>(this)->stringChildren();
 	}
 	
 	void Tag::addChildrenFromTag(XML::Tag* other){
@@ -312,226 +1012,331 @@ namespace XML{
 	}
 	
 	std::ostream& Tag::writeAttributes(std::ostream& os) const{
-		for(std::map<std::string, std::string>::const_iterator it = attributes.begin(); it != attributes.end(); ++it){
-			if(it->first != "/"){
-				os << ' ' << it->first;
-				if(!it->second.empty()){
-					os << "=\"" << it->second << '"';
-				}
+		OutputBuffer output(os);
+		writeAttributes(output);
+		return os;
+	}
+	
+	void Tag::writeAttributes(OutputBuffer& output) const{
+		for(Attributes::const_iterator it = attributes.begin(); it != attributes.end(); ++it){
+			output.put(' ');
+			output.write(it->first);
+			if(!it->second.empty()){
+				output.write("=\"", 2);
+				output.write(it->second);
+				output.put('"');
 			}
 		}
-		return os;
 	}
 	
 	std::ostream& Tag::writeChildren(std::ostream& os) const{
+		OutputBuffer output(os);
+		writeChildren(output);
+		return os;
+	}
+	
+	void Tag::writeChildren(OutputBuffer& output) const{
 		for(unsigned int i = 0; i < children.size(); ++i){
 			switch(children[i]->getType()){
 				case XML_TAG:
-					os << *((Tag*)children[i]);
+					((Tag*)children[i])->writeToBuffer(output);
 					break;
 				case XML_STRING:
-					os << *((String*)children[i]);
+					output.writeEscaped(children[i]->name);
 					break;
 				default:
-					os << *children[i];
+					children[i]->writeToBuffer(output);
 			}
 		}
-		return os;
 	}
 	
 	std::ostream& Tag::writeToStream(std::ostream& os) const{
+		OutputBuffer output(os);
+		writeToBuffer(output);
+		return os;
+	}
+	
+	void Tag::writeToBuffer(OutputBuffer& output) const{
 		//name
-		os << '<' << name;
+		output.put('<');
+		output.write(name);
 		//attributes
-		writeAttributes(os);
+		writeAttributes(output);
 		
 		if(children.size() == 0){ //close self
-			os << " />";
+			output.write(" />", 3);
 		}else{
-			os << '>';
+			output.put('>');
 			//children
-			writeChildren(os);
-			os << "</" << name << '>';
+			writeChildren(output);
+			output.write("</", 2);
+			output.write(name);
+			output.put('>');
 		}
-		
-		return os;
 	}
 	
-	//Read the start tag
-	//ie. "<name attr1="val1" ...>"
-	//or "name attr1="val1" ...>"
-	Tag* ReadStartTag(Tag* output, std::istream& is, char startingChar = '\0'){
-		if(output == NULL){
-			output = new Tag();
-		}else{
-			output->clear();
+//-----------------------------------PARSER-----------------------------------------------//
+	
+	//Reads tokens from a stream one at a time, so nothing after the last token is consumed.
+	//The stream buffer is used directly to avoid the cost of a sentry per character.
+	class StreamSource{
+	public:
+		//If startingChar != '\0' the stream is assumed to be just after "<startingChar".
+		StreamSource(std::istream& Is, char startingChar):is(Is), prefixed(startingChar != '\0'){
+			if(prefixed){
+				window.push_back('<');
+				window.push_back(startingChar);
+			}
 		}
 		
-		char c = '\0';
-		//Remove Leading Spaces
-		if(startingChar != '\0'){
-			output->name.push_back(startingChar);
-		}else{
-			while(is.get(c) && c != '<'){}
-		}
-
-		bool tag_done = false;
-		//get name
-		while(is.get(c)){
-			if(c == ' '){
-				break;
-			}else if(c == '>'){
-				break;
-			}else if(c == '/'){
-				is.get(c);
-				if(c == '>'){
-					tag_done = true;
-					break;
-				}else if(c == ' '){
-					break;
-				}else{
-					output->name.push_back('/');
-					output->name.push_back(c);
-				}
-			}else{
-				output->name.push_back(c);
+		Lexer::Token next(Lexer& lexer){
+			Lexer::Token token = lexer.next();
+			while(token == Lexer::TOKEN_NONE && readToken()){
+				lexer.reset(window.data(), window.data() + window.length());
+				token = lexer.next();
 			}
+			return token;
 		}
 		
-		//check for attributes
-		if(!output->name.empty() && !tag_done){
+	private:
+		typedef std::char_traits<char> traits;
+		
+		std::istream& is;
+		std::string window;
+		bool prefixed;
+		
+		bool readToken();
+		bool readMarkup(std::streambuf* sb);
+	};
+	
+	bool StreamSource::readToken(){
+		std::streambuf* sb = is.rdbuf();
+		if(prefixed){
+			prefixed = false;
+			return readMarkup(sb);
+		}
+		window.clear();
+		int c = (sb == NULL) ? traits::eof() : sb->sgetc();
+		if(c == traits::eof()){
+			is.setstate(std::ios::eofbit);
+			return false;
+		}else if(c != '<'){ //text up to the next '<'
 			do{
-				if(c == '>'){
-					break;
-				}else if(c == ' '){
-					
-				}else{ //extract attribute
-					if(is.peek() == '>'){
-						if(c=='?'){
-							break;
-						}else if(c=='/'){
-							tag_done = true;
-							is.get(c);
-							break;
-						}
-					}
-					
-					std::string attributeName;
-					std::string attributeValue;
-					attributeName.push_back(c);
-					while(is.get(c)){
-						if(c == '='){
-							if(is.get(c) && c == '"'){
-								while(is.get(c) && c != '"'){
-									attributeValue.push_back(c);
-								}
-								break;
-							}else{
-								break;
-							}
-						}else if(c ==' '){
-							if(!attributeName.empty()){
-								break;
-							}
-						}else if(c=='>'){
-							break;
-						}else{
-							attributeName.push_back(c);
-						}
-					}
-					if(!attributeName.empty()){
-						output->attributes[attributeName] = attributeValue;
-					}
+				window.push_back((char)c);
+				c = sb->snextc();
+			}while(c != traits::eof() && c != '<');
+			return true;
+		}
+		window.push_back('<');
+		sb->sbumpc();
+		return readMarkup(sb);
+	}
+	
+	//Read the rest of a markup token, the window must already start with '<'.
+	bool StreamSource::readMarkup(std::streambuf* sb){
+		char quote = '\0';
+		char previous = '\0';
+		int depth = 0;
+		int c;
+		while((c = sb->sbumpc()) != traits::eof()){
+			window.push_back((char)c);
+			const char* w = window.data();
+			const std::size_t n = window.length();
+			if(w[1] == '!'){
+				if(n >= 4 && memcmp(w, "<!--", 4) == 0){
+					if(n >= 7 && memcmp(w + n - 3, "-->", 3) == 0)	return true;
+				}else if(n >= 9 && memcmp(w, "<![CDATA[", 9) == 0){
+					if(n >= 12 && memcmp(w + n - 3, "]]>", 3) == 0)	return true;
+				}else if(c == '['){
+					++depth;
+				}else if(c == ']'){
+					--depth;
+				}else if(c == '>' && depth <= 0){
+					return true;
 				}
-			}while(c != '>' && is.get(c));
+			}else if(w[1] == '?'){
+				if(c == '>' && n >= 4 && w[n-2] == '?')	return true;
+			}else if(quote != '\0'){
+				if(c == quote)	quote = '\0';
+			}else if((c == '"' || c == '\'') && previous == '='){
+				quote = (char)c;
+			}else if(c == '>'){
+				return true;
+			}
+			if(!IsSpace((char)c)){
+				previous = (char)c;
+			}
 		}
-		
-		if(tag_done){
-			output->attributes["/"] = "";
+		is.setstate(std::ios::eofbit);
+		return true;
+	}
+	
+	void AddText(Tag* tag, const Span& text, bool deEscape){
+		XML::Object* last = tag->children.empty() ? NULL : tag->children.back();
+		if(last == NULL || last->getType() != XML_STRING){
+			last = new (tag->arena) String(std::string(), tag);
+			tag->children.push_back(last);
+		}
+		if(deEscape){
+			AppendDeEscaped(last->name, text.begin, text.end);
+		}else{
+			last->name.append(text.begin, text.end);
 		}
-		
-		return output;
 	}
 	
-	Tag* ReadStartTag(std::istream& is, char startingChar = '\0'){
-		return ReadStartTag(NULL, is, startingChar);
+	void SetName(Tag* tag, const Span& name){
+		tag->name.assign(name.begin, name.end);
+		if(tag->atoms != NULL){
+			tag->atom = tag->atoms->intern(name.begin, name.end - name.begin);
+		}
 	}
 	
-	//assumes the next data in the stream is in the form -> "tagName>....."
-	bool ReadEndTag(std::istream& is, const std::string& tagName, std::string& red){
-		char c;
-		unsigned int i = 0;
-		red.clear();
-		while(is.get(c)){
-			red.push_back(c);
-			if(i == tagName.length()){
-				if(c=='>')	break;
-				else return false;
-			}else if(c != tagName[i++]){
-				return false;
-			}
+	void SetAttributes(Tag* tag, const Lexer& lexer){
+		tag->attributes.reserve(lexer.attributes.size());
+		for(unsigned int i = 0; i < lexer.attributes.size(); ++i){
+			const std::pair<Span, Span>& attribute = lexer.attributes[i];
+			const std::size_t length = attribute.first.end - attribute.first.begin;
+			std::string& value = (tag->atoms == NULL) ? tag->attributes.value(attribute.first.begin, length) : tag->attributes.value(tag->atoms->shared(tag->atoms->intern(attribute.first.begin, length)));
+			value.assign(attribute.second.begin, attribute.second.end);
 		}
-		return true;
+		tag->selfClosing = lexer.selfClosing;
 	}
 	
-	//Read the internal content of the tag, starting after the begin tag <name>... and requires that the provided tag has a name set.
-	void ReadInnerTag(std::istream& is, Tag* tag){
-		if(!tag->name.empty()){
-			std::string tmp;
-			char c;
-			while(std::getline(is,tmp,'<')){
-				tag->addChildString(DeEscapeString(tmp));
-				
-				//check if this is the end tag
-				if(is.get(c)){
-					if(c == '/'){
-						if(ReadEndTag(is,tag->name, tmp)){
-							break;
-						}else{
-							tag->addChildString(DeEscapeString(tmp));
-						}
-					}else{ //this is the start of an inner tag.
-						Tag * newTag = Tag::FromStream(is,c);
-						if(newTag != NULL){
-							tag->addChild(newTag);
-						}
-					}
+	void BuildIndexes(const Tag* top){
+		std::vector<const Tag*> open(1, top);
+		while(!open.empty()){
+			const Tag* tag = open.back();
+			open.pop_back();
+			tag->buildIndex();
+			for(unsigned int i = 0; i < tag->children.size(); ++i){
+				if(tag->children[i]->getType() == XML_TAG){
+					open.push_back((const Tag*)tag->children[i]);
 				}
 			}
 		}
 	}
 	
-	Tag* Tag::FromStream(Tag* output, std::istream& is,char startingChar, bool returnNull){
-		output = ReadStartTag(output, is, startingChar);
-		if(output->name.empty()){
-			if(returnNull){
-				delete output;
-				output = NULL;
-			}
+	//Read the first tag from the source, skipping anything before it.
+	template<class Source>
+	Tag* ReadTag(Tag* output, Source& source, Lexer& lexer, bool returnNull){
+		const bool created = (output == NULL);
+		if(created){
+			output = new Tag();
 		}else{
-			std::map<std::string, std::string>::iterator fnd = output->attributes.find("/");
-			if(fnd != output->attributes.end() && fnd->second.empty()){ //self closing tag
-				
-			}else{
-				ReadInnerTag(is,output);
+			output->clear();
+		}
+		
+		Lexer::Token token;
+		while((token = source.next(lexer)) != Lexer::TOKEN_NONE){
+			if(token == Lexer::TOKEN_START && !lexer.name.empty()){
+				SetName(output, lexer.name);
+				SetAttributes(output, lexer);
+				if(!lexer.selfClosing){
+					ReadContent(output, source, lexer);
+				}
+				return output;
 			}
 		}
+		
+		if(returnNull){
+			if(created)	delete output;
+			output = NULL;
+		}
 		return output;
 	}
 	
+	Tag* Tag::FromStream(Tag* output, std::istream& is, char startingChar, bool returnNull){
+		Lexer lexer;
+		StreamSource source(is, startingChar);
+		return ReadTag(output, source, lexer, returnNull);
+	}
+	
 	Tag* Tag::FromStream(std::istream& is,char startingChar, bool returnNull){
 		return Tag::FromStream(NULL,is,startingChar, returnNull);
 	}
 	
+	Tag* Tag::FromBuffer(Tag* output, const char* data, std::size_t length, bool returnNull){
+		Lexer lexer;
+		BufferSource source(lexer, data, data + length);
+		return ReadTag(output, source, lexer, returnNull);
+	}
+	
+	Tag* Tag::FromBuffer(const char* data, std::size_t length, bool returnNull){
+		return Tag::FromBuffer(NULL, data, length, returnNull);
+	}
+	
 	std::istream& operator>>(std::istream& is, Tag& output){
 		Tag::FromStream(&output,is);
 		return is;
 	}
 	
 //-----------------------------------DOCUMENT----------------------------------------------//
+
+#ifdef XML_CPP11
+	const bool Document::OwnedByDefault = true;
+#else
+	const bool Document::OwnedByDefault = false;
+#endif
+	
+	Document::Document():declaration(NULL), root(NULL), arena(NULL), atoms(NULL), deleteTagsOnDestruction(OwnedByDefault){}
+	
+	Document::Document(const Document& doc):declaration(doc.declaration), root(doc.root), arena(doc.arena), atoms(doc.atoms), deleteTagsOnDestruction(false){
+		if(doc.deleteTagsOnDestruction){
+			//tags of its own, on the heap
+			declaration = (doc.declaration == NULL) ? NULL : doc.declaration->copy();
+			root = (doc.root == NULL) ? NULL : doc.root->copy();
+			arena = NULL;
+			atoms = NULL;
+			deleteTagsOnDestruction = true;
+		}
+	}
+	
+	Document& Document::operator=(const Document& doc){
+		if(root != doc.root || declaration != doc.declaration){
+			//the old tags go with the copy, which deletes them if they were owned
+			Document copy(doc);
+			swap(copy);
+		}
+		return *this;
+	}
+	
+#ifdef XML_CPP11
+	Document::Document(Document&& doc):declaration(doc.declaration), root(doc.root), arena(doc.arena), atoms(doc.atoms), deleteTagsOnDestruction(doc.deleteTagsOnDestruction){
+		doc.declaration = NULL;
+		doc.root = NULL;
+		doc.arena = NULL;
+		doc.atoms = NULL;
+		doc.deleteTagsOnDestruction = false;
+	}
+	
+	Document& Document::operator=(Document&& doc){
+		if(root != doc.root || declaration != doc.declaration){
+			Document moved(std::move(doc));
+			swap(moved);
+		}else if(this != &doc){
+			//the same tags, which are owned if either of them owned them
+			deleteTagsOnDestruction = deleteTagsOnDestruction || doc.deleteTagsOnDestruction;
+			doc.deleteTagsOnDestruction = false;
+			Document empty;
+			doc.swap(empty);
+		}
+		return *this;
+	}
+#endif
+	
+	Document::~Document(){
+		if(deleteTagsOnDestruction){
+			deleteTags();
+		}
+	}
 	
-	Document::Document():declaration(NULL), root(NULL){}
-	Document::Document(const Document& doc):declaration(doc.declaration), root(doc.root){}
+	void Document::swap(Document& other){
+		std::swap(declaration, other.declaration);
+		std::swap(root, other.root);
+		std::swap(arena, other.arena);
+		std::swap(atoms, other.atoms);
+		std::swap(deleteTagsOnDestruction, other.deleteTagsOnDestruction);
+	}
 	
 	void Document::deleteTags(){
 		if(declaration != NULL){
@@ -542,9 +1347,18 @@ namespace XML{
 			delete root;
 			root = NULL;
 		}
+		//after the tags, which live in it
+		if(arena != NULL){
+			delete arena;
+			arena = NULL;
+		}
+		if(atoms != NULL){
+			delete atoms;
+			atoms = NULL;
+		}
 	}
 	
-	std::map<std::string,std::string>& Document::Declaration(){
+	Attributes& Document::Declaration(){
 		if(declaration == NULL){
 			createDeclaration();
 		}
@@ -553,7 +1367,10 @@ namespace XML{
 	
 	Tag* Document::createDeclaration(){
 		if(declaration == NULL){
-			declaration = new Tag("?xml");
+			declaration = new (arena) Tag("?xml");
+			declaration->arena = arena;
+			declaration->atoms = atoms;
+			declaration->setName("?xml");
 			declaration->attributes["version"] = "1.0";
 		}
 		return declaration;
@@ -562,7 +1379,10 @@ namespace XML{
 	
 	Tag* Document::createRoot(const std::string& rootName){
 		if(root == NULL){
-			root = new Tag(rootName);
+			root = new (arena) Tag(rootName);
+			root->arena = arena;
+			root->atoms = atoms;
+			root->setName(rootName);
 		}
 		return root;
 	}
@@ -572,46 +1392,76 @@ namespace XML{
 	}
 	
 	std::ostream& Document::writeToStream(std::ostream& os) const{
+		OutputBuffer output(os);
+		writeToBuffer(output);
+		return os;
+	}
+	
+	void Document::writeToBuffer(OutputBuffer& output) const{
 		if(declaration != NULL){
-			os << '<' << declaration->name;
+			output.put('<');
+			output.write(declaration->name);
 			//attributes
-			declaration->writeAttributes(os) << "?>";
+			declaration->writeAttributes(output);
+			output.write("?>", 2);
 		}
-		if(root->name == "_root"){
-			root->writeChildren(os);
+		if(root == NULL){ //a document which was never read or created
+			return;
+		}else if(root->name == "_root"){
+			root->writeChildren(output);
 		}else{
-			root->writeToStream(os);
+			root->writeToBuffer(output);
 		}
-		return os;
 	}
-
-	Document Document::FromStream(std::istream& is, const std::string& rootName){
+	
+	Document Document::FromBuffer(const char* data, std::size_t length, const std::string& rootName, bool useArena){
 		Document output;
+		if(useArena){
+			output.arena = new Arena(Arena::DefaultBlockSize, true, Arena::FirstBlockSize(length));
+		}
+		output.atoms = new AtomTable();
+		output.deleteTagsOnDestruction = Document::OwnedByDefault;
 		
 		//create root
-		output.root = new Tag(rootName);
+		output.createRoot(rootName);
 		
-		Tag * newTag = ReadStartTag(is);
-		if(newTag->name == "?xml"){
-			output.declaration = newTag;
-		}else if(!newTag->name.empty()){
-			output.createDeclaration();
-			ReadInnerTag(is,newTag);
-			output.root->addChild(newTag);
+		Lexer lexer;
+		BufferSource source(lexer, data, data + length);
+		if(ParseStatsEnabled()){
+			ReadDocumentWithStats(output, source, lexer, length);
 		}else{
-			delete newTag;
-		}
-		
-		while(newTag != NULL && !newTag->name.empty()){
-			newTag = Tag::FromStream(is);
-			if(newTag != NULL){
-				output.root->addChild(newTag);
-			}
+			ReadDocument(output, source, lexer);
 		}
 		
 		return output;
 	}
 	
+	Document Document::FromBuffer(const char* data, std::size_t length){
+		return Document::FromBuffer(data, length, "_root");
+	}
+	
+	//The whole stream is read into memory and parsed from there.
+	Document Document::FromStream(std::istream& is, const std::string& rootName, bool useArena){
+		std::string buffer;
+		char chunk[65536];
+		while(is.read(chunk, sizeof(chunk)) || is.gcount() > 0){
+			buffer.append(chunk, (std::size_t)is.gcount());
+		}
+		return Document::FromBuffer(buffer.data(), buffer.length(), rootName, useArena);
+	}
+	
+	Document Document::FromFile(const std::string& path, const std::string& rootName, bool useArena){
+		MappedFile file;
+		if(!file.open(path)){
+			return Document::FromBuffer("", 0, rootName, useArena);
+		}
+		return Document::FromBuffer(file.data(), file.size(), rootName, useArena);
+	}
+	
+	Document Document::FromFile(const std::string& path){
+		return Document::FromFile(path, "_root");
+	}
+	
 	Document Document::FromStream(std::istream& is){
 		return Document::FromStream(is,"_root");
 	}
@@ -624,4 +1474,4 @@ namespace XML{
 		output = XML::Document::FromStream(is);
 		return is;
 	}
-};
\ No newline at end of file
+};
\ No newline at end of file
@@ -5,6 +5,19 @@
 #include <iostream>
 #include <vector>
 #include <map>
+#include <iterator>
+#include <cstddef>
+
+//The library is C++98, features which need C++11 (threads) are only enabled when the compiler supports them.
+#if !defined(XML_CPP11) && (__cplusplus >= 201103L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201103L))
+#define XML_CPP11
+#endif
+
+#ifdef XML_CPP11
+#include <atomic>
+#include <memory>
+#include <utility>
+#endif
 
 namespace XML{
 	
@@ -12,10 +25,26 @@ namespace XML{
 	extern const unsigned int NumberOfEscapeCharacters;
 	extern const std::string escapeCharacters;
 	extern const std::string escapeStrings[];
+	//For every character, 0 if it is written as it is, otherwise 1 + the index of its escape string.
+	extern const unsigned char escapeIndex[256];
 	
 	std::string EscapeString(const std::string& str);
 	std::string DeEscapeString(const std::string& str);
 	
+	//Return str if there is nothing to change, without copying it, otherwise write the result to buffer and return it.
+	const std::string& EscapeString(const std::string& str, std::string& buffer);
+	const std::string& DeEscapeString(const std::string& str, std::string& buffer);
+	
+	//Append [begin,end) to output, replacing the characters which must be escaped with their escape strings.
+	void AppendEscaped(std::string& output, const char* begin, const char* end);
+	//Append [begin,end) to output, replacing escape strings and character references (&#65; or &#x41;) with their characters.
+	//Anything that is not a valid reference is kept as it is.
+	void AppendDeEscaped(std::string& output, const char* begin, const char* end);
+	
+	//Decode the text in place, which never makes it longer. Returns the new length.
+	std::size_t DeEscapeInPlace(char* data, std::size_t length);
+	void DeEscapeInPlace(std::string& str);
+	
 	//The different types of XML objects
 	enum XML_OBJECT_TYPE{
 		XML_OBJECT,
@@ -24,6 +53,16 @@ namespace XML{
 	};
 	
 	struct Tag;
+	class MappedFile;
+	class Arena;
+	class OutputBuffer;
+	class ChildIndex;
+	class NamedChildren;
+	class AtomTable;
+	
+	//The number of a name interned in an AtomTable.
+	typedef unsigned int Atom;
+	const Atom NoAtom = 0;
 	
 	//Base object
 	struct Object{
@@ -31,19 +70,27 @@ namespace XML{
 		XML_OBJECT_TYPE type;
 		
 	public:
-	
+		
 		Tag * parent;
 		std::string name;
 		
 		virtual ~Object(){}
 		
+		//Every object records the arena it was allocated from (NULL for the heap), so delete works for all of them.
+		static void* operator new(std::size_t size);
+		static void* operator new(std::size_t size, Arena* arena);
+		static void operator delete(void* p, std::size_t size);
+		static void operator delete(void* p, Arena* arena);
+		
 		Object();
 		Object(const std::string& Name, Tag * Parent = NULL);
 		Object(const Object& other);
+		Object& operator=(const Object& other);
 		
 		XML_OBJECT_TYPE getType() const{	return type;	}
 		
 		virtual std::ostream& writeToStream(std::ostream& os) const;
+		virtual void writeToBuffer(OutputBuffer& output) const;
 		
 		friend std::ostream& operator<<(std::ostream& os, const XML::Object& obj);
 		
@@ -60,6 +107,12 @@ namespace XML{
 		String();
 		String(const std::string& Name, Tag * Parent = NULL);
 		String(const String& other);
+		String& operator=(const String& other);
+#ifdef XML_CPP11
+		//Moving takes the text without copying it, the moved string has no parent.
+		String(String&& other);
+		String& operator=(String&& other);
+#endif
 		
 		virtual String* copy() const;
 		
@@ -67,6 +120,118 @@ namespace XML{
 		friend String operator+(String lhs, const String& rhs);
 		
 		virtual std::ostream& writeToStream(std::ostream& os) const;
+		virtual void writeToBuffer(OutputBuffer& output) const;
+	};
+	
+	//An immutable name shared by reference counting, so a name which repeats, like the key of an attribute, is stored once.
+	//It reads like a const std::string. With C++11 the count is atomic, so copies of one name can be used on several threads.
+	class SharedName{
+	public:
+		SharedName():shared(NULL){}
+		SharedName(const std::string& text);
+		SharedName(const char* text, std::size_t length);
+		SharedName(const SharedName& other);
+		~SharedName();
+		SharedName& operator=(const SharedName& other);
+		
+		const std::string& str() const;
+		operator const std::string&() const{	return str();	}
+		const char* data() const{	return str().data();	}
+		const char* c_str() const{	return str().c_str();	}
+		std::size_t length() const{	return str().length();	}
+		std::size_t size() const{	return str().length();	}
+		bool empty() const{	return str().empty();	}
+		
+		void swap(SharedName& other){	Shared* held = shared; shared = other.shared; other.shared = held;	}
+		
+		//Copies of one name compare without looking at the text.
+		bool operator==(const SharedName& other) const{	return shared == other.shared || str() == other.str();	}
+		bool operator!=(const SharedName& other) const{	return !(*this == other);	}
+		
+	private:
+		struct Shared;
+		Shared* shared;
+	};
+	
+	inline bool operator==(const SharedName& lhs, const std::string& rhs){	return lhs.str() == rhs;	}
+	inline bool operator==(const std::string& lhs, const SharedName& rhs){	return lhs == rhs.str();	}
+	inline bool operator==(const SharedName& lhs, const char* rhs){	return lhs.str() == rhs;	}
+	inline bool operator==(const char* lhs, const SharedName& rhs){	return lhs == rhs.str();	}
+	inline bool operator!=(const SharedName& lhs, const std::string& rhs){	return lhs.str() != rhs;	}
+	inline bool operator!=(const std::string& lhs, const SharedName& rhs){	return lhs != rhs.str();	}
+	inline bool operator!=(const SharedName& lhs, const char* rhs){	return lhs.str() != rhs;	}
+	inline bool operator!=(const char* lhs, const SharedName& rhs){	return lhs != rhs.str();	}
+	inline std::ostream& operator<<(std::ostream& os, const SharedName& name){	return os << name.str();	}
+	
+	//The attributes of a tag, kept in the order they were added.
+	//It has the interface of a std::map, but the attributes are stored in one array which is searched linearly,
+	//as tags rarely have more than a handful. The first InlineCapacity attributes do not allocate.
+	//The keys are shared names, tags read with atoms share the key interned in the AtomTable of their document.
+	class Attributes{
+	public:
+		typedef std::pair<SharedName, std::string> value_type;
+		typedef value_type* iterator;
+		typedef const value_type* const_iterator;
+		
+		static const unsigned int InlineCapacity = 1;
+		
+		Attributes();
+		Attributes(const Attributes& other);
+		Attributes(const std::map<std::string, std::string>& other);
+		~Attributes();
+		Attributes& operator=(const Attributes& other);
+#ifdef XML_CPP11
+		Attributes(Attributes&& other);
+		Attributes& operator=(Attributes&& other);
+#endif
+		
+		iterator begin(){	return items;	}
+		iterator end(){	return items + used;	}
+		const_iterator begin() const{	return items;	}
+		const_iterator end() const{	return items + used;	}
+		
+		std::size_t size() const{	return used;	}
+		bool empty() const{	return used == 0;	}
+		void clear();
+		void reserve(std::size_t size);
+		
+		//The value of the attribute, which is added at the end if it does not exist.
+		std::string& operator[](const std::string& name);
+		std::string& value(const char* name, std::size_t length);
+		std::string& value(const SharedName& name);
+		
+		iterator find(const std::string& name);
+		const_iterator find(const std::string& name) const;
+		std::size_t count(const std::string& name) const{	return (find(name) == end()) ? 0 : 1;	}
+		//The value of the attribute, NULL if it does not exist.
+		const std::string* get(const std::string& name) const;
+		
+		//Add the attribute at the end if it does not exist, like std::map::insert.
+		std::pair<iterator, bool> insert(const value_type& attribute);
+		//Remove the attribute, keeping the order of the others.
+		std::size_t erase(const std::string& name);
+		void erase(iterator position);
+		
+		bool operator==(const Attributes& other) const;
+		bool operator!=(const Attributes& other) const{	return !(*this == other);	}
+		
+		operator std::map<std::string, std::string>() const;
+		
+	private:
+		value_type* items;
+		unsigned int used;
+		unsigned int capacity;
+		union{
+			void* align;
+			char bytes[InlineCapacity * sizeof(value_type)];
+		} storage;
+		
+		value_type* inlineItems(){	return (value_type*)storage.bytes;	}
+		void grow(std::size_t size);
+#ifdef XML_CPP11
+		//Take the attributes of other, this must be empty and inline.
+		void take(Attributes& other);
+#endif
 	};
 	
 	//XML Tag
@@ -75,25 +240,61 @@ namespace XML{
 		typedef std::vector<XML::Object*> vec_type;
 		
 		//std::string content;
-		std::map<std::string, std::string> attributes;
+		Attributes attributes;
+		
 		//std::vector<Tag> children;
 		vec_type children;
+		//true if the tag was read as <name/>.
+		//Any tag without children is written that way.
+		bool selfClosing;
 		
 		virtual ~Tag();
 		
 		Tag();
 		Tag(const std::string& Name, Tag* Parent = NULL);
 		Tag(const Tag& other);
+		//Copies the members like the default assignment, the children are not copied.
+		Tag& operator=(const Tag& other);
+#ifdef XML_CPP11
+		//Moving takes the attributes and the children without copying them, which is O(1) for any tree.
+		//The moved tag has no parent. Assigning deletes the children the tag had, and keeps its parent.
+		//Children read with useArena stay in the arena of their document, so only move them within it.
+		Tag(Tag&& other);
+		Tag& operator=(Tag&& other);
+#endif
 		
 		virtual Tag* copy() const;
 		
 		//setting this bool determines if the children of this tag should be detroyed, true by default
 		bool deleteChildTagsOnDestruction;
+		//The atom of the name in atoms, NoAtom if the tag has no atom, next to the bools so they fill one word.
+		//Use setName to change the name of a tag which has one.
+		Atom atom;
+		
+		//The arena new children are allocated from, NULL to use the heap.
+		Arena* arena;
+		
+		//The table new children intern their names and attribute keys in, NULL to not use atoms.
+		AtomTable* atoms;
+		
+		//Set the name, and the atom if the tag uses atoms.
+		void setName(const std::string& Name);
 		
 		//Add children to the tag
 		XML::Object* addChild(XML::Object* obj);
 		String* addChildString(const std::string& value);
 		Tag* addChildTag(const std::string& childName);
+#ifdef XML_CPP11
+		//Add a new child which takes the content of the tag or the string, without copying it.
+		Tag* addChild(Tag&& child);
+		String* addChild(String&& child);
+		//Add a child owned by the caller, which then belongs to this tag.
+		template<class T>
+		T* addChild(std::unique_ptr<T> child){	return (T*)addChild((XML::Object*)child.release());	}
+#endif
+		
+		//Remove the child at position without destroying it, it then belongs to the caller, for instance to add to another tag.
+		XML::Object* releaseChild(unsigned int position);
 		
 		//If the first child is a string, return it, otherwise push a string to the front of the child list and return that.
 		std::string& firstText();
@@ -113,9 +314,28 @@ namespace XML{
 		Tag* lastChildWithName(const std::string& childName);
 		const Tag* lastChildWithName(const std::string& childName) const;
 		
-		//Get all children with the name
-		std::vector<Tag*> childrenWithName(const std::string& childName);
-		const std::vector<Tag*> childrenWithName(const std::string& childName) const;
+		//Get all children with the name, without copying them, this converts to a std::vector<Tag*>.
+		NamedChildren childrenWithName(const std::string& childName) const;
+		
+		//The same lookups by atom, comparing integers instead of strings.
+		//Only children with an atom, ie. read into a document or added with addChildTag, are found.
+		Tag* childWithName(Atom childAtom);
+		const Tag* childWithName(Atom childAtom) const;
+		Tag* lastChildWithName(Atom childAtom);
+		const Tag* lastChildWithName(Atom childAtom) const;
+		NamedChildren childrenWithName(Atom childAtom) const;
+		
+		//Lookups by name on a tag with at least IndexThreshold children use an index, which is built by the first lookup.
+		//When every child tag has an atom from atoms, the index holds the atoms, so lookups by atom never hash a name.
+		//addChild and clearChildren keep it up to date. It is built again when the number of children changes,
+		//or when a lookup finds another child, or another name, than it indexed at a position, so changing children directly never
+		//makes a lookup read a deleted child. A replaced child which no lookup reaches is not noticed, so call invalidateIndex after
+		//changing children or their names directly.
+		//With C++11 several threads can search the same tags, a new index is published with a compare and swap,
+		//and one it replaces is kept until the tag changes. Without C++11 call buildIndex first.
+		static const unsigned int IndexThreshold = 16;
+		void invalidateIndex();
+		void buildIndex() const;
 		
 		//return the children which are strings
 		std::vector<String*> stringChildren();
@@ -130,10 +350,14 @@ namespace XML{
 		
 		//Write the attributes to a stream
 		std::ostream& writeAttributes(std::ostream& os) const;
+		void writeAttributes(OutputBuffer& output) const;
 		//Write the children to a stream
 		std::ostream& writeChildren(std::ostream& os) const;
+		void writeChildren(OutputBuffer& output) const;
 		
 		virtual std::ostream& writeToStream(std::ostream& os) const;
+		//Write the tag to a buffer, which is much faster than writing to a stream one piece at a time.
+		virtual void writeToBuffer(OutputBuffer& output) const;
 		
 		//Retreive a tag from a stream.
 		
@@ -143,7 +367,88 @@ namespace XML{
 		static Tag* FromStream(Tag* output, std::istream& is, char startingChar = '\0', bool returnNull = true);
 		static Tag* FromStream(std::istream& is, char startingChar = '\0', bool returnNull = true);
 		
+		//Retreive the first tag from a buffer in memory, this is much faster than reading from a stream.
+		static Tag* FromBuffer(Tag* output, const char* data, std::size_t length, bool returnNull = true);
+		static Tag* FromBuffer(const char* data, std::size_t length, bool returnNull = true);
+		
 		friend std::istream& operator>>(std::istream& is, Tag& output);
+		
+	private:
+#ifdef XML_CPP11
+		mutable std::atomic<ChildIndex*> index;
+#else
+		mutable ChildIndex* index;
+#endif
+		
+		//The index if the tag has enough children for one, built again if it is out of date, or if it is stale,
+		//ie. a lookup found that the children changed since it was built.
+		const ChildIndex* currentIndex(const ChildIndex* stale = NULL) const;
+		//The position of the first child tag with the name, or of the next one with the same name as the child at position.
+		//Returns children.size() if there is none.
+		unsigned int firstPositionWithName(const std::string& childName) const;
+		unsigned int firstPositionWithName(Atom childAtom) const;
+		unsigned int nextPositionWithName(unsigned int position) const;
+		
+		friend class NamedChildren;
+	};
+	
+	//The child tags of a tag which have the same name, in order.
+	//It refers to the children of the tag, so it is only valid as long as they do not change.
+	class NamedChildren{
+	public:
+		class iterator{
+		public:
+			typedef std::forward_iterator_tag iterator_category;
+			typedef Tag* value_type;
+			typedef std::ptrdiff_t difference_type;
+			typedef Tag* const* pointer;
+			typedef Tag* reference;
+			
+			iterator():tag(NULL), position(0){}
+			
+			Tag* operator*() const{	return (Tag*)tag->children[position];	}
+			iterator& operator++(){
+				position = tag->nextPositionWithName(position);
+				return *this;
+			}
+			iterator operator++(int){
+				iterator output = *this;
+				++(*this);
+				return output;
+			}
+			
+			bool operator==(const iterator& other) const{	return position == other.position;	}
+			bool operator!=(const iterator& other) const{	return position != other.position;	}
+			
+		private:
+			const Tag* tag;
+			unsigned int position;
+			
+			iterator(const Tag* Owner, unsigned int Position):tag(Owner), position(Position){}
+			friend class NamedChildren;
+		};
+		typedef iterator const_iterator;
+		
+		NamedChildren():tag(NULL), first(0), last(0){}
+		
+		iterator begin() const{	return iterator(tag, first);	}
+		iterator end() const{	return iterator(tag, last);	}
+		
+		bool empty() const{	return first == last;	}
+		//Counts the children, use empty() to check for any.
+		std::size_t size() const;
+		//The first child, NULL if there is none.
+		Tag* front() const{	return empty() ? NULL : *begin();	}
+		
+		operator std::vector<Tag*>() const;
+		
+	private:
+		const Tag* tag;
+		unsigned int first;
+		unsigned int last;
+		
+		NamedChildren(const Tag* Owner, unsigned int First, unsigned int Last):tag(Owner), first(First), last(Last){}
+		friend class Tag;
 	};
 	
 	//Tag Functions
@@ -156,19 +461,51 @@ namespace XML{
 		
 		//The root of the document
 		Tag* root;
-
+		
+		//The arena the tags of the document are allocated from, if it was read with useArena == true.
+		Arena* arena;
+		
+		//The names of the tags of a document which was read, with Tag::atom as their atoms.
+		AtomTable* atoms;
+		
+		//If true the document owns its tags, it calls deleteTags when it is destroyed or assigned,
+		//and copies of it copy the tags, like a Tag does, instead of sharing them.
+		//Documents which do not own their tags are copied as handles to the same tags, which deleteTags destroys for all of them.
+		bool deleteTagsOnDestruction;
+		//With C++11 documents own their tags unless told otherwise, both those returned by the functions which read them
+		//and those built by hand, as they are moved instead of copied. Assigning another document to them deletes their old tags.
+		static const bool OwnedByDefault;
+		
 		Document();
 		Document(const Document& doc);
+		Document& operator=(const Document& doc);
+#ifdef XML_CPP11
+		//Moving passes the tags on in O(1), leaving the moved document empty.
+		Document(Document&& doc);
+		Document& operator=(Document&& doc);
+#endif
+		~Document();
+		
+		void swap(Document& other);
 		
 		//access the attributes of the declaration tag.
-		std::map<std::string,std::string>& Declaration();
+		Attributes& Declaration();
 		
-		//Destroy the root and declaration tags if not NULL.
-		//This is not done on the document destruction.
+		//Destroy the root and declaration tags, the arena and the atoms, if not NULL.
+		//This is only done on the document destruction if deleteTagsOnDestruction is true.
 		void deleteTags();
 		
 		//Write the document to a stream
 		std::ostream& writeToStream(std::ostream& os) const;
+		//Write the document to a buffer, which can pass it on to a stream or a file descriptor in large chunks.
+		void writeToBuffer(OutputBuffer& output) const;
+		
+		//Write the document on threadCount threads, 0 for one per core, giving the same bytes as writeToBuffer.
+		//The children of the first tag with a few hundred of them, found from the top level down through the tags with the most children, are split in runs
+		//which are written into buffers of their own on every thread and passed on in order, while the rest is written on the calling thread.
+		//Only a few runs are kept at once, so the memory used does not grow with the document. Without C++11 this is writeToBuffer.
+		std::ostream& writeToStreamParallel(std::ostream& os, unsigned int threadCount = 0) const;
+		void writeToBufferParallel(OutputBuffer& output, unsigned int threadCount = 0) const;
 		
 		//Create a new tag as the declaration tag.
 		Tag* createDeclaration();
@@ -180,9 +517,26 @@ namespace XML{
 		Tag* createRoot(const std::string& rootName);
 		
 		//Read a document from a stream.
-		static Document FromStream(std::istream& os, const std::string& rootName);
+		//If useArena == true every tag and string of the document is allocated from a new arena, which is much faster to create and destroy.
+		static Document FromStream(std::istream& os, const std::string& rootName, bool useArena = false);
 		static Document FromStream(std::istream& os);
 		
+		//Read a document from a buffer in memory, this is much faster than reading from a stream.
+		static Document FromBuffer(const char* data, std::size_t length, const std::string& rootName, bool useArena = false);
+		static Document FromBuffer(const char* data, std::size_t length);
+		
+		//Read a document from a buffer on threadCount threads, 0 for one per core, giving the same tree as FromBuffer.
+		//The buffer is split between the top level tags, or between the children of the first top level tag,
+		//and every piece is read on its own thread. If a split point turns out not to be between two of those tags
+		//the document is read again on one thread. Without C++11 this is FromBuffer.
+		static Document FromBufferParallel(const char* data, std::size_t length, unsigned int threadCount = 0, const std::string& rootName = "_root", bool useArena = false);
+		
+		//Read a document from a file, which is memory mapped while it is parsed. The tags copy what they hold,
+		//so the file is unmapped when this returns; ReadOnlyDocument::FromFile reads a file without copying it.
+		//If the file could not be opened the document is empty, like one read from an empty buffer: the root has no children.
+		static Document FromFile(const std::string& path, const std::string& rootName, bool useArena = false);
+		static Document FromFile(const std::string& path);
+		
 		friend std::istream& operator>>(std::istream& is, Document& output);
 		friend std::ostream& operator<<(std::ostream& os, const Document& doc);
 	};
@@ -0,0 +1,134 @@
+#include "XMLArena.h"
+#include <new>
+
+namespace XML{
+	
+	Arena::Arena(std::size_t BlockSize, bool Pooling, std::size_t FirstBlockSize):blockSize(BlockSize < MinimumBlockSize ? MinimumBlockSize : BlockSize), pooling(Pooling), nextBlockSize(FirstBlockSize), used(0), current(NULL), remaining(0), reserved(0){
+		if(nextBlockSize < MinimumBlockSize){
+			nextBlockSize = MinimumBlockSize;
+		}else if(nextBlockSize > blockSize){
+			nextBlockSize = blockSize;
+		}
+		for(std::size_t i = 0; i < PooledSizes; ++i){
+			pools[i] = NULL;
+		}
+	}
+	
+	Arena::~Arena(){
+		clear();
+	}
+	
+	char* Arena::newBlock(std::size_t size){
+		char* block = (char*)::operator new(size);
+		reserved += size;
+		return block;
+	}
+	
+	void* Arena::allocate(std::size_t size){
+		size = (size + Alignment - 1) & ~(Alignment - 1);
+		if(size == 0){
+			size = Alignment;
+		}
+		
+		const std::size_t pool = size / Alignment - 1;
+		if(pool < PooledSizes && pools[pool] != NULL){
+			FreeNode* node = pools[pool];
+			pools[pool] = node->next;
+			return node;
+		}
+		
+		if(size > remaining){
+			//large allocations get a block of their own, so the current block is not wasted
+			if(size > blockSize / 4){
+				largeBlocks.push_back(newBlock(size));
+				return largeBlocks.back();
+			}
+			//blocks kept by reset are used again first, skipping those which are too small
+			while(used < blocks.size() && blockSizes[used] < size){
+				++used;
+			}
+			if(used == blocks.size()){
+				while(nextBlockSize < size * 4 && nextBlockSize < blockSize){
+					nextBlockSize *= 2;
+				}
+				if(nextBlockSize > blockSize){
+					nextBlockSize = blockSize;
+				}
+				blocks.push_back(newBlock(nextBlockSize));
+				blockSizes.push_back(nextBlockSize);
+				nextBlockSize = (nextBlockSize * 2 < blockSize) ? nextBlockSize * 2 : blockSize;
+			}
+			current = blocks[used];
+			remaining = blockSizes[used];
+			++used;
+		}
+		void* output = current;
+		current += size;
+		remaining -= size;
+		return output;
+	}
+	
+	void Arena::deallocate(void* p, std::size_t size){
+		if(p == NULL || !pooling){
+			return;
+		}
+		size = (size + Alignment - 1) & ~(Alignment - 1);
+		const std::size_t pool = size / Alignment - 1;
+		if(pool < PooledSizes){
+			FreeNode* node = (FreeNode*)p;
+			node->next = pools[pool];
+			pools[pool] = node;
+		}
+	}
+	
+	void Arena::clear(){
+		for(std::size_t i = 0; i < blocks.size(); ++i){
+			::operator delete(blocks[i]);
+		}
+		blocks.clear();
+		blockSizes.clear();
+		reset();
+		reserved = 0;
+	}
+	
+	void Arena::reset(){
+		for(std::size_t i = 0; i < largeBlocks.size(); ++i){
+			::operator delete(largeBlocks[i]);
+		}
+		largeBlocks.clear();
+		used = 0;
+		current = NULL;
+		remaining = 0;
+		reserved = 0;
+		for(std::size_t i = 0; i < blockSizes.size(); ++i){
+			reserved += blockSizes[i];
+		}
+		for(std::size_t i = 0; i < PooledSizes; ++i){
+			pools[i] = NULL;
+		}
+		for(std::size_t i = 0; i < adopted.size(); ++i){
+			delete adopted[i];
+		}
+		adopted.clear();
+	}
+	
+	void Arena::adopt(Arena* other){
+		if(other != NULL && other != this){
+			adopted.push_back(other);
+		}
+	}
+	
+	std::size_t Arena::FirstBlockSize(std::size_t length){
+		//the tags and strings of a small document take about ten times as much memory as its text
+		return (length < DefaultBlockSize / 16) ? length * 16 : DefaultBlockSize;
+	}
+	
+	std::size_t Arena::capacity() const{
+		std::size_t output = reserved;
+		for(std::size_t i = 0; i < adopted.size(); ++i){
+			output += adopted[i]->capacity();
+		}
+		return output;
+	}
+	
+}; //end namespace XML
@@ -0,0 +1,76 @@
+#ifndef _XML_ARENA_H
+#define _XML_ARENA_H
+
+#include <cstddef>
+#include <vector>
+
+namespace XML{
+	
+	//Bump allocator for the objects of a document, all of its memory is freed at once when it is destroyed.
+	//If pooling is enabled deallocated memory is kept in free lists by size and reused.
+	//The first block is small, and every block after it twice as large as the one before, up to blockSize,
+	//so small documents do not reserve a whole block each.
+	class Arena{
+	public:
+		static const std::size_t MinimumBlockSize = 1024;
+		static const std::size_t DefaultBlockSize = 65536;
+		
+		Arena(std::size_t blockSize = DefaultBlockSize, bool pooling = true, std::size_t firstBlockSize = MinimumBlockSize);
+		~Arena();
+		
+		void* allocate(std::size_t size);
+		void deallocate(void* p, std::size_t size);
+		
+		//Free every block, anything allocated from the arena becomes invalid.
+		//Adopted arenas are destroyed as well.
+		void clear();
+		
+		//Like clear, but the blocks are kept to be filled again instead of being returned to the system.
+		void reset();
+		
+		//Take ownership of another arena, which is destroyed with this one.
+		//Objects allocated from it stay valid, so several arenas filled on different threads can be kept by one document.
+		void adopt(Arena* other);
+		
+		//The number of bytes reserved from the system, including adopted arenas.
+		std::size_t capacity() const;
+		
+		//A first block for a document read from length bytes, which mostly fits the tags of small documents.
+		static std::size_t FirstBlockSize(std::size_t length);
+		
+	private:
+		static const std::size_t Alignment = 8;
+		static const std::size_t PooledSizes = 32;
+		
+		struct FreeNode{
+			FreeNode* next;
+		};
+		
+		std::size_t blockSize;
+		bool pooling;
+		std::vector<char*> blocks;
+		//the size of each block, which never gets smaller from one block to the next
+		std::vector<std::size_t> blockSizes;
+		//the size of the next block which is reserved
+		std::size_t nextBlockSize;
+		//the number of blocks in use, the rest were kept by reset
+		std::size_t used;
+		//blocks holding a single large allocation
+		std::vector<char*> largeBlocks;
+		char* current;
+		std::size_t remaining;
+		std::size_t reserved;
+		//free lists for sizes up to Alignment * PooledSizes
+		FreeNode* pools[PooledSizes];
+		std::vector<Arena*> adopted;
+		
+		char* newBlock(std::size_t size);
+		
+		//not copyable
+		Arena(const Arena& other);
+		Arena& operator=(const Arena& other);
+	};
+	
+}; //end namespace XML
+
+#endif //_XML_ARENA_H
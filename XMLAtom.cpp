@@ -0,0 +1,68 @@
+#include "XMLAtom.h"
+#include <cstring>
+
+namespace XML{
+	
+	static const std::size_t InitialTableSize = 64;
+	
+	AtomTable::AtomTable():names(1), hashes(1, 0), table(InitialTableSize, NoAtom){}
+	
+	Atom AtomTable::find(const char* name, std::size_t length) const{
+		const unsigned int hash = HashName(name, length);
+		const std::size_t mask = table.size() - 1;
+		for(std::size_t slot = hash & mask;; slot = (slot + 1) & mask){
+			const Atom atom = table[slot];
+			if(atom == NoAtom){
+				return NoAtom;
+			}else if(hashes[atom] == hash && names[atom].length() == length && memcmp(names[atom].data(), name, length) == 0){
+				return atom;
+			}
+		}
+	}
+	
+	Atom AtomTable::intern(const char* name, std::size_t length){
+		const unsigned int hash = HashName(name, length);
+		const std::size_t mask = table.size() - 1;
+		std::size_t slot = hash & mask;
+		for(;; slot = (slot + 1) & mask){
+			const Atom atom = table[slot];
+			if(atom == NoAtom){
+				break;
+			}else if(hashes[atom] == hash && names[atom].length() == length && memcmp(names[atom].data(), name, length) == 0){
+				return atom;
+			}
+		}
+		
+		const Atom atom = names.size();
+		names.push_back(std::string(name, length));
+		hashes.push_back(hash);
+		table[slot] = atom;
+		if(names.size() * 2 > table.size()){
+			grow();
+		}
+		return atom;
+	}
+	
+	const SharedName& AtomTable::shared(Atom atom){
+		if(sharedNames.size() <= atom){
+			sharedNames.resize(names.size());
+		}
+		if(sharedNames[atom].empty()){
+			sharedNames[atom] = SharedName(names[atom]);
+		}
+		return sharedNames[atom];
+	}
+	
+	void AtomTable::grow(){
+		table.assign(table.size() * 2, NoAtom);
+		const std::size_t mask = table.size() - 1;
+		for(Atom atom = 1; atom < names.size(); ++atom){
+			std::size_t slot = hashes[atom] & mask;
+			while(table[slot] != NoAtom){
+				slot = (slot + 1) & mask;
+			}
+			table[slot] = atom;
+		}
+	}
+	
+}; //end namespace XML
@@ -0,0 +1,56 @@
+#ifndef _XML_ATOM_H
+#define _XML_ATOM_H
+
+#include "XML.h"
+
+namespace XML{
+	
+	//FNV-1a hash of a name.
+	inline unsigned int HashName(const char* name, std::size_t length){
+		unsigned int hash = 2166136261u;
+		for(std::size_t i = 0; i < length; ++i){
+			hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+		}
+		return hash;
+	}
+	
+	//Interns names, so every distinct name is stored once and can be compared as an Atom.
+	//Atoms are numbered from 1 in the order the names were added, they are never removed.
+	//Finding atoms is safe from several threads, as long as no names are being added.
+	class AtomTable{
+	public:
+		AtomTable();
+		
+		//The atom of the name, adding the name if it is new.
+		Atom intern(const char* name, std::size_t length);
+		Atom intern(const std::string& name){	return intern(name.data(), name.length());	}
+		
+		//The atom of the name, NoAtom if the name has not been added.
+		Atom find(const char* name, std::size_t length) const;
+		Atom find(const std::string& name) const{	return find(name.data(), name.length());	}
+		
+		//The name of the atom, empty for NoAtom.
+		const std::string& name(Atom atom) const{	return names[atom];	}
+		//The name as a SharedName for the keys of attributes, made the first time it is asked for, so names of tags never allocate one.
+		const SharedName& shared(Atom atom);
+		//The HashName of the name of the atom.
+		unsigned int hash(Atom atom) const{	return hashes[atom];	}
+		
+		//The number of names.
+		std::size_t size() const{	return names.size() - 1;	}
+		
+	private:
+		//indexed by atom, the first one is for NoAtom
+		std::vector<std::string> names;
+		//indexed by atom, filled by shared
+		std::vector<SharedName> sharedNames;
+		std::vector<unsigned int> hashes;
+		//open addressing, the size is a power of two, NoAtom marks an empty slot
+		std::vector<Atom> table;
+		
+		void grow();
+	};
+	
+}; //end namespace XML
+
+#endif //_XML_ATOM_H
@@ -0,0 +1,281 @@
+#include "XMLBatch.h"
+#include "XMLBuilder.h"
+#include "XMLArena.h"
+#include "XMLAtom.h"
+
+#ifdef XML_CPP11
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#endif
+
+namespace XML{
+	
+	//A thread of the pool, with everything it keeps from one batch to the next.
+	class BatchWorker{
+	public:
+		Arena arena;
+		AtomTable* atoms;
+		Lexer lexer;
+		//the documents read in the last batch, destroyed when the next one starts
+		std::vector<Document> parsed;
+		std::size_t failed;
+		
+		BatchWorker():atoms(NULL), failed(0), begin(0), end(0){}
+		
+		~BatchWorker(){
+			release();
+			delete atoms;
+		}
+		
+		//Destroy the documents of the last batch, keeping the blocks of the arena.
+		void release(){
+			for(std::size_t i = 0; i < parsed.size(); ++i){
+				parsed[i].deleteTags();
+			}
+			parsed.clear();
+			arena.reset();
+			delete atoms;
+			atoms = new AtomTable();
+			failed = 0;
+		}
+		
+		//Read the buffer the way Document::FromBuffer does, but into the arena and the atoms of the worker.
+		bool read(const Buffer& buffer, Document& output){
+			//the documents are handles to tags which the worker deletes
+			Document document;
+			document.deleteTagsOnDestruction = false;
+			document.arena = &arena;
+			document.atoms = atoms;
+			document.createRoot();
+			if(buffer.data != NULL){
+				BufferSource source(lexer, buffer.data, buffer.data + buffer.length);
+				if(ParseStatsEnabled()){
+					ReadDocumentWithStats(document, source, lexer, buffer.length);
+				}else{
+					ReadDocument(document, source, lexer);
+				}
+			}
+			//indexed now, so the documents can be searched from several threads
+			if(document.declaration != NULL){
+				BuildIndexes(document.declaration);
+			}
+			BuildIndexes(document.root);
+			//they belong to the worker, so deleteTags leaves them alone
+			document.arena = NULL;
+			document.atoms = NULL;
+			parsed.push_back(document);
+			output = document;
+			return !document.root->children.empty();
+		}
+		
+		void assign(std::size_t Begin, std::size_t End){
+			begin = Begin;
+			end = End;
+		}
+		
+		//Take the next document of the worker.
+		bool take(std::size_t& index){
+#ifdef XML_CPP11
+			std::lock_guard<std::mutex> guard(lock);
+#endif
+			if(begin == end){
+				return false;
+			}
+			index = begin++;
+			return true;
+		}
+		
+		//Take the second half of the documents left to another worker, and the first of them to read now.
+		bool steal(BatchWorker& victim, std::size_t& index){
+			std::size_t first, last;
+			{
+#ifdef XML_CPP11
+				std::lock_guard<std::mutex> guard(victim.lock);
+#endif
+				if(victim.begin == victim.end){
+					return false;
+				}
+				first = victim.begin + (victim.end - victim.begin) / 2;
+				last = victim.end;
+				victim.end = first;
+			}
+#ifdef XML_CPP11
+			std::lock_guard<std::mutex> guard(lock);
+#endif
+			index = first;
+			begin = first + 1;
+			end = last;
+			return true;
+		}
+		
+	private:
+		//the documents left to read, others steal from the end
+		std::size_t begin;
+		std::size_t end;
+#ifdef XML_CPP11
+		std::mutex lock;
+#endif
+	};
+	
+	//The workers, and the threads which run every one of them but the first, which runs on the calling thread.
+	class BatchParser::Pool{
+	public:
+		std::vector<BatchWorker*> workers;
+		
+		Pool(unsigned int threadCount):buffers(NULL), documents(NULL), failures(NULL){
+#ifdef XML_CPP11
+			if(threadCount == 0){
+				threadCount = std::thread::hardware_concurrency();
+			}
+			if(threadCount == 0){
+				threadCount = 1;
+			}
+			generation = 0;
+			running = 0;
+			stopping = false;
+#else
+			threadCount = 1;
+#endif
+			for(unsigned int i = 0; i < threadCount; ++i){
+				workers.push_back(new BatchWorker());
+			}
+#ifdef XML_CPP11
+			for(unsigned int i = 1; i < threadCount; ++i){
+				threads.push_back(std::thread(&Pool::loop, this, i));
+			}
+#endif
+		}
+		
+		~Pool(){
+#ifdef XML_CPP11
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				stopping = true;
+			}
+			started.notify_all();
+			for(unsigned int i = 0; i < threads.size(); ++i){
+				threads[i].join();
+			}
+#endif
+			for(unsigned int i = 0; i < workers.size(); ++i){
+				delete workers[i];
+			}
+		}
+		
+		std::size_t run(const Buffer* Buffers, std::size_t count, std::vector<Document>& Documents, std::vector<char>& Failures){
+			buffers = Buffers;
+			documents = &Documents;
+			failures = &Failures;
+			for(unsigned int i = 0; i < workers.size(); ++i){
+				workers[i]->assign(count * i / workers.size(), count * (i + 1) / workers.size());
+			}
+			
+#ifdef XML_CPP11
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				++generation;
+				running = threads.size();
+			}
+			started.notify_all();
+			work(0);
+			{
+				std::unique_lock<std::mutex> guard(lock);
+				while(running != 0){
+					finished.wait(guard);
+				}
+			}
+#else
+			work(0);
+#endif
+			
+			std::size_t failed = 0;
+			for(unsigned int i = 0; i < workers.size(); ++i){
+				failed += workers[i]->failed;
+			}
+			return failed;
+		}
+		
+	private:
+		//the batch being read
+		const Buffer* buffers;
+		std::vector<Document>* documents;
+		std::vector<char>* failures;
+		
+#ifdef XML_CPP11
+		std::vector<std::thread> threads;
+		std::mutex lock;
+		std::condition_variable started;
+		std::condition_variable finished;
+		//counts the batches, so a thread knows when a new one starts
+		unsigned long generation;
+		unsigned int running;
+		bool stopping;
+		
+		void loop(unsigned int i){
+			unsigned long seen = 0;
+			for(;;){
+				{
+					std::unique_lock<std::mutex> guard(lock);
+					while(!stopping && generation == seen){
+						started.wait(guard);
+					}
+					if(stopping){
+						return;
+					}
+					seen = generation;
+				}
+				work(i);
+				{
+					std::lock_guard<std::mutex> guard(lock);
+					--running;
+				}
+				finished.notify_all();
+			}
+		}
+#endif
+		
+		//Read the documents of the worker, then steal from the others until every one is read.
+		void work(unsigned int i){
+			BatchWorker& worker = *workers[i];
+			worker.release();
+			std::size_t index;
+			for(;;){
+				if(!worker.take(index)){
+					bool stolen = false;
+					for(unsigned int j = 1; j < workers.size() && !stolen; ++j){
+						stolen = worker.steal(*workers[(i + j) % workers.size()], index);
+					}
+					if(!stolen){
+						return;
+					}
+				}
+				if(!worker.read(buffers[index], (*documents)[index])){
+					(*failures)[index] = 1;
+					++worker.failed;
+				}
+			}
+		}
+	};
+	
+	BatchParser::BatchParser(unsigned int threadCount):pool(new Pool(threadCount)){}
+	
+	BatchParser::~BatchParser(){
+		delete pool;
+	}
+	
+	std::size_t BatchParser::parse(const Buffer* buffers, std::size_t count){
+		documents.assign(count, Document());
+		failures.assign(count, 0);
+		return pool->run(buffers, count, documents, failures);
+	}
+	
+	std::size_t BatchParser::parse(const std::vector<Buffer>& buffers){
+		return parse(buffers.empty() ? NULL : &buffers[0], buffers.size());
+	}
+	
+	unsigned int BatchParser::threadCount() const{
+		return pool->workers.size();
+	}
+	
+}; //end namespace XML
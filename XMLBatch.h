@@ -0,0 +1,62 @@
+#ifndef _XML_BATCH_H
+#define _XML_BATCH_H
+
+#include "XML.h"
+
+namespace XML{
+	
+	//A buffer in memory holding one document.
+	struct Buffer{
+		const char* data;
+		std::size_t length;
+		
+		Buffer():data(NULL), length(0){}
+		Buffer(const char* Data, std::size_t Length):data(Data), length(Length){}
+		Buffer(const std::string& str):data(str.data()), length(str.length()){}
+	};
+	
+	//Reads many small documents at once on a pool of threads, which take work from each other when they run out of it.
+	//Every thread reads into an arena, an AtomTable and a lexer of its own, which are kept for the next batch,
+	//so a warm parser allocates little more than the strings of the documents.
+	//The documents belong to the parser, they stay valid until the next batch is read or the parser is destroyed.
+	//Copy a tag to keep it longer, and do not call deleteTags on them.
+	//Every tag is indexed as its document is read, so lookups change nothing and the documents can be searched from several threads at once, but not changed.
+	//Without C++11 every document is read on the calling thread.
+	class BatchParser{
+	public:
+		//threadCount == 0 uses one thread per core, the calling thread is one of them.
+		BatchParser(unsigned int threadCount = 0);
+		~BatchParser();
+		
+		//Read a document from every buffer, replacing the previous batch.
+		//Returns the number of buffers which did not hold a tag.
+		std::size_t parse(const Buffer* buffers, std::size_t count);
+		std::size_t parse(const std::vector<Buffer>& buffers);
+		
+		//The number of documents in the batch.
+		std::size_t size() const{	return documents.size();	}
+		
+		//The document read from buffers[i], it has a root tag even if reading failed.
+		Document& document(std::size_t i){	return documents[i];	}
+		const Document& document(std::size_t i) const{	return documents[i];	}
+		
+		//True if buffers[i] did not hold a tag.
+		bool failed(std::size_t i) const{	return failures[i] != 0;	}
+		
+		unsigned int threadCount() const;
+		
+	private:
+		class Pool;
+		Pool* pool;
+		
+		std::vector<Document> documents;
+		std::vector<char> failures;
+		
+		//not copyable
+		BatchParser(const BatchParser& other);
+		BatchParser& operator=(const BatchParser& other);
+	};
+	
+}; //end namespace XML
+
+#endif //_XML_BATCH_H
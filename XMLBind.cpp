@@ -0,0 +1,263 @@
+#include "XMLBind.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace XML{
+
+//-----------------------------------VALUES-----------------------------------------------//
+	
+	bool BindValue<std::string>::read(const std::string& text, std::string& value){
+		value = text;
+		return true;
+	}
+	
+	void BindValue<std::string>::write(std::string& text, const std::string& value){
+		text += value;
+	}
+	
+	bool BindValue<bool>::read(const std::string& text, bool& value){
+		if(text == "true" || text == "1"){
+			value = true;
+		}else if(text == "false" || text == "0"){
+			value = false;
+		}else{
+			return false;
+		}
+		return true;
+	}
+	
+	void BindValue<bool>::write(std::string& text, const bool& value){
+		text += value ? "true" : "false";
+	}
+	
+	//Read a number with the conversion function, which has to read something and leave nothing but spaces after it.
+	template<class N, class C> static bool ReadNumber(const std::string& text, N& value, C convert){
+		const char* begin = text.c_str();
+		char* end = NULL;
+		const N number = (N)convert(begin, &end);
+		if(end == begin){
+			return false;
+		}
+		while(*end == ' ' || *end == '\t' || *end == '\n' || *end == '\r'){
+			++end;
+		}
+		if(*end != 0){
+			return false;
+		}
+		value = number;
+		return true;
+	}
+	
+	static long ToLong(const char* s, char** end){	return strtol(s, end, 10);	}
+	static unsigned long ToUnsignedLong(const char* s, char** end){	return strtoul(s, end, 10);	}
+	static long long ToLongLong(const char* s, char** end){	return strtoll(s, end, 10);	}
+	static unsigned long long ToUnsignedLongLong(const char* s, char** end){	return strtoull(s, end, 10);	}
+	static double ToDouble(const char* s, char** end){	return strtod(s, end);	}
+	
+	template<class N> static void WriteNumber(std::string& text, const char* format, N value){
+		char buffer[32];
+		snprintf(buffer, sizeof(buffer), format, value);
+		text += buffer;
+	}
+	
+	bool BindValue<int>::read(const std::string& text, int& value){	return ReadNumber(text, value, ToLong);	}
+	void BindValue<int>::write(std::string& text, const int& value){	WriteNumber(text, "%d", value);	}
+	
+	bool BindValue<unsigned int>::read(const std::string& text, unsigned int& value){	return ReadNumber(text, value, ToUnsignedLong);	}
+	void BindValue<unsigned int>::write(std::string& text, const unsigned int& value){	WriteNumber(text, "%u", value);	}
+	
+	bool BindValue<long>::read(const std::string& text, long& value){	return ReadNumber(text, value, ToLong);	}
+	void BindValue<long>::write(std::string& text, const long& value){	WriteNumber(text, "%ld", value);	}
+	
+	bool BindValue<unsigned long>::read(const std::string& text, unsigned long& value){	return ReadNumber(text, value, ToUnsignedLong);	}
+	void BindValue<unsigned long>::write(std::string& text, const unsigned long& value){	WriteNumber(text, "%lu", value);	}
+	
+	bool BindValue<long long>::read(const std::string& text, long long& value){	return ReadNumber(text, value, ToLongLong);	}
+	void BindValue<long long>::write(std::string& text, const long long& value){	WriteNumber(text, "%lld", value);	}
+	
+	bool BindValue<unsigned long long>::read(const std::string& text, unsigned long long& value){	return ReadNumber(text, value, ToUnsignedLongLong);	}
+	void BindValue<unsigned long long>::write(std::string& text, const unsigned long long& value){	WriteNumber(text, "%llu", value);	}
+	
+	//enough digits to read back the same number
+	bool BindValue<float>::read(const std::string& text, float& value){	return ReadNumber(text, value, ToDouble);	}
+	void BindValue<float>::write(std::string& text, const float& value){	WriteNumber(text, "%.9g", (double)value);	}
+	
+	bool BindValue<double>::read(const std::string& text, double& value){	return ReadNumber(text, value, ToDouble);	}
+	void BindValue<double>::write(std::string& text, const double& value){	WriteNumber(text, "%.17g", value);	}
+	
+//-----------------------------------FIELDS-----------------------------------------------//
+	
+	unsigned int BindHash(const char* name, std::size_t length){
+		unsigned int hash = 2166136261u;
+		for(std::size_t i = 0; i < length; ++i){
+			hash ^= (unsigned char)name[i];
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+	
+	BindField::BindField(const char* Name, KIND Kind):name(Name), hash(BindHash(Name, strlen(Name))), kind(Kind){}
+	
+	BindTable::BindTable():textField(NULL){}
+	
+	BindTable::~BindTable(){
+		for(std::size_t i = 0; i < fields.size(); ++i){
+			delete fields[i];
+		}
+	}
+	
+	void BindTable::add(BindField* field){
+		fields.push_back(field);
+		if(field->kind == BindField::BIND_TEXT){
+			textField = field;
+		}
+		
+		//at most half full, the slots are filled again when they grow
+		if(slots.size() < fields.size() * 2){
+			slots.assign(slots.empty() ? 8 : slots.size() * 2, 0);
+			for(std::size_t i = 0; i < fields.size(); ++i){
+				if(fields[i]->kind == BindField::BIND_TEXT){
+					continue;
+				}
+				std::size_t slot = fields[i]->hash & (slots.size() - 1);
+				while(slots[slot] != 0){
+					slot = (slot + 1) & (slots.size() - 1);
+				}
+				slots[slot] = i + 1;
+			}
+		}else if(field->kind != BindField::BIND_TEXT){
+			std::size_t slot = field->hash & (slots.size() - 1);
+			while(slots[slot] != 0){
+				slot = (slot + 1) & (slots.size() - 1);
+			}
+			slots[slot] = fields.size();
+		}
+	}
+	
+	const BindField* BindTable::find(const StringRef& name, BindField::KIND kind) const{
+		if(slots.empty()){
+			return NULL;
+		}
+		const unsigned int hash = BindHash(name.data, name.length);
+		for(std::size_t slot = hash & (slots.size() - 1); slots[slot] != 0; slot = (slot + 1) & (slots.size() - 1)){
+			const BindField* field = fields[slots[slot] - 1];
+			if(field->hash == hash && field->kind == kind && field->name.length() == name.length && memcmp(field->name.data(), name.data, name.length) == 0){
+				return field;
+			}
+		}
+		return NULL;
+	}
+	
+//-----------------------------------READING-----------------------------------------------//
+	
+	bool BindSkip(Reader& reader){
+		unsigned int depth = 1;
+		while(depth > 0){
+			switch(reader.next()){
+				case Reader::EVENT_START_ELEMENT:
+					++depth;
+					break;
+				case Reader::EVENT_END_ELEMENT:
+					--depth;
+					break;
+				case Reader::EVENT_END:
+					return false;
+				default:
+					break;
+			}
+		}
+		return true;
+	}
+	
+	bool BindReadText(Reader& reader, std::string& text){
+		while(true){
+			switch(reader.next()){
+				case Reader::EVENT_TEXT:
+					text.append(reader.text().data, reader.text().length);
+					break;
+				case Reader::EVENT_START_ELEMENT:
+					if(!BindSkip(reader)){
+						return false;
+					}
+					break;
+				case Reader::EVENT_END_ELEMENT:
+					return true;
+				case Reader::EVENT_END:
+					return false;
+				default:
+					break;
+			}
+		}
+	}
+	
+	bool BindTable::read(void* object, Reader& reader, BindContext& context) const{
+		for(unsigned int i = 0; i < reader.attributeCount(); ++i){
+			const ViewAttribute& attribute = reader.attributeAt(i);
+			const BindField* field = find(attribute.name, BindField::BIND_ATTRIBUTE);
+			if(field != NULL){
+				context.text.clear();
+				attribute.value.appendDecoded(context.text);
+				field->readText(object, context.text);
+			}
+		}
+		
+		//the text of the element, only kept if it has a field
+		std::string text;
+		while(true){
+			switch(reader.next()){
+				case Reader::EVENT_START_ELEMENT:{
+					const BindField* field = find(reader.name(), BindField::BIND_ELEMENT);
+					if(!((field != NULL) ? field->readElement(object, reader, context) : BindSkip(reader))){
+						return false;
+					}
+					break;
+				}
+				case Reader::EVENT_TEXT:
+					if(textField != NULL){
+						text.append(reader.text().data, reader.text().length);
+					}
+					break;
+				case Reader::EVENT_END_ELEMENT:
+					if(textField != NULL){
+						textField->readText(object, text);
+					}
+					return true;
+				case Reader::EVENT_END:
+					return false;
+				default:
+					break;
+			}
+		}
+	}
+	
+//-----------------------------------WRITING-----------------------------------------------//
+	
+	void BindTable::write(const void* object, const char* name, std::size_t length, OutputBuffer& output, BindContext& context) const{
+		output.put('<');
+		output.write(name, length);
+		bool content = false;
+		for(std::size_t i = 0; i < fields.size(); ++i){
+			if(fields[i]->kind == BindField::BIND_ATTRIBUTE){
+				fields[i]->write(object, output, context);
+			}else if(!content){
+				content = fields[i]->hasContent(object, context);
+			}
+		}
+		if(!content){
+			output.write("/>", 2);
+			return;
+		}
+		
+		output.put('>');
+		for(std::size_t i = 0; i < fields.size(); ++i){
+			if(fields[i]->kind != BindField::BIND_ATTRIBUTE){
+				fields[i]->write(object, output, context);
+			}
+		}
+		output.write("</", 2);
+		output.write(name, length);
+		output.put('>');
+	}
+	
+}; //end namespace XML
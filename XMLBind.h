@@ -0,0 +1,336 @@
+#ifndef _XML_BIND_H
+#define _XML_BIND_H
+
+#include "XMLReader.h"
+#include "XMLOutput.h"
+
+namespace XML{
+	
+	//Binds the fields of a struct to the attributes, child elements and text of an element, so the struct is read straight from the
+	//events of a Reader, without building tags, and written back as XML. The struct declares its fields once, in a static template function:
+	//	struct Book{
+	//		int id;
+	//		std::string title;
+	//		std::vector<std::string> tags;
+	//		Author author;
+	//
+	//		template<class Binder> static void bind(Binder& binder){
+	//			binder.attribute("id", &Book::id);
+	//			binder.element("title", &Book::title);
+	//			binder.element("tag", &Book::tags);			//every <tag> element, in order
+	//			binder.element("author", &Book::author);	//Author has a bind function of its own
+	//		}
+	//	};
+	//	Book book;
+	//	ReadStruct(data, length, book);
+	//	WriteStruct(output, "book", book);
+	//The fields are strings, numbers, bool, structs with a bind function, or std::vectors of them, which are read from repeated elements.
+	//bind is called once per struct, the first time it is read or written, to build a table which finds fields by the hash of their names.
+	//Elements and attributes without a field are skipped, and fields without an element or attribute keep their value.
+	//Attribute values and text are decoded when read and escaped when written.
+	//Without C++11 read or write every struct once before doing it from several threads, so the tables are built.
+	
+	//Kept from one element to the next while a struct is read, so the text of the fields does not allocate every time.
+	struct BindContext{
+		std::string text;
+	};
+	
+	//Converts the values of fields from and to text. Every other type is bound as an element with fields of its own.
+	template<class V> struct BindValue{
+		enum{ IsValue = 0 };
+	};
+	
+	//Declares the conversions of a value type, which are defined in XMLBind.cpp.
+	//read returns false and leaves the value alone if the text does not hold one.
+#define XML_BIND_VALUE(V)	\
+	template<> struct BindValue<V>{	\
+		enum{ IsValue = 1 };	\
+		static bool read(const std::string& text, V& value);	\
+		static void write(std::string& text, const V& value);	\
+	};
+	
+	XML_BIND_VALUE(std::string)
+	XML_BIND_VALUE(bool)
+	XML_BIND_VALUE(int)
+	XML_BIND_VALUE(unsigned int)
+	XML_BIND_VALUE(long)
+	XML_BIND_VALUE(unsigned long)
+	XML_BIND_VALUE(long long)
+	XML_BIND_VALUE(unsigned long long)
+	XML_BIND_VALUE(float)
+	XML_BIND_VALUE(double)
+	
+#undef XML_BIND_VALUE
+	
+	//A field of a struct, which reads and writes it through a pointer to the struct.
+	class BindField{
+	public:
+		enum KIND{
+			BIND_ATTRIBUTE,
+			BIND_ELEMENT,
+			BIND_TEXT
+		};
+		
+		std::string name;
+		unsigned int hash;
+		KIND kind;
+		
+		BindField(const char* Name, KIND Kind);
+		virtual ~BindField(){}
+		
+		//Read an attribute or the text of the struct, decoded.
+		virtual void readText(void* /*object*/, const std::string& /*text*/) const{}
+		//Read the element which the reader has just started, up to and including its end, returns false if the document ended first.
+		virtual bool readElement(void* /*object*/, Reader& /*reader*/, BindContext& /*context*/) const{	return true;	}
+		//Write the attribute with the space before it, the element, or the text.
+		virtual void write(const void* object, OutputBuffer& output, BindContext& context) const = 0;
+		//False if writing the field writes nothing, for empty vectors and text.
+		virtual bool hasContent(const void* /*object*/, BindContext& /*context*/) const{	return true;	}
+	};
+	
+	//The fields of a struct, found by the hash of their names.
+	class BindTable{
+	public:
+		BindTable();
+		~BindTable();
+		
+		void add(BindField* field);
+		
+		//The field of the attribute or element, NULL if there is none.
+		const BindField* attribute(const StringRef& name) const{	return find(name, BindField::BIND_ATTRIBUTE);	}
+		const BindField* element(const StringRef& name) const{	return find(name, BindField::BIND_ELEMENT);	}
+		
+		//Read the element which the reader has just started into the object, up to and including its end.
+		//Returns false if the document ended first.
+		bool read(void* object, Reader& reader, BindContext& context) const;
+		//Write the object as an element with the name.
+		void write(const void* object, const char* name, std::size_t length, OutputBuffer& output, BindContext& context) const;
+		
+	private:
+		//every field, in the order they were declared, which is the order they are written in
+		std::vector<BindField*> fields;
+		const BindField* textField;
+		//open addressing, 1 + the index of the field, 0 for an empty slot
+		std::vector<unsigned int> slots;
+		
+		const BindField* find(const StringRef& name, BindField::KIND kind) const;
+		
+		//not copyable
+		BindTable(const BindTable& other);
+		BindTable& operator=(const BindTable& other);
+	};
+	
+	//The hash of a name of a field.
+	unsigned int BindHash(const char* name, std::size_t length);
+	//Read the text of the element which the reader has just started, decoded, up to and including its end.
+	//The text of the elements inside of it is skipped. Returns false if the document ended first.
+	bool BindReadText(Reader& reader, std::string& text);
+	//Skip the element which the reader has just started, up to and including its end.
+	bool BindSkip(Reader& reader);
+	
+	template<class T> class BindStruct;
+	
+	//Reads and writes a member of type M, as a value or as a struct.
+	template<class M, int IsValue = BindValue<M>::IsValue> struct BindMember{
+		static bool read(M& member, Reader& reader, BindContext& context){
+			return BindStruct<M>::Table().read(&member, reader, context);
+		}
+		
+		static void write(const M& member, const std::string& name, OutputBuffer& output, BindContext& context){
+			BindStruct<M>::Table().write(&member, name.data(), name.length(), output, context);
+		}
+	};
+	
+	template<class M> struct BindMember<M, 1>{
+		static bool read(M& member, Reader& reader, BindContext& context){
+			context.text.clear();
+			const bool ended = BindReadText(reader, context.text);
+			BindValue<M>::read(context.text, member);
+			return ended;
+		}
+		
+		static void write(const M& member, const std::string& name, OutputBuffer& output, BindContext& context){
+			context.text.clear();
+			BindValue<M>::write(context.text, member);
+			output.put('<');
+			output.write(name);
+			output.put('>');
+			output.writeEscaped(context.text);
+			output.write("</", 2);
+			output.write(name);
+			output.put('>');
+		}
+	};
+	
+	template<class T, class M> class BindAttribute : public BindField{
+	public:
+		BindAttribute(const char* Name, M T::*Member):BindField(Name, BIND_ATTRIBUTE), member(Member){}
+		
+		void readText(void* object, const std::string& text) const{
+			BindValue<M>::read(text, ((T*)object)->*member);
+		}
+		
+		void write(const void* object, OutputBuffer& output, BindContext& context) const{
+			context.text.clear();
+			BindValue<M>::write(context.text, ((const T*)object)->*member);
+			output.put(' ');
+			output.write(name);
+			output.write("=\"", 2);
+			output.writeEscaped(context.text);
+			output.put('"');
+		}
+		
+	private:
+		M T::*member;
+	};
+	
+	template<class T, class M> class BindText : public BindField{
+	public:
+		BindText(M T::*Member):BindField("", BIND_TEXT), member(Member){}
+		
+		void readText(void* object, const std::string& text) const{
+			BindValue<M>::read(text, ((T*)object)->*member);
+		}
+		
+		void write(const void* object, OutputBuffer& output, BindContext& context) const{
+			context.text.clear();
+			BindValue<M>::write(context.text, ((const T*)object)->*member);
+			output.writeEscaped(context.text);
+		}
+		
+		bool hasContent(const void* object, BindContext& context) const{
+			context.text.clear();
+			BindValue<M>::write(context.text, ((const T*)object)->*member);
+			return !context.text.empty();
+		}
+		
+	private:
+		M T::*member;
+	};
+	
+	template<class T, class M> class BindElement : public BindField{
+	public:
+		BindElement(const char* Name, M T::*Member):BindField(Name, BIND_ELEMENT), member(Member){}
+		
+		bool readElement(void* object, Reader& reader, BindContext& context) const{
+			return BindMember<M>::read(((T*)object)->*member, reader, context);
+		}
+		
+		void write(const void* object, OutputBuffer& output, BindContext& context) const{
+			BindMember<M>::write(((const T*)object)->*member, name, output, context);
+		}
+		
+	private:
+		M T::*member;
+	};
+	
+	//Every element with the name, in a vector.
+	template<class T, class M> class BindElements : public BindField{
+	public:
+		BindElements(const char* Name, std::vector<M> T::*Member):BindField(Name, BIND_ELEMENT), member(Member){}
+		
+		bool readElement(void* object, Reader& reader, BindContext& context) const{
+			std::vector<M>& elements = ((T*)object)->*member;
+			elements.push_back(M());
+			return BindMember<M>::read(elements.back(), reader, context);
+		}
+		
+		void write(const void* object, OutputBuffer& output, BindContext& context) const{
+			const std::vector<M>& elements = ((const T*)object)->*member;
+			for(std::size_t i = 0; i < elements.size(); ++i){
+				BindMember<M>::write(elements[i], name, output, context);
+			}
+		}
+		
+		bool hasContent(const void* object, BindContext&) const{
+			return !(((const T*)object)->*member).empty();
+		}
+		
+	private:
+		std::vector<M> T::*member;
+	};
+	
+	//Passed to the bind function of a struct to declare its fields.
+	template<class T> class Binder{
+	public:
+		Binder(BindTable& Table):table(Table){}
+		
+		template<class M> void attribute(const char* name, M T::*member){
+			table.add(new BindAttribute<T, M>(name, member));
+		}
+		
+		template<class M> void element(const char* name, M T::*member){
+			table.add(new BindElement<T, M>(name, member));
+		}
+		
+		template<class M> void element(const char* name, std::vector<M> T::*member){
+			table.add(new BindElements<T, M>(name, member));
+		}
+		
+		//The text of the element itself, for an element holding both attributes and text.
+		template<class M> void text(M T::*member){
+			table.add(new BindText<T, M>(member));
+		}
+		
+	private:
+		BindTable& table;
+	};
+	
+	//The table of a struct, built by its bind function the first time it is asked for.
+	template<class T> class BindStruct{
+	public:
+		static const BindTable& Table(){
+			static const Built table;
+			return table;
+		}
+		
+	private:
+		class Built : public BindTable{
+		public:
+			Built(){
+				Binder<T> binder(*this);
+				T::bind(binder);
+			}
+		};
+	};
+	
+	//Read the struct from the next element of the reader, or from the element which it has just started.
+	//Returns false if there is no element, or if the document ended before the end of the element.
+	template<class T> bool ReadStruct(Reader& reader, T& output){
+		while(reader.event() != Reader::EVENT_START_ELEMENT){
+			if(reader.next() == Reader::EVENT_END){
+				return false;
+			}
+		}
+		BindContext context;
+		return BindStruct<T>::Table().read(&output, reader, context);
+	}
+	
+	//Read the struct from the first top level element of the buffer.
+	template<class T> bool ReadStruct(const char* data, std::size_t length, T& output){
+		Reader reader(data, length);
+		return ReadStruct(reader, output);
+	}
+	
+	//Read the struct from the first top level element of a stream, in constant memory.
+	template<class T> bool ReadStruct(std::istream& is, T& output){
+		Reader reader(is);
+		return ReadStruct(reader, output);
+	}
+	
+	//Write the struct as an element with the name.
+	template<class T> void WriteStruct(OutputBuffer& output, const std::string& name, const T& input){
+		BindContext context;
+		BindStruct<T>::Table().write(&input, name.data(), name.length(), output, context);
+	}
+	
+	template<class T> std::ostream& WriteStruct(std::ostream& os, const std::string& name, const T& input){
+		OutputBuffer output(os);
+		WriteStruct(output, name, input);
+		output.flush();
+		return os;
+	}
+	
+}; //end namespace XML
+
+#endif //_XML_BIND_H
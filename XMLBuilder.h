@@ -0,0 +1,242 @@
+#ifndef _XML_BUILDER_H
+#define _XML_BUILDER_H
+
+#include "XML.h"
+#include "XMLLexer.h"
+#include "XMLStats.h"
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define XML_STATS_RDTSC
+#include <intrin.h>
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define XML_STATS_RDTSC
+#include <x86intrin.h>
+#endif
+
+//Builds Tag trees from Lexer tokens, shared by the parsers, not part of the public interface.
+//A Source is anything with Lexer::Token next(Lexer&).
+
+namespace XML{
+	
+	//Reads tokens from a buffer held entirely in memory.
+	class BufferSource{
+	public:
+		BufferSource(Lexer& lexer, const char* begin, const char* end){
+			lexer.reset(begin, end);
+		}
+		
+		Lexer::Token next(Lexer& lexer){
+			return lexer.next();
+		}
+	};
+	
+	//Add text to the tag, appending it to the last child if that is a string.
+	//The text is only decoded if deEscape == true.
+	void AddText(Tag* tag, const Span& text, bool deEscape);
+	
+	//Set the name of the tag, and its atom if the tag uses atoms.
+	void SetName(Tag* tag, const Span& name);
+	
+	//Copy the attributes of the current start tag to the tag.
+	void SetAttributes(Tag* tag, const Lexer& lexer);
+	
+	//Build the index of every tag under top with enough children for one, so lookups from several threads do not change the tree.
+	void BuildIndexes(const Tag* top);
+	
+	//Builds the content of a tag one token at a time, starting after its start tag <name>... up to and including its end tag.
+	//Every piece of markup is preceded by a string child, even if it is empty.
+	class ContentBuilder{
+	public:
+		ContentBuilder():text(false){}
+		ContentBuilder(Tag* tag):open(1, tag), text(false){}
+		
+		//Start on the content of another tag.
+		void reset(Tag* tag){
+			open.assign(1, tag);
+			text = false;
+		}
+		
+		//True once the end tag of the tag has been added.
+		bool closed() const{	return open.empty();	}
+		
+		//Add a token, returns false once the tag is closed.
+		bool add(Lexer::Token token, const Lexer& lexer){
+			switch(token){
+				case Lexer::TOKEN_TEXT:
+					AddText(open.back(), lexer.text, lexer.textEscaped);
+					text = true;
+					break;
+				case Lexer::TOKEN_CDATA:
+					AddText(open.back(), lexer.text, false);
+					text = true;
+					break;
+				case Lexer::TOKEN_START:
+					if(!text)	AddText(open.back(), Span(), false);
+					text = false;
+					if(!lexer.name.empty()){
+						Tag* child = new (open.back()->arena) Tag();
+						child->arena = open.back()->arena;
+						child->atoms = open.back()->atoms;
+						SetName(child, lexer.name);
+						SetAttributes(child, lexer);
+						open.back()->addChild(child);
+						if(!lexer.selfClosing){
+							open.push_back(child);
+						}
+					}
+					break;
+				case Lexer::TOKEN_END:
+					if(!text)	AddText(open.back(), Span(), false);
+					text = false;
+					//end tags which do not match the open tag are ignored
+					if(lexer.name.equals(open.back()->name)){
+						open.pop_back();
+						if(open.empty())	return false;
+					}
+					break;
+				case Lexer::TOKEN_DECLARATION:
+				case Lexer::TOKEN_NONE:
+				case Lexer::TOKEN_MORE:
+					break;
+			}
+			return true;
+		}
+		
+	private:
+		std::vector<Tag*> open;
+		bool text;
+	};
+	
+	//Builds a document one token at a time, the declaration and every top level tag.
+	//If first == false some of the document was already read, so a declaration is neither read nor created.
+	class DocumentBuilder{
+	public:
+		DocumentBuilder(Document& Output, bool First = true):output(Output), first(First){}
+		
+		//Start on a new document.
+		void reset(bool First = true){
+			content = ContentBuilder();
+			first = First;
+		}
+		
+		void add(Lexer::Token token, const Lexer& lexer){
+			if(!content.closed()){
+				content.add(token, lexer);
+			}else if(token == Lexer::TOKEN_DECLARATION){
+				if(first){
+					output.declaration = new (output.arena) Tag("?xml");
+					output.declaration->arena = output.arena;
+					output.declaration->atoms = output.atoms;
+					output.declaration->setName("?xml");
+					SetAttributes(output.declaration, lexer);
+					first = false;
+				}
+			}else if(token == Lexer::TOKEN_START && !lexer.name.empty()){
+				if(first){
+					output.createDeclaration();
+					first = false;
+				}
+				Tag* tag = new (output.arena) Tag();
+				tag->arena = output.arena;
+				tag->atoms = output.atoms;
+				SetName(tag, lexer.name);
+				SetAttributes(tag, lexer);
+				output.root->addChild(tag);
+				if(!lexer.selfClosing){
+					content.reset(tag);
+				}
+			}
+		}
+		
+	private:
+		Document& output;
+		bool first;
+		ContentBuilder content;
+	};
+	
+	//Read the content of the tag with a ContentBuilder, until its end tag or the end of the source.
+	template<class Source>
+	void ReadContent(Tag* tag, Source& source, Lexer& lexer){
+		ContentBuilder builder(tag);
+		Lexer::Token token;
+		while((token = source.next(lexer)) != Lexer::TOKEN_NONE && token != Lexer::TOKEN_MORE && builder.add(token, lexer)){}
+	}
+	
+	//Read the declaration and every top level tag into the document with a DocumentBuilder.
+	template<class Source>
+	void ReadDocument(Document& document, Source& source, Lexer& lexer, bool first = true){
+		DocumentBuilder builder(document, first);
+		Lexer::Token token;
+		while((token = source.next(lexer)) != Lexer::TOKEN_NONE){
+			builder.add(token, lexer);
+		}
+	}
+	
+	//The wall clock, in seconds.
+	double StatsSeconds();
+	
+	//A clock cheap enough to read around every token, the time stamp counter where there is one.
+	//Its units are converted to seconds for every document, against StatsSeconds.
+	inline unsigned long long StatsTicks(){
+#ifdef XML_STATS_RDTSC
+		return __rdtsc();
+#else
+		return (unsigned long long)(StatsSeconds() * 1e9);
+#endif
+	}
+	
+	//The time of a parse from its construction, and the ticks spent in each phase.
+	class ParseTimer{
+	public:
+		unsigned long long tokenize;
+		unsigned long long unescape;
+		unsigned long long build;
+		
+		ParseTimer():tokenize(0), unescape(0), build(0), startSeconds(StatsSeconds()), startTicks(StatsTicks()){}
+		
+		//Set the times of the statistics, the time since the start is split between the phases.
+		void finish(ParseStats& stats) const;
+		
+	private:
+		double startSeconds;
+		unsigned long long startTicks;
+	};
+	
+	//The number of escape strings in text which is about to be decoded.
+	std::size_t CountEntities(const Span& text);
+	
+	//Count what the tree of the document holds, then keep the statistics for this thread, add them to the total and call the callback.
+	void RecordParseStats(const Document& document, ParseStats& stats);
+	
+	//Read like ReadDocument, timing every token, and record the statistics of the document, which was read from length bytes.
+	template<class Source>
+	void ReadDocumentWithStats(Document& document, Source& source, Lexer& lexer, std::size_t length){
+		ParseStats stats;
+		ParseTimer timer;
+		DocumentBuilder builder(document);
+		unsigned long long last = StatsTicks();
+		for(;;){
+			const Lexer::Token token = source.next(lexer);
+			const unsigned long long now = StatsTicks();
+			timer.tokenize += now - last;
+			if(token == Lexer::TOKEN_NONE){
+				break;
+			}
+			builder.add(token, lexer);
+			last = StatsTicks();
+			if(token == Lexer::TOKEN_TEXT && lexer.textEscaped){
+				timer.unescape += last - now;
+				stats.entities += CountEntities(lexer.text);
+				last = StatsTicks();
+			}else{
+				timer.build += last - now;
+			}
+		}
+		stats.bytes = length;
+		timer.finish(stats);
+		RecordParseStats(document, stats);
+	}
+	
+}; //end namespace XML
+
+#endif //_XML_BUILDER_H
@@ -0,0 +1,363 @@
+#include "XMLCache.h"
+#include "XMLFile.h"
+#include "XMLBuilder.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define XML_USE_STAT
+#include <sys/stat.h>
+#endif
+
+#ifdef XML_CPP11
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+namespace XML{
+
+//-----------------------------------HANDLE-----------------------------------------------//
+	
+	//A version of a document, destroyed with the last handle to it.
+	struct DocumentHandle::Shared{
+		Document document;
+		FileSignature signature;
+		unsigned long version;
+#ifdef XML_CPP11
+		std::atomic<unsigned long> references;
+#else
+		unsigned long references;
+#endif
+		
+		Shared():version(0), references(1){}
+		
+		~Shared(){
+			document.deleteTags();
+		}
+	};
+	
+	DocumentHandle::DocumentHandle():shared(NULL){}
+	
+	DocumentHandle::DocumentHandle(Shared* Shared):shared(Shared){}
+	
+	DocumentHandle::DocumentHandle(const DocumentHandle& other):shared(other.shared){
+		if(shared != NULL){
+			++shared->references;
+		}
+	}
+	
+	DocumentHandle& DocumentHandle::operator=(const DocumentHandle& other){
+		if(other.shared != NULL){
+			++other.shared->references;
+		}
+		release();
+		shared = other.shared;
+		return *this;
+	}
+	
+	DocumentHandle::~DocumentHandle(){
+		release();
+	}
+	
+	void DocumentHandle::release(){
+		if(shared != NULL && --shared->references == 0){
+			delete shared;
+		}
+		shared = NULL;
+	}
+	
+	const Document& DocumentHandle::document() const{
+		return shared->document;
+	}
+	
+	const FileSignature& DocumentHandle::signature() const{
+		return shared->signature;
+	}
+	
+	unsigned long DocumentHandle::version() const{
+		return shared->version;
+	}
+	
+//-----------------------------------WORKER-----------------------------------------------//
+	
+	//A file of the cache.
+	struct DocumentCache::Entry{
+		//the version handed out
+		DocumentHandle current;
+		//the file as it was last seen, which can be newer than the version if only its time changed
+		FileSignature signature;
+		//true while the first version is read, get waits for it
+		bool loading;
+		//true while the file is checked, get does not wait for it
+		bool checking;
+		//true if the entry was removed while it was read or checked, the thread doing that deletes it
+		bool removed;
+		
+		Entry():loading(true), checking(false), removed(false){}
+	};
+	
+	class DocumentCache::Worker{
+	public:
+#ifdef XML_CPP11
+		std::mutex lock;
+		//notified when a file has been read for the first time, and when the thread has to stop
+		std::condition_variable changed;
+		std::thread thread;
+		bool stopping;
+		
+		Worker():stopping(false){}
+#endif
+	};
+	
+	//Holds the lock of the cache while it is in scope, without C++11 there is nothing to lock.
+	class DocumentCache::Lock{
+	public:
+#ifdef XML_CPP11
+		std::unique_lock<std::mutex> guard;
+		
+		Lock(Worker* worker):guard(worker->lock){}
+		void lock(){	guard.lock();	}
+		void unlock(){	guard.unlock();	}
+#else
+		Lock(Worker*){}
+		void lock(){}
+		void unlock(){}
+#endif
+	};
+	
+//-----------------------------------CACHE-----------------------------------------------//
+	
+	//The FNV-1a hash of a buffer.
+	static unsigned long long HashContent(const char* data, std::size_t length){
+		unsigned long long hash = 14695981039346656037ULL;
+		for(std::size_t i = 0; i < length; ++i){
+			hash ^= (unsigned char)data[i];
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+	
+	DocumentCache::DocumentCache(double checkInterval, bool UseArena):useArena(UseArena), worker(new Worker()){
+#ifdef XML_CPP11
+		if(checkInterval > 0){
+			const std::chrono::duration<double> interval(checkInterval);
+			worker->thread = std::thread([this, interval](){
+				std::unique_lock<std::mutex> guard(worker->lock);
+				while(!worker->changed.wait_for(guard, interval, [this](){	return worker->stopping;	})){
+					guard.unlock();
+					refresh();
+					guard.lock();
+				}
+			});
+		}
+#else
+		(void)checkInterval;
+#endif
+	}
+	
+	DocumentCache::~DocumentCache(){
+#ifdef XML_CPP11
+		if(worker->thread.joinable()){
+			{
+				std::lock_guard<std::mutex> guard(worker->lock);
+				worker->stopping = true;
+			}
+			worker->changed.notify_all();
+			worker->thread.join();
+		}
+#endif
+		clear();
+		delete worker;
+	}
+	
+	bool DocumentCache::Signature(const std::string& path, FileSignature& signature, bool content){
+#ifdef XML_USE_STAT
+		struct stat info;
+		if(stat(path.c_str(), &info) != 0){
+			return false;
+		}
+		signature.size = (unsigned long long)info.st_size;
+#if defined(__APPLE__)
+		signature.modified = (long long)info.st_mtimespec.tv_sec * 1000000000LL + info.st_mtimespec.tv_nsec;
+#elif defined(__linux__)
+		signature.modified = (long long)info.st_mtim.tv_sec * 1000000000LL + info.st_mtim.tv_nsec;
+#else
+		signature.modified = (long long)info.st_mtime * 1000000000LL;
+#endif
+		if(!content){
+			return true;
+		}
+#endif
+		MappedFile file;
+		if(!file.open(path)){
+			return false;
+		}
+		signature.size = file.size();
+		signature.hash = HashContent(file.data(), file.size());
+		return true;
+	}
+	
+	DocumentHandle DocumentCache::read(const std::string& path, unsigned long version) const{
+		//the time is read before the content, so a change made while reading is seen by the next check
+		FileSignature signature;
+		if(!Signature(path, signature, false)){
+			return DocumentHandle();
+		}
+		MappedFile file;
+		if(!file.open(path)){
+			return DocumentHandle();
+		}
+		signature.size = file.size();
+		signature.hash = HashContent(file.data(), file.size());
+		
+		DocumentHandle::Shared* shared = new DocumentHandle::Shared();
+		Document document = Document::FromBuffer(file.data(), file.size(), "_root", useArena);
+		shared->document.swap(document);
+		shared->signature = signature;
+		shared->version = version;
+		if(shared->document.declaration != NULL){
+			BuildIndexes(shared->document.declaration);
+		}
+		BuildIndexes(shared->document.root);
+		return DocumentHandle(shared);
+	}
+	
+	bool DocumentCache::Release(Entry* entry){
+		if(entry->removed){
+			delete entry;
+			return true;
+		}
+		return false;
+	}
+	
+	DocumentHandle DocumentCache::get(const std::string& path){
+		Lock guard(worker);
+		std::map<std::string, Entry*>::iterator it;
+		while((it = entries.find(path)) != entries.end() && it->second->loading){
+#ifdef XML_CPP11
+			worker->changed.wait(guard.guard);
+#endif
+		}
+		if(it != entries.end()){
+			return it->second->current;
+		}
+		
+		//the first read, anyone else asking for the file waits for it
+		Entry* entry = new Entry();
+		entries[path] = entry;
+		guard.unlock();
+		DocumentHandle handle = read(path, 1);
+		guard.lock();
+		entry->loading = false;
+		if(!Release(entry)){
+			if(handle.valid()){
+				entry->current = handle;
+				entry->signature = handle.signature();
+			}else{
+				entries.erase(path);
+				delete entry;
+			}
+		}
+#ifdef XML_CPP11
+		worker->changed.notify_all();
+#endif
+		return handle;
+	}
+	
+	bool DocumentCache::check(const std::string& path, Entry* entry){
+		FileSignature seen;
+		{
+			Lock guard(worker);
+			seen = entry->signature;
+		}
+		FileSignature signature;
+		if(!Signature(path, signature, false)){
+			return false;
+		}
+		//without modification times the content is always hashed
+		if(signature.modified != 0 && signature.modified == seen.modified && signature.size == seen.size){
+			return false;
+		}
+		if(!Signature(path, signature, true)){
+			return false;
+		}
+		if(signature.hash == seen.hash && signature.size == seen.size){
+			//touched but not changed
+			Lock guard(worker);
+			entry->signature.modified = signature.modified;
+			return false;
+		}
+		
+		unsigned long version;
+		{
+			Lock guard(worker);
+			version = entry->current.version() + 1;
+		}
+		DocumentHandle handle = read(path, version);
+		if(!handle.valid()){
+			return false;
+		}
+		Lock guard(worker);
+		entry->current = handle;
+		entry->signature = handle.signature();
+		return true;
+	}
+	
+	std::size_t DocumentCache::refresh(){
+		//the files are taken while the lock is held, and checked without it
+		std::vector<std::pair<std::string, Entry*> > files;
+		{
+			Lock guard(worker);
+			for(std::map<std::string, Entry*>::iterator it = entries.begin(); it != entries.end(); ++it){
+				if(!it->second->loading && !it->second->checking){
+					it->second->checking = true;
+					files.push_back(*it);
+				}
+			}
+		}
+		
+		std::size_t swapped = 0;
+		for(std::size_t i = 0; i < files.size(); ++i){
+			if(check(files[i].first, files[i].second)){
+				++swapped;
+			}
+			Lock guard(worker);
+			files[i].second->checking = false;
+			Release(files[i].second);
+		}
+		return swapped;
+	}
+	
+	void DocumentCache::remove(const std::string& path){
+		Lock guard(worker);
+		std::map<std::string, Entry*>::iterator it = entries.find(path);
+		if(it == entries.end()){
+			return;
+		}
+		if(it->second->loading || it->second->checking){
+			it->second->removed = true;
+		}else{
+			delete it->second;
+		}
+		entries.erase(it);
+	}
+	
+	void DocumentCache::clear(){
+		Lock guard(worker);
+		for(std::map<std::string, Entry*>::iterator it = entries.begin(); it != entries.end(); ++it){
+			if(it->second->loading || it->second->checking){
+				it->second->removed = true;
+			}else{
+				delete it->second;
+			}
+		}
+		entries.clear();
+	}
+	
+	std::size_t DocumentCache::size() const{
+		Lock guard(worker);
+		return entries.size();
+	}
+	
+}; //end namespace XML
@@ -0,0 +1,108 @@
+#ifndef _XML_CACHE_H
+#define _XML_CACHE_H
+
+#include "XML.h"
+#include <map>
+
+namespace XML{
+	
+	//What a file looked like when it was read: its modification time, its size and a hash of its content.
+	struct FileSignature{
+		long long modified;			//in nanoseconds where the platform has them, 0 if it has no modification times
+		unsigned long long size;
+		unsigned long long hash;	//FNV-1a of the content
+		
+		FileSignature():modified(0), size(0), hash(0){}
+	};
+	
+	//A shared, read only handle to a document of a DocumentCache, which is cheap to copy.
+	//The document stays alive as long as a handle to it does, even after the cache has swapped in a newer version
+	//or has been destroyed, so a reader keeps a consistent tree for as long as it holds the handle.
+	//The tags have their indexes built, so any number of threads can search them at once, but they must not be changed.
+	class DocumentHandle{
+	public:
+		DocumentHandle();
+		DocumentHandle(const DocumentHandle& other);
+		DocumentHandle& operator=(const DocumentHandle& other);
+		~DocumentHandle();
+		
+		//False if the file could not be read.
+		bool valid() const{	return shared != NULL;	}
+		
+		const Document& document() const;
+		const Document& operator*() const{	return document();	}
+		const Document* operator->() const{	return &document();	}
+		
+		//The file as it was read, and the number of times it has been read by the cache, 1 for the first version.
+		const FileSignature& signature() const;
+		unsigned long version() const;
+		
+	private:
+		struct Shared;
+		Shared* shared;
+		
+		explicit DocumentHandle(Shared* Shared);
+		void release();
+		
+		friend class DocumentCache;
+	};
+	
+	//Documents read from files, read once and shared by everyone who asks for the same path.
+	//A file is read the first time it is asked for, by the thread which asks; other threads asking for it meanwhile wait for that read
+	//instead of reading it again. After that the files are checked for changes, on a thread of the cache every checkInterval seconds,
+	//or when refresh is called. A file whose modification time or size changed is hashed, and read again only if its content changed.
+	//The new version is read and indexed off to the side and swapped in at once: get returns the old version until then,
+	//and handles to the old version stay valid. If a changed file can not be read the old version is kept.
+	//get only waits for the first read of a file, and otherwise only holds a lock for as long as it takes to copy a handle.
+	//Without C++11 there is no thread, the files are checked when refresh is called.
+	class DocumentCache{
+	public:
+		//checkInterval == 0 does not start a thread, the files are then only checked by refresh.
+		//The documents are read into an arena, unless useArena is false.
+		DocumentCache(double checkInterval = 1, bool useArena = true);
+		~DocumentCache();
+		
+		//The document read from the file, not valid if it could not be read.
+		//Files which could not be read are not kept, they are tried again by the next get.
+		DocumentHandle get(const std::string& path);
+		
+		//Check every file now, on the calling thread, and read again the ones which changed.
+		//Returns the number of documents which were swapped for a new version.
+		std::size_t refresh();
+		
+		//Forget the file, handles to it stay valid.
+		void remove(const std::string& path);
+		void clear();
+		
+		//The number of files kept.
+		std::size_t size() const;
+		
+		//Read the signature of a file, false if it could not be read.
+		//If content is false only the modification time and the size are read, and the hash is left alone.
+		static bool Signature(const std::string& path, FileSignature& signature, bool content);
+		
+	private:
+		struct Entry;
+		class Worker;
+		class Lock;
+		
+		std::map<std::string, Entry*> entries;
+		bool useArena;
+		//the lock, and the thread which checks the files
+		Worker* worker;
+		
+		//Read the file into a new version, with the indexes of its tags built, not valid if it could not be read.
+		DocumentHandle read(const std::string& path, unsigned long version) const;
+		//Check one file, which the calling thread is checking, returns true if a new version was swapped in.
+		bool check(const std::string& path, Entry* entry);
+		//Delete the entry if it was removed while it was read or checked, the lock is held.
+		static bool Release(Entry* entry);
+		
+		//not copyable
+		DocumentCache(const DocumentCache& other);
+		DocumentCache& operator=(const DocumentCache& other);
+	};
+	
+}; //end namespace XML
+
+#endif //_XML_CACHE_H
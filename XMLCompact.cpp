@@ -0,0 +1,657 @@
+#include "XMLCompact.h"
+#include "XMLLexer.h"
+#include "XMLFile.h"
+#include "XMLArena.h"
+#include <cstring>
+#include <fstream>
+
+namespace XML{
+	
+	const unsigned int CompactDocument::None;
+	const unsigned int CompactDocument::SnapshotVersion;
+	
+//-----------------------------------BUILDER-----------------------------------------------//
+	
+	//Appends nodes to a compact document, linking each one as the last child of its parent.
+	class CompactDocument::Builder{
+	public:
+		Builder(CompactDocument& Output):output(Output){
+			output.nameStorage.assign(2, 0); //NoAtom
+		}
+		
+		Atom intern(const char* name, std::size_t length){
+			const Atom atom = output.atomTable.intern(name, length);
+			if(atom * 2 == output.nameStorage.size()){ //a new name
+				output.nameStorage.push_back(output.poolStorage.length());
+				output.nameStorage.push_back(length);
+				output.poolStorage.append(name, length);
+			}
+			return atom;
+		}
+		
+		unsigned int addNode(XML_OBJECT_TYPE type, unsigned int parent){
+			const unsigned int index = output.nodeStorage.size();
+			CompactNode node;
+			node.type = (unsigned char)type;
+			node.selfClosing = 0;
+			node.flags = 0;
+			node.name = NoAtom;
+			node.data = (type == XML_TAG) ? output.attributeStorage.size() : output.poolStorage.length();
+			node.length = 0;
+			node.parent = parent;
+			node.firstChild = None;
+			node.next = None;
+			output.nodeStorage.push_back(node);
+			lastChild.push_back(None);
+			emptyLast.push_back(0);
+			
+			if(parent != None){
+				if(emptyLast[parent]){
+					output.nodeStorage[index].flags |= COMPACT_EMPTY_BEFORE;
+					emptyLast[parent] = 0;
+				}
+				if(lastChild[parent] == None){
+					output.nodeStorage[parent].firstChild = index;
+				}else{
+					output.nodeStorage[lastChild[parent]].next = index;
+				}
+				lastChild[parent] = index;
+			}
+			return index;
+		}
+		
+		unsigned int addTag(unsigned int parent, const char* name, std::size_t length){
+			const unsigned int index = addNode(XML_TAG, parent);
+			output.nodeStorage[index].name = intern(name, length);
+			return index;
+		}
+		
+		//Attributes have to be added right after their tag.
+		void addAttribute(unsigned int tag, const char* name, std::size_t nameLength, const char* value, std::size_t valueLength){
+			CompactAttribute attribute;
+			attribute.name = intern(name, nameLength);
+			attribute.value = output.poolStorage.length();
+			attribute.length = valueLength;
+			output.poolStorage.append(value, valueLength);
+			//a repeated attribute replaces the value, like it does in a tag
+			CompactNode& node = output.nodeStorage[tag];
+			for(unsigned int i = node.data; i < node.data + node.length; ++i){
+				if(output.attributeStorage[i].name == attribute.name){
+					output.attributeStorage[i] = attribute;
+					return;
+				}
+			}
+			output.attributeStorage.push_back(attribute);
+			++node.length;
+		}
+		
+		void setAttributes(unsigned int tag, const Lexer& lexer){
+			for(unsigned int i = 0; i < lexer.attributes.size(); ++i){
+				const Span& name = lexer.attributes[i].first;
+				const Span& value = lexer.attributes[i].second;
+				addAttribute(tag, name.begin, name.end - name.begin, value.begin, value.end - value.begin);
+			}
+			output.nodeStorage[tag].selfClosing = lexer.selfClosing ? 1 : 0;
+		}
+		
+		void addString(unsigned int parent, XML_OBJECT_TYPE type, const std::string& text){
+			if(type == XML_STRING && text.empty() && !emptyLast[parent]){
+				emptyLast[parent] = 1;
+				return;
+			}
+			const unsigned int index = addNode(type, parent);
+			output.poolStorage.append(text);
+			output.nodeStorage[index].length = text.length();
+		}
+		
+		//Add text to the tag, appending it to the last child if that is a string, like AddText.
+		void addText(unsigned int parent, const Span& text, bool deEscape){
+			unsigned int index = lastChild[parent];
+			const bool joined = !emptyLast[parent] && index != None && output.nodeStorage[index].type == XML_STRING;
+			if(text.empty()){
+				//an empty string is only a flag, unless it is appended to a string
+				if(!joined){
+					emptyLast[parent] = 1;
+				}
+				return;
+			}
+			if(!joined){
+				emptyLast[parent] = 0;
+				index = addNode(XML_STRING, parent);
+			}else if(output.nodeStorage[index].data + output.nodeStorage[index].length != output.poolStorage.length()){
+				//something was added to the pool since, the text is moved to the end so it stays in one piece
+				const std::string moved = output.poolStorage.substr(output.nodeStorage[index].data, output.nodeStorage[index].length);
+				output.nodeStorage[index].data = output.poolStorage.length();
+				output.poolStorage.append(moved);
+			}
+			if(deEscape){
+				AppendDeEscaped(output.poolStorage, text.begin, text.end);
+			}else{
+				output.poolStorage.append(text.begin, text.end);
+			}
+			output.nodeStorage[index].length = output.poolStorage.length() - output.nodeStorage[index].data;
+		}
+		
+		void copyTag(unsigned int index, const Tag& tag){
+			for(Attributes::const_iterator it = tag.attributes.begin(); it != tag.attributes.end(); ++it){
+				addAttribute(index, it->first.data(), it->first.length(), it->second.data(), it->second.length());
+			}
+			output.nodeStorage[index].selfClosing = tag.selfClosing ? 1 : 0;
+		}
+		
+		//Copy the tree of the tag under the node, in document order.
+		void copyChildren(unsigned int index, const Tag& tag){
+			//the open tags, their nodes and the position of their next child
+			std::vector<std::pair<const Tag*, std::pair<unsigned int, unsigned int> > > open(1, std::make_pair(&tag, std::make_pair(index, 0u)));
+			while(!open.empty()){
+				const Tag* current = open.back().first;
+				const unsigned int parent = open.back().second.first;
+				const unsigned int i = open.back().second.second++;
+				if(i >= current->children.size()){
+					open.pop_back();
+					continue;
+				}
+				const Object* child = current->children[i];
+				if(child->getType() == XML_TAG){
+					const unsigned int childIndex = addTag(parent, child->name.data(), child->name.length());
+					copyTag(childIndex, *(const Tag*)child);
+					open.push_back(std::make_pair((const Tag*)child, std::make_pair(childIndex, 0u)));
+				}else{
+					addString(parent, child->getType(), child->name);
+				}
+			}
+		}
+		
+		//Flag the tags which end with an empty string, once every node is added.
+		void finish(){
+			for(unsigned int i = 0; i < emptyLast.size(); ++i){
+				if(emptyLast[i]){
+					output.nodeStorage[i].flags |= COMPACT_EMPTY_LAST;
+				}
+			}
+		}
+		
+		//Read the tokens like ReadDocument and ReadContent do.
+		void parse(const char* data, std::size_t length);
+		
+	private:
+		CompactDocument& output;
+		std::vector<unsigned int> lastChild;
+		//1 if the last child of the node is an empty string which has no node of its own
+		std::vector<unsigned char> emptyLast;
+	};
+	
+	void CompactDocument::Builder::parse(const char* data, std::size_t length){
+		addTag(None, "_root", 5);
+		
+		std::vector<unsigned int> open;
+		bool first = true;
+		bool text = false;
+		
+		Lexer lexer;
+		lexer.reset(data, data + length);
+		Lexer::Token token;
+		while((token = lexer.next()) != Lexer::TOKEN_NONE){
+			if(open.empty()){ //top level
+				if(token == Lexer::TOKEN_DECLARATION){
+					if(first){
+						output.declarationNode = addTag(None, "?xml", 4);
+						setAttributes(output.declarationNode, lexer);
+						output.nodeStorage[output.declarationNode].selfClosing = 0;
+						first = false;
+					}
+				}else if(token == Lexer::TOKEN_START && !lexer.name.empty()){
+					if(first){ //like Document::createDeclaration
+						output.declarationNode = addTag(None, "?xml", 4);
+						addAttribute(output.declarationNode, "version", 7, "1.0", 3);
+						first = false;
+					}
+					const unsigned int tag = addTag(0, lexer.name.begin, lexer.name.end - lexer.name.begin);
+					setAttributes(tag, lexer);
+					if(!lexer.selfClosing){
+						open.push_back(tag);
+						text = false;
+					}
+				}
+				continue;
+			}
+			
+			switch(token){
+				case Lexer::TOKEN_TEXT:
+					addText(open.back(), lexer.text, lexer.textEscaped);
+					text = true;
+					break;
+				case Lexer::TOKEN_CDATA:
+					addText(open.back(), lexer.text, false);
+					text = true;
+					break;
+				case Lexer::TOKEN_START:
+					if(!text)	addText(open.back(), Span(), false);
+					text = false;
+					if(!lexer.name.empty()){
+						const unsigned int tag = addTag(open.back(), lexer.name.begin, lexer.name.end - lexer.name.begin);
+						setAttributes(tag, lexer);
+						if(!lexer.selfClosing){
+							open.push_back(tag);
+						}
+					}
+					break;
+				case Lexer::TOKEN_END:{
+					if(!text)	addText(open.back(), Span(), false);
+					text = false;
+					//end tags which do not match the open tag are ignored
+					const Atom openAtom = output.nodeStorage[open.back()].name;
+					const std::size_t openLength = output.nameStorage[openAtom * 2 + 1];
+					if(openLength == (std::size_t)(lexer.name.end - lexer.name.begin) && memcmp(output.poolStorage.data() + output.nameStorage[openAtom * 2], lexer.name.begin, openLength) == 0){
+						open.pop_back();
+					}
+					break;
+				}
+				case Lexer::TOKEN_DECLARATION:
+				case Lexer::TOKEN_NONE:
+				case Lexer::TOKEN_MORE:
+					break;
+			}
+		}
+	}
+	
+//-----------------------------------CURSOR-----------------------------------------------//
+	
+	StringRef CompactDocument::Cursor::text() const{
+		const CompactNode& n = node();
+		return (n.type == XML_TAG) ? StringRef() : StringRef(document->pool + n.data, n.length);
+	}
+	
+	StringRef CompactDocument::Cursor::attributeName(unsigned int i) const{
+		return document->name(document->attributes[node().data + i].name);
+	}
+	
+	StringRef CompactDocument::Cursor::attributeValue(unsigned int i) const{
+		const CompactAttribute& attribute = document->attributes[node().data + i];
+		return StringRef(document->pool + attribute.value, attribute.length);
+	}
+	
+	bool CompactDocument::Cursor::attribute(const std::string& attributeName, StringRef& value) const{
+		const Atom atom = document->atomTable.find(attributeName);
+		if(atom != NoAtom){
+			for(unsigned int i = 0; i < attributeCount(); ++i){
+				if(document->attributes[node().data + i].name == atom){
+					value = attributeValue(i);
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+	
+	CompactDocument::Cursor CompactDocument::Cursor::childWithName(Atom childAtom) const{
+		unsigned int child = node().firstChild;
+		while(child != None && (document->nodes[child].name != childAtom || document->nodes[child].type != XML_TAG)){
+			child = document->nodes[child].next;
+		}
+		return Cursor(document, child);
+	}
+	
+	CompactDocument::Cursor CompactDocument::Cursor::childWithName(const std::string& childName) const{
+		const Atom atom = document->atomTable.find(childName);
+		return (atom == NoAtom) ? Cursor(document, None) : childWithName(atom);
+	}
+	
+	CompactDocument::Cursor CompactDocument::Cursor::nextWithName() const{
+		const Atom atom = node().name;
+		unsigned int sibling = node().next;
+		while(sibling != None && (document->nodes[sibling].name != atom || document->nodes[sibling].type != XML_TAG)){
+			sibling = document->nodes[sibling].next;
+		}
+		return Cursor(document, sibling);
+	}
+	
+//-----------------------------------SNAPSHOT-----------------------------------------------//
+	
+	//The start of a snapshot. The tables follow it in this order, each one as it is in memory:
+	//nodeCount CompactNodes, attributeCount CompactAttributes, nameCount pairs of unsigned ints, and the pool,
+	//padded with zeros to a multiple of 4 bytes. Every field is an unsigned int, so every table stays aligned.
+	struct SnapshotHeader{
+		char magic[8];
+		unsigned int version;
+		//SnapshotByteOrder as written, a snapshot from a machine with another byte order does not match
+		unsigned int byteOrder;
+		//the size of a node and of an attribute, in case the structures change without the version
+		unsigned int nodeSize;
+		unsigned int attributeSize;
+		unsigned int nodeCount;
+		unsigned int attributeCount;
+		//the number of atoms, with NoAtom
+		unsigned int nameCount;
+		unsigned int poolSize;
+		unsigned int declarationNode;
+		//a Fletcher checksum of the tables, the sum of their words and the sum of those sums
+		unsigned int sum;
+		unsigned int sumOfSums;
+		//0, for a later version
+		unsigned int reserved;
+	};
+	
+	static const char SnapshotMagic[8] = {'S', 'X', 'M', 'L', 'S', 'N', 'A', 'P'};
+	static const unsigned int SnapshotByteOrder = 0x01020304;
+	
+	static std::size_t SnapshotPadding(std::size_t poolSize){
+		return (sizeof(unsigned int) - poolSize % sizeof(unsigned int)) % sizeof(unsigned int);
+	}
+	
+	//Add words to a Fletcher checksum.
+	static void SnapshotChecksum(const unsigned int* words, std::size_t count, unsigned int& sum, unsigned int& sumOfSums){
+		unsigned int a = sum;
+		unsigned int b = sumOfSums;
+		for(std::size_t i = 0; i < count; ++i){
+			a += words[i];
+			b += a;
+		}
+		sum = a;
+		sumOfSums = b;
+	}
+	
+	bool CompactDocument::writeSnapshot(std::ostream& os) const{
+		const std::size_t nameCount = atomTable.size() + 1;
+		const std::size_t padding = SnapshotPadding(poolSize);
+		const char zeros[sizeof(unsigned int)] = {0, 0, 0, 0};
+		
+		SnapshotHeader header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, SnapshotMagic, sizeof(header.magic));
+		header.version = SnapshotVersion;
+		header.byteOrder = SnapshotByteOrder;
+		header.nodeSize = sizeof(CompactNode);
+		header.attributeSize = sizeof(CompactAttribute);
+		header.nodeCount = nodeCount;
+		header.attributeCount = attributeCount;
+		header.nameCount = nameCount;
+		header.poolSize = poolSize;
+		header.declarationNode = declarationNode;
+		
+		//the pool is checksummed with its padding, as it is read back
+		header.sum = 1;
+		SnapshotChecksum((const unsigned int*)nodes, nodeCount * sizeof(CompactNode) / sizeof(unsigned int), header.sum, header.sumOfSums);
+		SnapshotChecksum((const unsigned int*)attributes, attributeCount * sizeof(CompactAttribute) / sizeof(unsigned int), header.sum, header.sumOfSums);
+		SnapshotChecksum(names, nameCount * 2, header.sum, header.sumOfSums);
+		const std::size_t wholeWords = poolSize / sizeof(unsigned int);
+		for(std::size_t i = 0; i < wholeWords; ++i){
+			//the pool of a document which was read is not aligned to words
+			unsigned int word;
+			memcpy(&word, pool + i * sizeof(unsigned int), sizeof(word));
+			SnapshotChecksum(&word, 1, header.sum, header.sumOfSums);
+		}
+		if(padding > 0){
+			unsigned int word = 0;
+			memcpy(&word, pool + wholeWords * sizeof(unsigned int), poolSize - wholeWords * sizeof(unsigned int));
+			SnapshotChecksum(&word, 1, header.sum, header.sumOfSums);
+		}
+		
+		os.write((const char*)&header, sizeof(header));
+		os.write((const char*)nodes, nodeCount * sizeof(CompactNode));
+		os.write((const char*)attributes, attributeCount * sizeof(CompactAttribute));
+		os.write((const char*)names, nameCount * 2 * sizeof(unsigned int));
+		os.write(pool, poolSize);
+		os.write(zeros, padding);
+		return !os.fail();
+	}
+	
+	bool CompactDocument::saveSnapshot(const std::string& path) const{
+		std::ofstream file(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+		if(!file.is_open()){
+			return false;
+		}
+		if(!writeSnapshot(file)){
+			return false;
+		}
+		file.close();
+		return !file.fail();
+	}
+	
+	bool CompactDocument::attachSnapshot(const char* data, std::size_t length, bool verify){
+		if(length < sizeof(SnapshotHeader)){
+			return false;
+		}
+		const SnapshotHeader& header = *(const SnapshotHeader*)data;
+		if(memcmp(header.magic, SnapshotMagic, sizeof(header.magic)) != 0 || header.version != SnapshotVersion || header.byteOrder != SnapshotByteOrder){
+			return false;
+		}
+		if(header.nodeSize != sizeof(CompactNode) || header.attributeSize != sizeof(CompactAttribute) || header.nodeCount == 0 || header.nameCount == 0 || header.reserved != 0){
+			return false;
+		}
+		//counted in 64 bits, so a damaged header can not wrap around
+		const unsigned long long nodeBytes = (unsigned long long)header.nodeCount * sizeof(CompactNode);
+		const unsigned long long attributeBytes = (unsigned long long)header.attributeCount * sizeof(CompactAttribute);
+		const unsigned long long nameBytes = (unsigned long long)header.nameCount * 2 * sizeof(unsigned int);
+		const unsigned long long tableBytes = nodeBytes + attributeBytes + nameBytes + header.poolSize + SnapshotPadding(header.poolSize);
+		if(tableBytes != (unsigned long long)(length - sizeof(SnapshotHeader))){
+			return false;
+		}
+		
+		const char* tables = data + sizeof(SnapshotHeader);
+		nodes = (const CompactNode*)tables;
+		nodeCount = header.nodeCount;
+		attributes = (const CompactAttribute*)(tables + nodeBytes);
+		attributeCount = header.attributeCount;
+		names = (const unsigned int*)(tables + nodeBytes + attributeBytes);
+		pool = tables + nodeBytes + attributeBytes + nameBytes;
+		poolSize = header.poolSize;
+		declarationNode = header.declarationNode;
+		
+		if(verify){
+			unsigned int sum = 1;
+			unsigned int sumOfSums = 0;
+			SnapshotChecksum((const unsigned int*)tables, tableBytes / sizeof(unsigned int), sum, sumOfSums);
+			if(sum != header.sum || sumOfSums != header.sumOfSums){
+				return false;
+			}
+			//a matching checksum does not mean the snapshot was written by writeSnapshot, every reference is checked
+			if(declarationNode != None && declarationNode >= nodeCount){
+				return false;
+			}
+			for(std::size_t i = 0; i < header.nameCount; ++i){
+				if((unsigned long long)names[i * 2] + names[i * 2 + 1] > poolSize){
+					return false;
+				}
+			}
+			for(std::size_t i = 0; i < attributeCount; ++i){
+				if(attributes[i].name >= header.nameCount || (unsigned long long)attributes[i].value + attributes[i].length > poolSize){
+					return false;
+				}
+			}
+			for(std::size_t i = 0; i < nodeCount; ++i){
+				const CompactNode& node = nodes[i];
+				if(node.type > XML_TAG || node.name >= header.nameCount || (node.flags & ~(COMPACT_EMPTY_BEFORE | COMPACT_EMPTY_LAST)) != 0){
+					return false;
+				}
+				const unsigned long long end = (unsigned long long)node.data + node.length;
+				if(end > ((node.type == XML_TAG) ? attributeCount : poolSize)){
+					return false;
+				}
+				//children and siblings come after their node, so walking the tree always ends
+				if((node.parent != None && node.parent >= i) || (node.firstChild != None && (node.firstChild <= i || node.firstChild >= nodeCount)) || (node.next != None && (node.next <= i || node.next >= nodeCount))){
+					return false;
+				}
+			}
+		}
+		
+		//the atoms are given out in order, so interning the names again gives every one the atom it had
+		for(std::size_t i = 1; i < header.nameCount; ++i){
+			if(atomTable.intern(pool + names[i * 2], names[i * 2 + 1]) != i){
+				return false;
+			}
+		}
+		return true;
+	}
+	
+//-----------------------------------COMPACT-DOCUMENT-----------------------------------------------//
+	
+	CompactDocument::CompactDocument():nodes(NULL), nodeCount(0), attributes(NULL), attributeCount(0), pool(NULL), poolSize(0), names(NULL), declarationNode(None), source(NULL){}
+	
+	CompactDocument::~CompactDocument(){
+		if(source != NULL){
+			delete source;
+		}
+	}
+	
+	void CompactDocument::attach(){
+		//nothing is added after this, so the spare capacity is given back
+		std::vector<CompactNode>(nodeStorage).swap(nodeStorage);
+		std::vector<CompactAttribute>(attributeStorage).swap(attributeStorage);
+		std::string(poolStorage).swap(poolStorage);
+		
+		nodes = nodeStorage.empty() ? NULL : &nodeStorage[0];
+		nodeCount = nodeStorage.size();
+		attributes = attributeStorage.empty() ? NULL : &attributeStorage[0];
+		attributeCount = attributeStorage.size();
+		pool = poolStorage.data();
+		poolSize = poolStorage.length();
+		names = nameStorage.empty() ? NULL : &nameStorage[0];
+	}
+	
+	Tag* CompactDocument::newTag(unsigned int index, Tag* parent, Arena* arena, AtomTable* tagAtoms) const{
+		Tag* top = NULL;
+		//the node, and the tag and position of the child it becomes
+		std::vector<std::pair<unsigned int, std::pair<Tag*, unsigned int> > > open(1, std::make_pair(index, std::make_pair(parent, 0u)));
+		while(!open.empty()){
+			const unsigned int current = open.back().first;
+			Tag* owner = open.back().second.first;
+			const unsigned int slot = open.back().second.second;
+			open.pop_back();
+			
+			const CompactNode& node = nodes[current];
+			const StringRef tagName = name(node.name);
+			Tag* tag = new (arena) Tag();
+			tag->arena = arena;
+			tag->atoms = tagAtoms;
+			tag->parent = owner;
+			tag->name.assign(tagName.data, tagName.length);
+			if(tagAtoms != NULL){
+				tag->atom = tagAtoms->intern(tagName.data, tagName.length);
+			}
+			tag->attributes.reserve(node.length);
+			for(unsigned int i = node.data; i < node.data + node.length; ++i){
+				const StringRef attributeName = name(attributes[i].name);
+				std::string& value = (tagAtoms == NULL) ? tag->attributes.value(attributeName.data, attributeName.length) : tag->attributes.value(tagAtoms->shared(tagAtoms->intern(attributeName.data, attributeName.length)));
+				value.assign(pool + attributes[i].value, attributes[i].length);
+			}
+			tag->selfClosing = (node.selfClosing != 0);
+			if(top == NULL){
+				top = tag;
+			}else{
+				owner->children[slot] = tag;
+			}
+			
+			//strings are added right away, tags take their place once they are taken from the stack
+			for(unsigned int child = node.firstChild; child != None; child = nodes[child].next){
+				const CompactNode& childNode = nodes[child];
+				if(childNode.flags & COMPACT_EMPTY_BEFORE){
+					tag->children.push_back(new (arena) String("", tag));
+				}
+				if(childNode.type == XML_TAG){
+					open.push_back(std::make_pair(child, std::make_pair(tag, (unsigned int)tag->children.size())));
+					tag->children.push_back(NULL);
+				}else{
+					const std::string text(pool + childNode.data, childNode.length);
+					tag->children.push_back((childNode.type == XML_STRING) ? (Object*)new (arena) String(text, tag) : new (arena) Object(text, tag));
+				}
+			}
+			if(node.flags & COMPACT_EMPTY_LAST){
+				tag->children.push_back(new (arena) String("", tag));
+			}
+		}
+		return top;
+	}
+	
+	Tag* CompactDocument::toTag(unsigned int index) const{
+		return newTag(index, NULL, NULL, NULL);
+	}
+	
+	Document CompactDocument::toDocument() const{
+		Document output;
+		output.atoms = new AtomTable();
+		output.deleteTagsOnDestruction = Document::OwnedByDefault;
+		output.root = newTag(0, NULL, NULL, output.atoms);
+		if(declarationNode != None){
+			output.declaration = newTag(declarationNode, NULL, NULL, output.atoms);
+		}
+		return output;
+	}
+	
+	CompactDocument* CompactDocument::FromBuffer(const char* data, std::size_t length){
+		CompactDocument* output = new CompactDocument();
+		Builder builder(*output);
+		builder.parse(data, length);
+		builder.finish();
+		output->attach();
+		return output;
+	}
+	
+	CompactDocument* CompactDocument::FromFile(const std::string& path){
+		MappedFile file;
+		if(!file.open(path)){
+			return NULL;
+		}
+		return CompactDocument::FromBuffer(file.data(), file.size());
+	}
+	
+	CompactDocument* CompactDocument::FromSnapshot(const char* data, std::size_t length, bool verify){
+		CompactDocument* output = new CompactDocument();
+		if(((std::size_t)data % sizeof(unsigned int)) != 0){
+			//the tables are read in place as unsigned ints, so they are copied somewhere they can be
+			output->snapshotStorage.resize(length / sizeof(unsigned int) + 1);
+			memcpy(&output->snapshotStorage[0], data, length);
+			data = (const char*)&output->snapshotStorage[0];
+		}
+		if(!output->attachSnapshot(data, length, verify)){
+			delete output;
+			return NULL;
+		}
+		return output;
+	}
+	
+	CompactDocument* CompactDocument::FromSnapshotFile(const std::string& path, bool verify){
+		MappedFile* file = new MappedFile();
+		if(!file->open(path)){
+			delete file;
+			return NULL;
+		}
+		CompactDocument* output = new CompactDocument();
+		output->source = file;
+		if(!output->attachSnapshot(file->data(), file->size(), verify)){
+			delete output;
+			return NULL;
+		}
+		return output;
+	}
+	
+	CompactDocument* CompactDocument::FromTag(const Tag& tag){
+		CompactDocument* output = new CompactDocument();
+		Builder builder(*output);
+		const unsigned int root = builder.addTag(None, tag.name.data(), tag.name.length());
+		builder.copyTag(root, tag);
+		builder.copyChildren(root, tag);
+		builder.finish();
+		output->attach();
+		return output;
+	}
+	
+	CompactDocument* CompactDocument::FromDocument(const Document& document){
+		CompactDocument* output = new CompactDocument();
+		Builder builder(*output);
+		//the declaration comes right after the root, where reading puts it
+		const unsigned int root = (document.root != NULL) ? builder.addTag(None, document.root->name.data(), document.root->name.length()) : builder.addTag(None, "_root", 5);
+		if(document.declaration != NULL){
+			output->declarationNode = builder.addTag(None, document.declaration->name.data(), document.declaration->name.length());
+			builder.copyTag(output->declarationNode, *document.declaration);
+		}
+		if(document.root != NULL){
+			builder.copyTag(root, *document.root);
+			builder.copyChildren(root, *document.root);
+		}
+		builder.finish();
+		output->attach();
+		return output;
+	}
+	
+}; //end namespace XML
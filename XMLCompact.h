@@ -0,0 +1,177 @@
+#ifndef _XML_COMPACT_H
+#define _XML_COMPACT_H
+
+#include "XML.h"
+#include "XMLAtom.h"
+#include "XMLView.h"
+#include <ostream>
+
+namespace XML{
+	
+	//The flags of a CompactNode. Empty strings, which reading puts before every tag and end tag which does not follow text,
+	//are not stored as nodes, but as a flag on the node after them, or on their parent if they are its last child.
+	enum COMPACT_NODE_FLAG{
+		COMPACT_EMPTY_BEFORE = 1,	//an empty string comes before the node
+		COMPACT_EMPTY_LAST = 2		//an empty string is the last child of the tag
+	};
+	
+	//A node of a compact document, which refers to others by their position in the node array.
+	struct CompactNode{
+		unsigned char type;			//XML_TAG, XML_STRING or XML_OBJECT
+		unsigned char selfClosing;	//1 if the tag was read as <name/>
+		unsigned short flags;		//COMPACT_NODE_FLAGs
+		Atom name;					//the name of a tag, NoAtom for strings
+		unsigned int data;			//the first attribute of a tag, the offset of the text of a string in the pool
+		unsigned int length;		//the number of attributes of a tag, the length of the text of a string
+		unsigned int parent;
+		unsigned int firstChild;
+		unsigned int next;
+	};
+	
+	struct CompactAttribute{
+		Atom name;
+		unsigned int value;			//the offset of the value in the pool
+		unsigned int length;
+	};
+	
+	//A document stored as one array of nodes which link to their first child and next sibling by position,
+	//with every name and text in one pool of characters. It holds the same tree as a Document,
+	//but is much smaller and faster to walk, and it can not be changed.
+	//Cursors do not see the empty strings of the tree, toDocument and toTag put them back.
+	//Names are interned, each one is stored once and compared as an Atom.
+	//Text is stored decoded and attribute values as they are in the source, like Tag.
+	//The pool is limited to 4 GB.
+	class CompactDocument{
+	public:
+		//The position of no node.
+		static const unsigned int None = ~0u;
+		
+		//A position in a document, which is cheap to copy.
+		//Moving to a node that does not exist gives a cursor which is not valid().
+		class Cursor{
+		public:
+			Cursor():document(NULL), index(None){}
+			Cursor(const CompactDocument* Document, unsigned int Index):document(Document), index(Index){}
+			
+			bool valid() const{	return index != None;	}
+			unsigned int position() const{	return index;	}
+			const CompactNode& node() const{	return document->nodes[index];	}
+			
+			bool isTag() const{	return node().type == XML_TAG;	}
+			bool isString() const{	return node().type != XML_TAG;	}
+			
+			//The name of a tag.
+			Atom atom() const{	return node().name;	}
+			StringRef name() const{	return document->name(node().name);	}
+			//The text of a string.
+			StringRef text() const;
+			
+			unsigned int attributeCount() const{	return isTag() ? node().length : 0;	}
+			StringRef attributeName(unsigned int i) const;
+			StringRef attributeValue(unsigned int i) const;
+			//Set value to the value of the attribute, returns false if the tag does not have it.
+			bool attribute(const std::string& attributeName, StringRef& value) const;
+			
+			Cursor parent() const{	return Cursor(document, node().parent);	}
+			Cursor firstChild() const{	return Cursor(document, node().firstChild);	}
+			Cursor next() const{	return Cursor(document, node().next);	}
+			
+			//The first child tag with the name.
+			Cursor childWithName(Atom childAtom) const;
+			Cursor childWithName(const std::string& childName) const;
+			//The next sibling tag with the same name.
+			Cursor nextWithName() const;
+			
+			bool operator==(const Cursor& other) const{	return index == other.index && document == other.document;	}
+			bool operator!=(const Cursor& other) const{	return !(*this == other);	}
+			
+		private:
+			const CompactDocument* document;
+			unsigned int index;
+		};
+		
+		~CompactDocument();
+		
+		//The root holds every top level tag, like Document::root.
+		Cursor root() const{	return Cursor(this, 0);	}
+		//The declaration tag, not valid if there is none.
+		Cursor declaration() const{	return Cursor(this, declarationNode);	}
+		
+		const CompactNode& node(unsigned int index) const{	return nodes[index];	}
+		std::size_t size() const{	return nodeCount;	}
+		
+		//The name of an atom.
+		StringRef name(Atom atom) const{	return StringRef(pool + names[atom * 2], names[atom * 2 + 1]);	}
+		const AtomTable& atoms() const{	return atomTable;	}
+		
+		//Create a Document, or a Tag, with the same tree.
+		Document toDocument() const;
+		Tag* toTag(unsigned int index) const;
+		
+		//Read a document from a buffer, the same way Document::FromBuffer does.
+		static CompactDocument* FromBuffer(const char* data, std::size_t length);
+		//Read a document from a file, NULL if it could not be opened.
+		static CompactDocument* FromFile(const std::string& path);
+		//Copy the tree of a document, or of a tag, which becomes the root.
+		static CompactDocument* FromDocument(const Document& document);
+		static CompactDocument* FromTag(const Tag& tag);
+		
+		//The version of the snapshots written, snapshots of other versions are not read.
+		static const unsigned int SnapshotVersion = 2;
+		
+		//Write the document as a snapshot: a header, the node, attribute and name tables as they are in memory, and the pool.
+		//A snapshot is checksummed and read back without parsing, it is for the machine which wrote it, or one with the same byte order.
+		//Returns false if the stream failed.
+		bool writeSnapshot(std::ostream& os) const;
+		//Write the snapshot to a file, false if it could not be written.
+		bool saveSnapshot(const std::string& path) const;
+		
+		//Use a snapshot in place, the buffer is not copied and has to outlive the document, unless it is not aligned to 4 bytes.
+		//Returns NULL if it is not a snapshot of this version, if it is truncated, or if verify is true and it does not match its checksum
+		//or refers outside of its tables. Without verify the snapshot is trusted, and only its names are read.
+		static CompactDocument* FromSnapshot(const char* data, std::size_t length, bool verify = true);
+		//Use a snapshot file, which is memory mapped and kept alive by the document.
+		//Returns NULL if the file could not be opened, or if it is not a valid snapshot.
+		static CompactDocument* FromSnapshotFile(const std::string& path, bool verify = true);
+		
+	private:
+		//Everything is read through these, so the storage can be somewhere else than in the vectors below.
+		const CompactNode* nodes;
+		std::size_t nodeCount;
+		const CompactAttribute* attributes;
+		std::size_t attributeCount;
+		const char* pool;
+		std::size_t poolSize;
+		//the offset and length of the name of every atom
+		const unsigned int* names;
+		unsigned int declarationNode;
+		
+		AtomTable atomTable;
+		
+		std::vector<CompactNode> nodeStorage;
+		std::vector<CompactAttribute> attributeStorage;
+		std::string poolStorage;
+		std::vector<unsigned int> nameStorage;
+		//a copy of a snapshot which was not aligned, or the file it is mapped from
+		std::vector<unsigned int> snapshotStorage;
+		MappedFile* source;
+		
+		class Builder;
+		friend class Builder;
+		
+		CompactDocument();
+		
+		//Point the accessors to the storage vectors.
+		void attach();
+		//Point the accessors into a snapshot, returns false if it is not valid.
+		bool attachSnapshot(const char* data, std::size_t length, bool verify);
+		Tag* newTag(unsigned int index, Tag* parent, Arena* arena, AtomTable* tagAtoms) const;
+		
+		//not copyable
+		CompactDocument(const CompactDocument& other);
+		CompactDocument& operator=(const CompactDocument& other);
+	};
+	
+}; //end namespace XML
+
+#endif //_XML_COMPACT_H
@@ -0,0 +1,93 @@
+#include "XMLFile.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define XML_USE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#else
+#include <fstream>
+#endif
+
+namespace XML{
+	
+	MappedFile::MappedFile():address(NULL), length(0), opened(false), mapped(false){}
+	
+	MappedFile::~MappedFile(){
+		close();
+	}
+	
+#ifdef XML_USE_MMAP
+	bool MappedFile::open(const std::string& path){
+		close();
+		int fd = ::open(path.c_str(), O_RDONLY);
+		if(fd < 0){
+			return false;
+		}
+		struct stat info;
+		if(fstat(fd, &info) != 0){
+			::close(fd);
+			return false;
+		}
+		length = (std::size_t)info.st_size;
+		if(length > 0){
+			void* view = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+			if(view == MAP_FAILED){
+				::close(fd);
+				length = 0;
+				return false;
+			}
+			//the parser reads the file front to back
+			madvise(view, length, MADV_SEQUENTIAL);
+			address = (const char*)view;
+			mapped = true;
+		}
+		//the mapping stays valid after the descriptor is closed
+		::close(fd);
+		opened = true;
+		return true;
+	}
+#else
+	bool MappedFile::open(const std::string& path){
+		close();
+		std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+		if(!file){
+			return false;
+		}
+		file.seekg(0, std::ios::end);
+		length = (std::size_t)file.tellg();
+		file.seekg(0, std::ios::beg);
+		if(length > 0){
+			char* buffer = new char[length];
+			if(!file.read(buffer, length)){
+				delete[] buffer;
+				length = 0;
+				return false;
+			}
+			address = buffer;
+		}
+		opened = true;
+		return true;
+	}
+#endif
+	
+	void MappedFile::close(){
+		if(address != NULL){
+#ifdef XML_USE_MMAP
+			if(mapped){
+				munmap((void*)address, length);
+			}else{
+				delete[] address;
+			}
+#else
+			delete[] address;
+#endif
+		}
+		address = NULL;
+		length = 0;
+		opened = false;
+		mapped = false;
+	}
+	
+}; //end namespace XML
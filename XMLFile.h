@@ -0,0 +1,40 @@
+#ifndef _XML_FILE_H
+#define _XML_FILE_H
+
+#include <string>
+#include <cstddef>
+
+namespace XML{
+	
+	//A read only view of a whole file.
+	//The file is memory mapped where the platform allows it, otherwise it is read into memory.
+	class MappedFile{
+	public:
+		MappedFile();
+		~MappedFile();
+		
+		//Map the file, returns false if it could not be opened.
+		bool open(const std::string& path);
+		
+		//Unmap the file, any pointers into it become invalid.
+		void close();
+		
+		bool isOpen() const{	return opened;	}
+		const char* data() const{	return address;	}
+		std::size_t size() const{	return length;	}
+		
+	private:
+		const char* address;
+		std::size_t length;
+		bool opened;
+		//true if address is a mapping, false if it was allocated
+		bool mapped;
+		
+		//not copyable
+		MappedFile(const MappedFile& other);
+		MappedFile& operator=(const MappedFile& other);
+	};
+	
+}; //end namespace XML
+
+#endif //_XML_FILE_H
@@ -0,0 +1,230 @@
+#include "XMLIndex.h"
+
+namespace XML{
+	
+	const unsigned int ChildIndex::NoChild;
+	const unsigned int ChildIndex::Stale;
+	
+	static const unsigned int InitialTableSize = 16;
+	
+	ChildIndex::ChildIndex():previous(NULL), atoms(NULL), byAtom(false), used(0){}
+	
+	ChildIndex::~ChildIndex(){
+		delete previous;
+	}
+	
+	void ChildIndex::build(const Tag::vec_type& children, const AtomTable* Atoms){
+		atoms = Atoms;
+		byAtom = (atoms != NULL);
+		for(unsigned int i = 0; byAtom && i < children.size(); ++i){
+			if(children[i] != NULL && children[i]->getType() == XML_TAG){
+				const Tag* child = (const Tag*)children[i];
+				byAtom = (child->atoms == atoms && child->atom != NoAtom);
+			}
+		}
+		Entry empty = {0, NoAtom, NoChild, NoChild};
+		table.assign(InitialTableSize, empty);
+		used = 0;
+		nextSame.clear();
+		nextSame.reserve(children.size());
+		indexed.clear();
+		indexed.reserve(children.size());
+		for(unsigned int i = 0; i < children.size(); ++i){
+			add(children, i);
+		}
+	}
+	
+	bool ChildIndex::add(const Tag::vec_type& children, unsigned int position){
+		const Object* child = children[position];
+		nextSame.push_back(NoChild);
+		indexed.push_back(child);
+		if(child == NULL || child->getType() != XML_TAG){
+			return true;
+		}
+		Atom atom = NoAtom;
+		if(byAtom){
+			const Tag* tag = (const Tag*)child;
+			if(tag->atoms != atoms || tag->atom == NoAtom){
+				return false;
+			}
+			atom = tag->atom;
+		}
+		if(table.empty() || (used + 1) * 2 > table.size()){
+			grow();
+		}
+		const unsigned int hash = HashName(child->name.data(), child->name.length());
+		const unsigned int mask = table.size() - 1;
+		for(unsigned int slot = hash & mask;; slot = (slot + 1) & mask){
+			Entry& entry = table[slot];
+			if(entry.first == NoChild){
+				entry.hash = hash;
+				entry.atom = atom;
+				entry.first = entry.last = position;
+				++used;
+				return true;
+			}else if(entry.hash == hash && entry.atom == atom){
+				if(!holds(children, entry.first) || !holds(children, entry.last)){
+					return false;
+				}
+				const Object* entryChild = children[entry.first];
+				if(byAtom ? ((const Tag*)entryChild)->atom == atom : entryChild->name == child->name){
+					nextSame[entry.last] = position;
+					entry.last = position;
+					return true;
+				}else if(byAtom || HashName(entryChild->name.data(), entryChild->name.length()) != hash){ //renamed
+					return false;
+				}
+			}
+		}
+	}
+	
+	void ChildIndex::grow(){
+		std::vector<Entry> old;
+		old.swap(table);
+		Entry empty = {0, NoAtom, NoChild, NoChild};
+		table.assign(old.empty() ? InitialTableSize : old.size() * 2, empty);
+		const unsigned int mask = table.size() - 1;
+		for(unsigned int i = 0; i < old.size(); ++i){
+			if(old[i].first != NoChild){
+				unsigned int slot = old[i].hash & mask;
+				while(table[slot].first != NoChild){
+					slot = (slot + 1) & mask;
+				}
+				table[slot] = old[i];
+			}
+		}
+	}
+	
+	const ChildIndex::Entry* ChildIndex::find(const std::string& name, const Tag::vec_type& children, bool& stale) const{
+		stale = false;
+		if(table.empty()){
+			return NULL;
+		}
+		const unsigned int hash = HashName(name.data(), name.length());
+		const unsigned int mask = table.size() - 1;
+		for(unsigned int slot = hash & mask;; slot = (slot + 1) & mask){
+			const Entry& entry = table[slot];
+			if(entry.first == NoChild){
+				return NULL;
+			}else if(entry.hash == hash){
+				if(!holds(children, entry.first)){
+					stale = true;
+					return NULL;
+				}
+				const std::string& entryName = children[entry.first]->name;
+				if(entryName == name){
+					return &entry;
+				}else if(HashName(entryName.data(), entryName.length()) != hash){ //renamed
+					stale = true;
+					return NULL;
+				}
+			}
+		}
+	}
+	
+	const ChildIndex::Entry* ChildIndex::find(Atom atom, const Tag::vec_type& children, bool& stale) const{
+		stale = false;
+		if(table.empty()){
+			return NULL;
+		}
+		//the hash was kept when the name was interned, so no name is hashed or compared
+		const unsigned int hash = atoms->hash(atom);
+		const unsigned int mask = table.size() - 1;
+		for(unsigned int slot = hash & mask;; slot = (slot + 1) & mask){
+			const Entry& entry = table[slot];
+			if(entry.first == NoChild){
+				return NULL;
+			}else if(entry.hash == hash && entry.atom == atom){
+				if(!holds(children, entry.first) || ((const Tag*)children[entry.first])->atom != atom){ //replaced or renamed
+					stale = true;
+					return NULL;
+				}
+				return &entry;
+			}
+		}
+	}
+	
+	unsigned int ChildIndex::first(const std::string& name, const Tag::vec_type& children) const{
+		bool stale;
+		const Entry* entry = find(name, children, stale);
+		if(stale){
+			return Stale;
+		}
+		return (entry == NULL) ? NoChild : entry->first;
+	}
+	
+	unsigned int ChildIndex::last(const std::string& name, const Tag::vec_type& children) const{
+		bool stale;
+		const Entry* entry = find(name, children, stale);
+		if(stale || (entry != NULL && (!holds(children, entry->last) || children[entry->last]->name != name))){
+			return Stale;
+		}
+		return (entry == NULL) ? NoChild : entry->last;
+	}
+	
+	unsigned int ChildIndex::first(Atom atom, const Tag::vec_type& children) const{
+		bool stale;
+		if(byAtom){
+			const Entry* entry = find(atom, children, stale);
+			if(stale){
+				return Stale;
+			}
+			return (entry == NULL) ? NoChild : entry->first;
+		}
+		//without atoms in the entries, some children with the name may not have the atom
+		const Entry* entry = find(atoms->name(atom), children, stale);
+		if(stale){
+			return Stale;
+		}
+		for(unsigned int position = (entry == NULL) ? NoChild : entry->first; position != NoChild; position = nextSame[position]){
+			if(!holds(children, position)){
+				return Stale;
+			}else if(((const Tag*)children[position])->atom == atom){
+				return position;
+			}
+		}
+		return NoChild;
+	}
+	
+	unsigned int ChildIndex::last(Atom atom, const Tag::vec_type& children) const{
+		bool stale;
+		if(byAtom){
+			const Entry* entry = find(atom, children, stale);
+			if(stale || (entry != NULL && (!holds(children, entry->last) || ((const Tag*)children[entry->last])->atom != atom))){
+				return Stale;
+			}
+			return (entry == NULL) ? NoChild : entry->last;
+		}
+		const Entry* entry = find(atoms->name(atom), children, stale);
+		if(stale){
+			return Stale;
+		}
+		unsigned int found = NoChild;
+		for(unsigned int position = (entry == NULL) ? NoChild : entry->first; position != NoChild; position = nextSame[position]){
+			if(!holds(children, position)){
+				return Stale;
+			}else if(((const Tag*)children[position])->atom == atom){
+				found = position;
+			}
+		}
+		return found;
+	}
+	
+	unsigned int ChildIndex::next(unsigned int position, const Tag::vec_type& children) const{
+		if(position >= nextSame.size() || !holds(children, position)){
+			return Stale;
+		}
+		const unsigned int following = nextSame[position];
+		if(following == NoChild){
+			return NoChild;
+		}
+		if(!holds(children, following)){
+			return Stale;
+		}
+		if(byAtom){
+			return (((const Tag*)children[following])->atom == ((const Tag*)children[position])->atom) ? following : Stale;
+		}
+		return (children[following]->name == children[position]->name) ? following : Stale;
+	}
+	
+}; //end namespace XML
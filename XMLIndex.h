@@ -0,0 +1,79 @@
+#ifndef _XML_INDEX_H
+#define _XML_INDEX_H
+
+#include "XML.h"
+#include "XMLAtom.h"
+
+//Lookup of the children of a tag by name, not part of the public interface.
+
+namespace XML{
+	
+	//Hash table from the names of the child tags to their first and last position,
+	//with the positions of the children with the same name linked together.
+	//When every child tag has an atom of the tag's table the entries also hold the atom, so lookups by atom compare integers.
+	//It keeps the child it indexed at every position, and a lookup which finds another child there, or one with another name, returns Stale.
+	//Names are only read from children which are still the ones indexed, so a child replaced in place is never read after it was deleted.
+	class ChildIndex{
+	public:
+		static const unsigned int NoChild = ~0u;
+		//The children changed since they were indexed.
+		static const unsigned int Stale = ~0u - 1;
+		
+		//The index this one replaced, kept until the tag changes, as other threads may still be reading it.
+		ChildIndex* previous;
+		
+		ChildIndex();
+		~ChildIndex();
+		
+		//Index every child, replacing what was indexed before. Atoms is the table of the tag, NULL if it has none.
+		void build(const Tag::vec_type& children, const AtomTable* atoms);
+		//Index the child added at position, which must be the number of children indexed so far.
+		//Returns false if the children changed since they were indexed, the index is then out of date.
+		bool add(const Tag::vec_type& children, unsigned int position);
+		
+		//The number of children indexed, if it is not the number of children the index is out of date.
+		std::size_t size() const{	return indexed.size();	}
+		
+		//The position of the first or last child tag with the name, NoChild if there is none.
+		unsigned int first(const std::string& name, const Tag::vec_type& children) const;
+		unsigned int last(const std::string& name, const Tag::vec_type& children) const;
+		//The same by atom, for a tag with atoms.
+		unsigned int first(Atom atom, const Tag::vec_type& children) const;
+		unsigned int last(Atom atom, const Tag::vec_type& children) const;
+		//The position of the next child tag with the same name as the one at position, NoChild if there is none.
+		unsigned int next(unsigned int position, const Tag::vec_type& children) const;
+		
+	private:
+		struct Entry{
+			unsigned int hash;
+			Atom atom;				//NoAtom unless byAtom
+			unsigned int first;		//NoChild if the entry is empty
+			unsigned int last;
+		};
+		
+		const AtomTable* atoms;
+		bool byAtom;		//every child tag has an atom of atoms
+		//open addressing, the size is a power of two
+		std::vector<Entry> table;
+		unsigned int used;
+		std::vector<unsigned int> nextSame;
+		//the child indexed at every position
+		std::vector<const Object*> indexed;
+		
+		//True if the child at position is the one indexed there.
+		bool holds(const Tag::vec_type& children, unsigned int position) const{
+			return position < children.size() && children[position] == indexed[position];
+		}
+		//The entry of the name or atom, NULL if there is none. Sets stale if one of the children it compared was replaced.
+		const Entry* find(const std::string& name, const Tag::vec_type& children, bool& stale) const;
+		const Entry* find(Atom atom, const Tag::vec_type& children, bool& stale) const;
+		void grow();
+		
+		//not copyable
+		ChildIndex(const ChildIndex& other);
+		ChildIndex& operator=(const ChildIndex& other);
+	};
+	
+}; //end namespace XML
+
+#endif //_XML_INDEX_H
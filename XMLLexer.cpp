@@ -0,0 +1,185 @@
+#include "XMLLexer.h"
+#include "XMLScan.h"
+
+namespace XML{
+	
+	const char* FindString(const char* begin, const char* end, const char* str, std::size_t length){
+		while(end - begin >= (std::ptrdiff_t)length){
+			const char* fnd = ScanForChar(begin, end - length + 1, str[0]);
+			if(fnd == end - length + 1){
+				break;
+			}else if(memcmp(fnd, str, length) == 0){
+				return fnd;
+			}
+			begin = fnd + 1;
+		}
+		return end;
+	}
+	
+	//Names end at white space, '=', '>' or the "/>" and "?>" tag endings.
+	const char* Lexer::scanName(const char* s) const{
+		for(;;){
+			s = ScanForNameEnd(s, last);
+			//'/' and '?' only end a name in front of '>'
+			if(s < last && (*s == '/' || *s == '?') && (s + 1 == last || s[1] != '>')){
+				++s;
+			}else{
+				return s;
+			}
+		}
+	}
+	
+	//Read the attributes up to and including the end of the tag.
+	//ie. ' attr1="val1" ...>' or ' attr1="val1" .../>'
+	//Returns false if the input ended before the tag did.
+	bool Lexer::readAttributes(){
+		attributes.clear();
+		selfClosing = false;
+		while(pos < last){
+			const char c = *pos;
+			if(IsSpace(c)){
+				++pos;
+			}else if(c == '>'){
+				++pos;
+				return true;
+			}else if((c == '/' || c == '?') && pos + 1 < last && pos[1] == '>'){
+				selfClosing = (c == '/');
+				pos += 2;
+				return true;
+			}else{ //extract attribute
+				std::pair<Span, Span> attribute;
+				attribute.first.begin = pos;
+				pos = scanName(pos + 1);
+				attribute.first.end = pos;
+				
+				const char* s = pos;
+				while(s < last && IsSpace(*s)){	++s;	}
+				if(s < last && *s == '='){
+					++s;
+					while(s < last && IsSpace(*s)){	++s;	}
+					if(s < last && (*s == '"' || *s == '\'')){
+						const char* fnd = ScanForChar(s + 1, last, *s);
+						attribute.second.begin = s + 1;
+						attribute.second.end = fnd;
+						pos = (fnd == last) ? last : fnd + 1;
+					}else{
+						attribute.second.begin = s;
+						attribute.second.end = pos = scanName(s);
+					}
+				}
+				attributes.push_back(attribute);
+			}
+		}
+		return false;
+	}
+	
+	//An escape string or character reference is at most this long, eg. "&#x10FFFF;".
+	static const std::ptrdiff_t MaxEscapeLength = 12;
+	
+	//The end of text which may continue past the input, leaving out an escape string which could have been cut.
+	static const char* SafeTextEnd(const char* begin, const char* end){
+		const char* s = (end - begin > MaxEscapeLength) ? end - MaxEscapeLength : begin;
+		const char* amp = NULL;
+		for(; s < end; ++s){
+			if(*s == '&'){
+				amp = s;
+			}else if(*s == ';'){
+				amp = NULL;
+			}
+		}
+		return (amp == NULL) ? end : amp;
+	}
+	
+	Lexer::Token Lexer::next(){
+		while(pos < last){
+			const char* start = pos;
+			const char* s = pos + 1;
+			if(s == last && !final){ //a lone '<' or the start of some text
+				return TOKEN_MORE;
+			}else if(*pos != '<' || s == last || IsSpace(*s)){
+				//character data up to the next markup, noting any escape strings on the way
+				const char* fnd = ScanForText(s, last);
+				textEscaped = (*pos == '&');
+				if(fnd < last && *fnd == '&'){
+					textEscaped = true;
+					fnd = ScanForChar(fnd + 1, last, '<');
+				}
+				if(fnd == last && !final){
+					//hand out what there is, so long text does not have to fit in the input at once
+					fnd = SafeTextEnd(pos, last);
+					if(fnd == pos){
+						return TOKEN_MORE;
+					}
+				}
+				text.begin = pos;
+				text.end = pos = fnd;
+				return TOKEN_TEXT;
+			}else if(*s == '/'){
+				name.begin = s + 1;
+				name.end = scanName(name.begin);
+				const char* fnd = ScanForChar(name.end, last, '>');
+				if(fnd == last && !final){
+					return TOKEN_MORE;
+				}
+				pos = (fnd == last) ? last : fnd + 1;
+				return TOKEN_END;
+			}else if(*s == '!'){
+				if(last - s < 8 && !final){ //not enough to tell a comment from CDATA
+					return TOKEN_MORE;
+				}else if(last - s >= 3 && memcmp(s, "!--", 3) == 0){
+					const char* fnd = FindString(s + 3, last, "-->", 3);
+					if(fnd == last && !final){
+						return TOKEN_MORE;
+					}
+					pos = (fnd == last) ? last : fnd + 3;
+				}else if(last - s >= 8 && memcmp(s, "![CDATA[", 8) == 0){
+					text.begin = s + 8;
+					text.end = FindString(text.begin, last, "]]>", 3);
+					if(text.end == last && !final){
+						return TOKEN_MORE;
+					}
+					pos = (text.end == last) ? last : text.end + 3;
+					return TOKEN_CDATA;
+				}else{ //doctype, which may have an internal subset in brackets
+					int depth = 0;
+					for(++s; s < last; ++s){
+						if(*s == '['){
+							++depth;
+						}else if(*s == ']'){
+							--depth;
+						}else if(*s == '>' && depth <= 0){
+							break;
+						}
+					}
+					if(s == last && !final){
+						return TOKEN_MORE;
+					}
+					pos = (s == last) ? last : s + 1;
+				}
+			}else if(*s == '?'){
+				const char* close = FindString(s + 1, last, "?>", 2);
+				if(close == last && !final){
+					return TOKEN_MORE;
+				}
+				name.begin = s + 1;
+				name.end = scanName(name.begin);
+				if(name.end - name.begin == 3 && memcmp(name.begin, "xml", 3) == 0){
+					pos = name.end;
+					readAttributes();
+					return TOKEN_DECLARATION;
+				}
+				pos = (close == last) ? last : close + 2;
+			}else{
+				name.begin = s;
+				pos = name.end = scanName(s);
+				if(!readAttributes() && !final){
+					pos = start;
+					return TOKEN_MORE;
+				}
+				return TOKEN_START;
+			}
+		}
+		return final ? TOKEN_NONE : TOKEN_MORE;
+	}
+	
+}; //end namespace XML
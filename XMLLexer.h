@@ -0,0 +1,84 @@
+#ifndef _XML_LEXER_H
+#define _XML_LEXER_H
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstddef>
+
+//Tokenizer shared by the parsers, not part of the public interface.
+
+namespace XML{
+	
+	inline bool IsSpace(char c){
+		return (c == ' ' || c == '\t' || c == '\n' || c == '\r');
+	}
+	
+	//Find str in [begin,end), returns end if it is not found.
+	const char* FindString(const char* begin, const char* end, const char* str, std::size_t length);
+	
+	//A range of characters in the input.
+	struct Span{
+		const char* begin;
+		const char* end;
+		
+		Span():begin(NULL), end(NULL){}
+		
+		bool empty() const{	return begin == end;	}
+		bool equals(const std::string& str) const{
+			return (std::size_t)(end - begin) == str.length() && memcmp(begin, str.data(), str.length()) == 0;
+		}
+	};
+	
+	//Splits a contiguous range of XML into tokens, without copying anything.
+	//Comments, doctypes and processing instructions other than the declaration are skipped.
+	class Lexer{
+	public:
+		enum Token{
+			TOKEN_NONE,			//the end of the input
+			TOKEN_TEXT,			//character data, still escaped
+			TOKEN_CDATA,		//the content of a CDATA section
+			TOKEN_START,		//a start tag or a self closing tag
+			TOKEN_END,			//an end tag
+			TOKEN_DECLARATION,	//the <?xml ...?> declaration
+			TOKEN_MORE			//the input ended inside a token, only if the input is not final
+		};
+		
+		//set by TOKEN_TEXT and TOKEN_CDATA
+		Span text;
+		//set by TOKEN_TEXT, true if the text holds a '&' and has to be decoded
+		bool textEscaped;
+		//set by TOKEN_START and TOKEN_END
+		Span name;
+		//set by TOKEN_START and TOKEN_DECLARATION
+		std::vector<std::pair<Span, Span> > attributes;
+		bool selfClosing;
+		
+		Lexer():textEscaped(false), selfClosing(false), pos(NULL), last(NULL), final(true){}
+		
+		//If isFinal == false more input may follow, so a token cut off by the end is not returned.
+		//Instead TOKEN_MORE is returned and the token starts at position() once more input is given.
+		//Long text is returned in pieces, which never split an escape string.
+		void reset(const char* begin, const char* end, bool isFinal = true){
+			pos = begin;
+			last = end;
+			final = isFinal;
+		}
+		
+		//Where the next token starts.
+		const char* position() const{	return pos;	}
+		
+		Token next();
+		
+	private:
+		const char* pos;
+		const char* last;
+		bool final;
+		
+		const char* scanName(const char* s) const;
+		bool readAttributes();
+	};
+	
+}; //end namespace XML
+
+#endif //_XML_LEXER_H
@@ -0,0 +1,114 @@
+#include "XMLOutput.h"
+#include "XMLScan.h"
+#include "XML.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#define XML_WRITE_FD ::write
+#elif defined(_WIN32)
+#include <io.h>
+#define XML_WRITE_FD ::_write
+#endif
+
+namespace XML{
+	
+	OutputBuffer::OutputBuffer(std::size_t Capacity):buffer(NULL), used(0), capacity(Capacity > 16 ? Capacity : 16), os(NULL), fd(-1), callback(NULL), callbackContext(NULL), failed(false){
+		buffer = new char[capacity];
+	}
+	
+	OutputBuffer::OutputBuffer(std::ostream& Os, std::size_t chunkSize):buffer(NULL), used(0), capacity(chunkSize > 16 ? chunkSize : 16), os(&Os), fd(-1), callback(NULL), callbackContext(NULL), failed(false){
+		buffer = new char[capacity];
+	}
+	
+	OutputBuffer::OutputBuffer(int Fd, std::size_t chunkSize):buffer(NULL), used(0), capacity(chunkSize > 16 ? chunkSize : 16), os(NULL), fd(Fd), callback(NULL), callbackContext(NULL), failed(false){
+		buffer = new char[capacity];
+	}
+	
+	OutputBuffer::OutputBuffer(OutputCallback Callback, void* context, std::size_t chunkSize):buffer(NULL), used(0), capacity(chunkSize > 16 ? chunkSize : 16), os(NULL), fd(-1), callback(Callback), callbackContext(context), failed(false){
+		buffer = new char[capacity];
+	}
+	
+	OutputBuffer::~OutputBuffer(){
+		flush();
+		delete[] buffer;
+	}
+	
+	bool OutputBuffer::flush(){
+		if(hasSink() && used > 0){
+			writeToSink(buffer, used);
+			used = 0;
+		}
+		return !failed;
+	}
+	
+	void OutputBuffer::makeRoom(std::size_t length){
+		if(hasSink()){
+			flush();
+			return;
+		}
+		std::size_t newCapacity = capacity * 2;
+		while(newCapacity - used < length){
+			newCapacity *= 2;
+		}
+		char* grown = new char[newCapacity];
+		memcpy(grown, buffer, used);
+		delete[] buffer;
+		buffer = grown;
+		capacity = newCapacity;
+	}
+	
+	void OutputBuffer::writeToSink(const char* data, std::size_t length){
+		if(failed){
+			return;
+		}
+		if(os != NULL){
+			if(!os->write(data, length)){
+				failed = true;
+			}
+			return;
+		}
+		if(callback != NULL){
+			if(!callback(data, length, callbackContext)){
+				failed = true;
+			}
+			return;
+		}
+#ifdef XML_WRITE_FD
+		while(length > 0){
+			const int chunk = (length > (1u << 30)) ? (1 << 30) : (int)length;
+			const int written = (int)XML_WRITE_FD(fd, data, chunk);
+			if(written <= 0){
+				failed = true;
+				return;
+			}
+			data += written;
+			length -= written;
+		}
+#else
+		failed = true;
+#endif
+	}
+	
+	void OutputBuffer::writeEscaped(const char* data, std::size_t length){
+		const char* end = data + length;
+		const char* run = data;
+		if(length < ShortText){ //most text nodes are short runs of white space, where the scanner costs more than it saves
+			for(const char* c = data; c != end; ++c){
+				const unsigned char index = escapeIndex[(unsigned char)*c];
+				if(index != 0){
+					write(run, c - run);
+					write(escapeStrings[index - 1]);
+					run = c + 1;
+				}
+			}
+		}else{
+			for(const char* c = ScanForEscape(run, end); c != end; c = ScanForEscape(run, end)){
+				write(run, c - run);
+				write(escapeStrings[escapeIndex[(unsigned char)*c] - 1]);
+				run = c + 1;
+			}
+		}
+		write(run, end - run);
+	}
+	
+}; //end namespace XML
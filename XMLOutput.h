@@ -0,0 +1,94 @@
+#ifndef _XML_OUTPUT_H
+#define _XML_OUTPUT_H
+
+#include <string>
+#include <ostream>
+#include <cstddef>
+#include <cstring>
+
+namespace XML{
+	
+	//Receives the content of an OutputBuffer in large chunks, returns false if it failed, which stops the writing.
+	typedef bool (*OutputCallback)(const char* data, std::size_t length, void* context);
+	
+	//Contiguous byte buffer the serializer writes into.
+	//It either keeps everything in memory, growing as needed, or passes its content to a stream, a callback or
+	//a file descriptor each time it fills up, so the sink only sees large writes.
+	class OutputBuffer{
+	public:
+		//Keep everything in memory.
+		OutputBuffer(std::size_t capacity = 65536);
+		//Write to the stream in chunks of chunkSize.
+		OutputBuffer(std::ostream& os, std::size_t chunkSize = 65536);
+		//Write to the file descriptor in chunks of chunkSize, the descriptor is not closed.
+		OutputBuffer(int fd, std::size_t chunkSize = 65536);
+		//Pass the content to the callback in chunks of chunkSize.
+		OutputBuffer(OutputCallback callback, void* context, std::size_t chunkSize = 65536);
+		//Flushes anything left to the sink.
+		~OutputBuffer();
+		
+		void put(char c){
+			if(used == capacity)	makeRoom(1);
+			buffer[used++] = c;
+		}
+		
+		void write(const char* data, std::size_t length){
+			if(capacity - used < length)	makeRoom(length);
+			if(length > capacity - used){ //bigger than the chunk size, passed to the sink as it is
+				writeToSink(data, length);
+			}else{
+				memcpy(buffer + used, data, length);
+				used += length;
+			}
+		}
+		
+		void write(const std::string& str){
+			write(str.data(), str.length());
+		}
+		
+		//Write the text, replacing the characters which must be escaped with their escape strings.
+		void writeEscaped(const char* data, std::size_t length);
+		void writeEscaped(const std::string& str){
+			writeEscaped(str.data(), str.length());
+		}
+		
+		//Pass the content of the buffer to the sink, returns false if the sink failed.
+		//Does nothing for a buffer in memory.
+		bool flush();
+		
+		//The content which has not been passed to the sink yet, all of it for a buffer in memory.
+		const char* data() const{	return buffer;	}
+		std::size_t size() const{	return used;	}
+		std::string str() const{	return std::string(buffer, used);	}
+		void clear(){	used = 0;	}
+		
+		//false once writing to the sink has failed.
+		bool good() const{	return !failed;	}
+		
+	private:
+		//text shorter than this is escaped without the scanner
+		static const std::size_t ShortText = 32;
+		
+		char* buffer;
+		std::size_t used;
+		std::size_t capacity;
+		std::ostream* os;
+		int fd;
+		OutputCallback callback;
+		void* callbackContext;
+		bool failed;
+		
+		//True if the content is passed on, false if it is kept in memory.
+		bool hasSink() const{	return os != NULL || fd >= 0 || callback != NULL;	}
+		//Make room for length more bytes, by flushing to the sink or by growing the buffer.
+		void makeRoom(std::size_t length);
+		void writeToSink(const char* data, std::size_t length);
+		
+		//not copyable
+		OutputBuffer(const OutputBuffer& other);
+		OutputBuffer& operator=(const OutputBuffer& other);
+	};
+	
+}; //end namespace XML
+
+#endif //_XML_OUTPUT_H
@@ -0,0 +1,590 @@
+#include "XML.h"
+#include "XMLBuilder.h"
+#include "XMLArena.h"
+#include "XMLAtom.h"
+#include "XMLOutput.h"
+
+#ifdef XML_CPP11
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+namespace XML{
+
+#ifdef XML_CPP11
+	
+	//Pieces smaller than this are not worth a thread.
+	static const std::size_t MinimumPieceSize = 1 << 20;
+	
+	//Passes the tokens of a piece on until the lexer reaches the end of the piece,
+	//and follows the open tags the same way ReadContent does, to tell if the piece ended between two tags.
+	class PieceSource{
+	public:
+		PieceSource(const char* Limit):limit(Limit), text(false), stopped(false){}
+		
+		Lexer::Token next(Lexer& lexer){
+			if(stopped || lexer.position() >= limit){
+				stopped = true;
+				return Lexer::TOKEN_NONE;
+			}
+			const Lexer::Token token = lexer.next();
+			switch(token){
+				case Lexer::TOKEN_TEXT:
+				case Lexer::TOKEN_CDATA:
+					text = true;
+					break;
+				case Lexer::TOKEN_START:
+					text = false;
+					if(!lexer.name.empty() && !lexer.selfClosing){
+						open.push_back(lexer.name);
+					}
+					break;
+				case Lexer::TOKEN_END:
+					text = false;
+					if(!open.empty() && (open.back().end - open.back().begin) == (lexer.name.end - lexer.name.begin) && memcmp(open.back().begin, lexer.name.begin, lexer.name.end - lexer.name.begin) == 0){
+						open.pop_back();
+					}
+					break;
+				case Lexer::TOKEN_NONE:
+				case Lexer::TOKEN_DECLARATION:
+				case Lexer::TOKEN_MORE:
+					break;
+			}
+			return token;
+		}
+		
+		const char* limit;
+		//the tags open at the current position, the first one is the parent of the piece if it was read as content
+		std::vector<Span> open;
+		//true if the last token was text, so the next markup is not preceded by an empty string
+		bool text;
+		bool stopped;
+	};
+	
+	//A part of the buffer read on its own thread, into a tag of its own with its own arena and atoms.
+	//The piece starts with a start tag, except for the first one, and ends where the next piece starts.
+	struct Piece{
+		const char* begin;
+		const char* limit;
+		const char* end;
+		//if true the piece is content of the tag named parent, otherwise it is at the top level
+		bool content;
+		Span parent;
+		bool useArena;
+		
+		Arena* arena;
+		AtomTable atoms;
+		Tag* holder;
+		
+		//where reading stopped, and if it stopped between two children of the parent
+		const char* stop;
+		bool valid;
+		bool endedWithText;
+		//true if the parent tag was closed in the piece
+		bool closed;
+		
+		//the document atom of every atom of the piece
+		std::vector<Atom> atomMap;
+		AtomTable* documentAtoms;
+		
+		Piece():begin(NULL), limit(NULL), end(NULL), content(false), useArena(false), arena(NULL), holder(NULL), stop(NULL), valid(false), endedWithText(false), closed(false), documentAtoms(NULL){}
+		
+		~Piece(){
+			if(holder != NULL){
+				delete holder;
+			}
+			//adopted by the document arena once the piece is used
+			if(arena != NULL){
+				delete arena;
+			}
+		}
+		
+		void read(){
+			if(useArena){
+				arena = new Arena();
+			}
+			holder = new (arena) Tag();
+			holder->arena = arena;
+			holder->atoms = &atoms;
+			
+			Lexer lexer;
+			lexer.reset(begin, end);
+			PieceSource source(limit);
+			if(content){
+				holder->name.assign(parent.begin, parent.end);
+				source.open.push_back(parent);
+				ReadContent(holder, source, lexer);
+			}else{
+				Document top;
+				top.deleteTagsOnDestruction = false;
+				top.root = holder;
+				top.arena = arena;
+				top.atoms = &atoms;
+				ReadDocument(top, source, lexer, false);
+			}
+			
+			stop = lexer.position();
+			endedWithText = source.text;
+			closed = content && source.open.empty();
+			valid = (limit == end) || (source.stopped && stop == limit && source.open.size() == (content ? 1u : 0u));
+		}
+		
+		//Move every tag to the atoms of the document.
+		void remap(){
+			std::vector<Tag*> open(1, holder);
+			while(!open.empty()){
+				Tag* tag = open.back();
+				open.pop_back();
+				for(unsigned int i = 0; i < tag->children.size(); ++i){
+					if(tag->children[i]->getType() == XML_TAG){
+						Tag* child = (Tag*)tag->children[i];
+						child->atoms = documentAtoms;
+						child->atom = atomMap[child->atom];
+						open.push_back(child);
+					}
+				}
+			}
+		}
+	};
+	
+	//Run the pieces on their own threads, the first one on this thread.
+	static void RunPieces(std::vector<Piece*>& pieces, void (Piece::*run)()){
+		std::vector<std::thread> threads;
+		threads.reserve(pieces.size());
+		for(unsigned int i = 1; i < pieces.size(); ++i){
+			threads.push_back(std::thread(run, pieces[i]));
+		}
+		(pieces[0]->*run)();
+		for(unsigned int i = 0; i < threads.size(); ++i){
+			threads[i].join();
+		}
+	}
+	
+	//Stops before the first top level tag, leaving the lexer at its start.
+	class PrologueSource{
+	public:
+		PrologueSource(const char* End):end(End), found(false){}
+		
+		Lexer::Token next(Lexer& lexer){
+			if(found){
+				return Lexer::TOKEN_NONE;
+			}
+			const char* start = lexer.position();
+			const Lexer::Token token = lexer.next();
+			if(token == Lexer::TOKEN_START && !lexer.name.empty()){
+				lexer.reset(start, end);
+				found = true;
+				return Lexer::TOKEN_NONE;
+			}
+			return token;
+		}
+		
+		const char* end;
+		bool found;
+	};
+	
+	static bool IsNameEnd(char c){
+		return IsSpace(c) || c == '>' || c == '/';
+	}
+	
+	//Find the next start tag "<name" at or after s, end if there is none.
+	static const char* FindStartTag(const char* s, const char* end, const Span& name){
+		const std::size_t length = name.end - name.begin;
+		std::string pattern(1, '<');
+		pattern.append(name.begin, name.end);
+		for(;;){
+			s = FindString(s, end, pattern.data(), pattern.length());
+			if(s == end || (s + 1 + length < end && IsNameEnd(s[1 + length]))){
+				return s;
+			}
+			++s;
+		}
+	}
+	
+	//Read the rest of the document on this thread, from begin, which is in the content of parent unless it is the root.
+	static void ReadRest(Document& output, Tag* parent, const char* begin, const char* end){
+		Lexer lexer;
+		BufferSource source(lexer, begin, end);
+		if(parent != output.root){
+			ReadContent(parent, source, lexer);
+		}
+		ReadDocument(output, source, lexer, false);
+	}
+	
+	//Read the rest of the document in pieces, starting at the start tag of the first top level tag.
+	//Returns false if a piece did not end between two tags, the document is left as it was then.
+	//If the document can not be split it is read on this thread.
+	static bool ReadPieces(Document& output, Lexer& lexer, const char* end, unsigned int threadCount, bool useArena){
+		const char* first = lexer.position();
+		lexer.next();
+		const Span firstName = lexer.name;
+		
+		//If the first tag is still open after a piece, its children are split, otherwise the top level tags are.
+		bool content = false;
+		if(!lexer.selfClosing){
+			const char* start = lexer.position();
+			PieceSource source((std::size_t)(end - start) > MinimumPieceSize ? start + MinimumPieceSize : end);
+			source.open.push_back(firstName);
+			while(!source.open.empty() && source.next(lexer) != Lexer::TOKEN_NONE){}
+			content = !source.open.empty();
+			lexer.reset(start, end);
+		}
+		
+		const char* begin = first;
+		Span pieceName = firstName;
+		Tag* parent = output.root;
+		if(content){
+			parent = new (output.arena) Tag();
+			parent->arena = output.arena;
+			parent->atoms = output.atoms;
+			SetName(parent, firstName);
+			lexer.reset(first, end);
+			lexer.next();
+			SetAttributes(parent, lexer);
+			output.root->addChild(parent);
+			begin = lexer.position();
+			
+			//split in front of tags with the name of the first child
+			Lexer::Token token;
+			while((token = lexer.next()) != Lexer::TOKEN_NONE && token != Lexer::TOKEN_END && (token != Lexer::TOKEN_START || lexer.name.empty())){}
+			if(token != Lexer::TOKEN_START){
+				ReadRest(output, parent, begin, end);
+				return true;
+			}
+			pieceName = lexer.name;
+		}
+		
+		std::size_t pieceCount = (end - begin) / MinimumPieceSize;
+		if(pieceCount > threadCount)	pieceCount = threadCount;
+		
+		std::vector<const char*> starts(1, begin);
+		for(std::size_t i = 1; i < pieceCount; ++i){
+			const char* target = begin + (end - begin) / pieceCount * i;
+			if(target <= starts.back())	target = starts.back() + 1;
+			const char* start = FindStartTag(target, end, pieceName);
+			if(start == end){
+				break;
+			}
+			starts.push_back(start);
+		}
+		if(starts.size() < 2){
+			ReadRest(output, parent, begin, end);
+			return true;
+		}
+		
+		std::vector<Piece*> pieces(starts.size());
+		for(unsigned int i = 0; i < pieces.size(); ++i){
+			pieces[i] = new Piece();
+			pieces[i]->begin = starts[i];
+			pieces[i]->limit = (i + 1 < starts.size()) ? starts[i + 1] : end;
+			pieces[i]->end = end;
+			pieces[i]->content = content;
+			pieces[i]->parent = firstName;
+			pieces[i]->useArena = useArena;
+		}
+		RunPieces(pieces, &Piece::read);
+		
+		bool valid = true;
+		for(unsigned int i = 0; i < pieces.size(); ++i){
+			valid = valid && pieces[i]->valid;
+		}
+		if(valid){
+			for(unsigned int i = 0; i < pieces.size(); ++i){
+				Piece& piece = *pieces[i];
+				piece.documentAtoms = output.atoms;
+				piece.atomMap.resize(piece.atoms.size() + 1, NoAtom);
+				for(Atom atom = 1; atom <= piece.atoms.size(); ++atom){
+					piece.atomMap[atom] = output.atoms->intern(piece.atoms.name(atom));
+				}
+			}
+			RunPieces(pieces, &Piece::remap);
+			
+			parent->children.reserve(parent->children.size() + pieces.size() * pieces[0]->holder->children.size());
+			for(unsigned int i = 0; i < pieces.size(); ++i){
+				Piece& piece = *pieces[i];
+				std::vector<Object*>& children = piece.holder->children;
+				unsigned int j = 0;
+				//reading the piece on its own added an empty string in front of its first tag, which follows text
+				if(i > 0 && content && pieces[i - 1]->endedWithText && !children.empty() && children[0]->getType() == XML_STRING && children[0]->name.empty()){
+					delete children[0];
+					j = 1;
+				}
+				for(; j < children.size(); ++j){
+					children[j]->parent = parent;
+					parent->children.push_back(children[j]);
+				}
+				children.clear();
+				if(output.arena != NULL){
+					output.arena->adopt(piece.arena);
+					piece.arena = NULL;
+				}
+			}
+			parent->invalidateIndex();
+			
+			//anything after the first tag is read as usual
+			if(content && pieces.back()->closed){
+				BufferSource source(lexer, pieces.back()->stop, end);
+				ReadDocument(output, source, lexer, false);
+			}
+		}
+		
+		for(unsigned int i = 0; i < pieces.size(); ++i){
+			delete pieces[i];
+		}
+		return valid;
+	}
+	
+	//Tags with fewer children than this are written on one thread.
+	static const std::size_t MinimumParallelChildren = 256;
+	//The number of runs of children written for every thread, so threads which finish early take more.
+	static const std::size_t RunsPerThread = 8;
+	//Runs hold at most this many children, so the buffers waiting to be passed on stay small in large documents.
+	static const std::size_t MaximumRunChildren = 1024;
+	
+	//Write some of the children of a tag, like Tag::writeChildren.
+	static void WriteChildren(const Tag* tag, std::size_t begin, std::size_t end, OutputBuffer& output){
+		for(std::size_t i = begin; i < end; ++i){
+			const Object* child = tag->children[i];
+			switch(child->getType()){
+				case XML_TAG:
+					((const Tag*)child)->writeToBuffer(output);
+					break;
+				case XML_STRING:
+					output.writeEscaped(child->name);
+					break;
+				default:
+					child->writeToBuffer(output);
+			}
+		}
+	}
+	
+	//Writes the children of one tag on several threads. The runs are written into buffers of their own
+	//and passed on in order by the calling thread, which writes runs too while it waits for the next one.
+	class ParallelWriter{
+	public:
+		ParallelWriter(const Tag* Wide, unsigned int ThreadCount):tag(Wide), threadCount(ThreadCount), next(0), written(0){
+			const std::size_t count = tag->children.size();
+			std::size_t runCount = threadCount * RunsPerThread;
+			if(runCount < count / MaximumRunChildren){
+				runCount = count / MaximumRunChildren;
+			}
+			for(std::size_t i = 0; i < runCount; ++i){
+				Run run;
+				run.begin = count * i / runCount;
+				run.end = count * (i + 1) / runCount;
+				run.output = NULL;
+				run.done = false;
+				runs.push_back(run);
+			}
+		}
+		
+		void write(OutputBuffer& output){
+			std::vector<std::thread> threads;
+			for(unsigned int i = 1; i < threadCount; ++i){
+				threads.push_back(std::thread([this](){
+					std::size_t run;
+					while(take(run)){
+						render(run);
+					}
+				}));
+			}
+			
+			for(std::size_t i = 0; i < runs.size(); ++i){
+				std::unique_lock<std::mutex> guard(lock);
+				while(!runs[i].done){
+					std::size_t run;
+					if(available()){
+						run = next++;
+						guard.unlock();
+						render(run);
+						guard.lock();
+					}else{
+						changed.wait(guard);
+					}
+				}
+				guard.unlock();
+				
+				output.write(runs[i].output->data(), runs[i].output->size());
+				delete runs[i].output;
+				runs[i].output = NULL;
+				
+				guard.lock();
+				written = i + 1;
+				changed.notify_all();
+			}
+			for(std::size_t i = 0; i < threads.size(); ++i){
+				threads[i].join();
+			}
+		}
+		
+	private:
+		struct Run{
+			std::size_t begin;
+			std::size_t end;
+			OutputBuffer* output;
+			bool done;
+		};
+		
+		const Tag* tag;
+		unsigned int threadCount;
+		std::vector<Run> runs;
+		std::mutex lock;
+		//notified when a run has been written into its buffer, or passed on
+		std::condition_variable changed;
+		//the next run to take, and the number of runs passed on
+		std::size_t next;
+		std::size_t written;
+		
+		//A run can be taken if not too many are waiting to be passed on, the lock is held.
+		bool available() const{
+			return next < runs.size() && next < written + 2 * threadCount;
+		}
+		
+		//Take the next run, waiting for one to be available, returns false once every run has been taken.
+		bool take(std::size_t& run){
+			std::unique_lock<std::mutex> guard(lock);
+			while(!available()){
+				if(next >= runs.size()){
+					return false;
+				}
+				changed.wait(guard);
+			}
+			run = next++;
+			return true;
+		}
+		
+		void render(std::size_t run){
+			OutputBuffer* output = new OutputBuffer();
+			WriteChildren(tag, runs[run].begin, runs[run].end, *output);
+			std::lock_guard<std::mutex> guard(lock);
+			runs[run].output = output;
+			runs[run].done = true;
+			changed.notify_all();
+		}
+	};
+	
+	//Write the tag, and its children the same way, except for the children of the wide tag, which are written by a ParallelWriter.
+	//path holds the tags from the tag down to the wide tag.
+	static void WriteAround(const Tag* tag, const std::vector<const Tag*>& path, std::size_t depth, unsigned int threadCount, OutputBuffer& output, bool withTag){
+		if(withTag){
+			output.put('<');
+			output.write(tag->name);
+			tag->writeAttributes(output);
+			output.put('>');
+		}
+		if(depth + 1 == path.size()){
+			ParallelWriter writer(tag, threadCount);
+			writer.write(output);
+		}else{
+			std::size_t i = 0;
+			while(tag->children[i] != path[depth + 1]){
+				++i;
+			}
+			WriteChildren(tag, 0, i, output);
+			WriteAround(path[depth + 1], path, depth + 1, threadCount, output, true);
+			WriteChildren(tag, i + 1, tag->children.size(), output);
+		}
+		if(withTag){
+			output.write("</", 2);
+			output.write(tag->name);
+			output.put('>');
+		}
+	}
+	
+#endif //XML_CPP11
+	
+	void Document::writeToBufferParallel(OutputBuffer& output, unsigned int threadCount) const{
+#ifdef XML_CPP11
+		if(threadCount == 0){
+			threadCount = std::thread::hardware_concurrency();
+		}
+		//from the root down through the child tags with the most children, until one has enough of them
+		std::vector<const Tag*> path;
+		const Tag* tag = root;
+		while(tag != NULL && threadCount > 1){
+			path.push_back(tag);
+			if(tag->children.size() >= MinimumParallelChildren){
+				break;
+			}
+			const Tag* widest = NULL;
+			for(unsigned int i = 0; i < tag->children.size(); ++i){
+				const Object* child = tag->children[i];
+				if(child->getType() == XML_TAG && (widest == NULL || ((const Tag*)child)->children.size() > widest->children.size())){
+					widest = (const Tag*)child;
+				}
+			}
+			tag = widest;
+		}
+		if(tag == NULL || threadCount < 2){
+			writeToBuffer(output);
+			return;
+		}
+		
+		if(declaration != NULL){
+			output.put('<');
+			output.write(declaration->name);
+			declaration->writeAttributes(output);
+			output.write("?>", 2);
+		}
+		WriteAround(root, path, 0, threadCount, output, root->name != "_root");
+#else
+		(void)threadCount;
+		writeToBuffer(output);
+#endif
+	}
+	
+	std::ostream& Document::writeToStreamParallel(std::ostream& os, unsigned int threadCount) const{
+		OutputBuffer output(os);
+		writeToBufferParallel(output, threadCount);
+		return os;
+	}
+	
+	Document Document::FromBufferParallel(const char* data, std::size_t length, unsigned int threadCount, const std::string& rootName, bool useArena){
+#ifdef XML_CPP11
+		if(threadCount == 0){
+			threadCount = std::thread::hardware_concurrency();
+		}
+		if(threadCount < 2 || length < 2 * MinimumPieceSize){
+			return Document::FromBuffer(data, length, rootName, useArena);
+		}
+		
+		//only the time of the whole document is measured
+		const bool measure = ParseStatsEnabled();
+		const double start = measure ? StatsSeconds() : 0;
+		
+		Document output;
+		if(useArena){
+			output.arena = new Arena(Arena::DefaultBlockSize, true, Arena::FirstBlockSize(length));
+		}
+		output.atoms = new AtomTable();
+		output.deleteTagsOnDestruction = Document::OwnedByDefault;
+		output.createRoot(rootName);
+		
+		//the declaration, up to the first top level tag
+		Lexer lexer;
+		lexer.reset(data, data + length);
+		PrologueSource prologue(data + length);
+		ReadDocument(output, prologue, lexer);
+		if(prologue.found){
+			output.createDeclaration();
+			if(!ReadPieces(output, lexer, data + length, threadCount, useArena)){
+				output.deleteTags();
+				return Document::FromBuffer(data, length, rootName, useArena);
+			}
+		}
+		
+		if(measure){
+			ParseStats stats;
+			stats.bytes = length;
+			stats.seconds = StatsSeconds() - start;
+			RecordParseStats(output, stats);
+		}
+		return output;
+#else
+		(void)threadCount;
+		return Document::FromBuffer(data, length, rootName, useArena);
+#endif
+	}
+	
+}; //end namespace XML
@@ -0,0 +1,445 @@
+#include "XMLQuery.h"
+#include "XMLReader.h"
+#include "XMLLexer.h"
+#include "XMLAtom.h"
+
+namespace XML{
+
+//-------------------------------Query---------------------------------------//
+	
+	Query::Query():counters(0){}
+	
+	Query::Query(const std::string& path):counters(0){
+		compile(path);
+	}
+	
+	static const char* SkipSpaces(const char* s, const char* end){
+		while(s < end && IsSpace(*s)){
+			++s;
+		}
+		return s;
+	}
+	
+	bool Query::compile(const std::string& path){
+		source = path;
+		steps.clear();
+		counters = 0;
+		
+		const char* s = path.data();
+		const char* end = s + path.length();
+		bool descendant = false;
+		if(s < end && *s == '/'){
+			++s;
+			if(s < end && *s == '/'){
+				descendant = true;
+				++s;
+			}
+		}
+		
+		for(;;){
+			steps.push_back(QueryStep());
+			QueryStep& step = steps.back();
+			step.descendant = descendant;
+			
+			const char* nameBegin = s;
+			while(s < end && *s != '/' && *s != '[' && !IsSpace(*s)){
+				++s;
+			}
+			if(s == nameBegin){
+				break;
+			}
+			step.name.assign(nameBegin, s);
+			step.anyName = (step.name == "*");
+			
+			bool valid = true;
+			while(valid && s < end && *s == '['){
+				step.predicates.push_back(QueryPredicate());
+				QueryPredicate& predicate = step.predicates.back();
+				predicate.position = 0;
+				predicate.counter = 0;
+				s = SkipSpaces(s + 1, end);
+				if(s < end && *s == '@'){
+					nameBegin = ++s;
+					while(s < end && *s != '=' && *s != ']' && !IsSpace(*s)){
+						++s;
+					}
+					predicate.name.assign(nameBegin, s);
+					predicate.type = QueryPredicate::ATTRIBUTE_EXISTS;
+					s = SkipSpaces(s, end);
+					if(s < end && *s == '='){
+						s = SkipSpaces(s + 1, end);
+						if(s == end || (*s != '\'' && *s != '"')){
+							valid = false;
+							break;
+						}
+						const char quote = *s++;
+						const char* valueBegin = s;
+						while(s < end && *s != quote){
+							++s;
+						}
+						if(s == end){
+							valid = false;
+							break;
+						}
+						predicate.value.assign(valueBegin, s++);
+						predicate.type = QueryPredicate::ATTRIBUTE_EQUALS;
+					}
+					valid = !predicate.name.empty();
+				}else{
+					const char* digits = s;
+					unsigned long position = 0;
+					while(s < end && *s >= '0' && *s <= '9' && position < 100000000){
+						position = position * 10 + (*s - '0');
+						++s;
+					}
+					predicate.type = QueryPredicate::POSITION;
+					predicate.position = position;
+					predicate.counter = counters++;
+					valid = (s != digits && position > 0);
+				}
+				s = SkipSpaces(s, end);
+				if(s == end || *s != ']'){
+					valid = false;
+					break;
+				}
+				++s;
+			}
+			if(!valid){
+				break;
+			}
+			
+			if(s == end){
+				return true;
+			}
+			if(*s != '/'){
+				break;
+			}
+			++s;
+			descendant = (s < end && *s == '/');
+			if(descendant){
+				++s;
+			}
+		}
+		
+		steps.clear();
+		counters = 0;
+		return false;
+	}
+	
+	Tag* Query::first(Tag* context) const{
+		QueryMatcher matcher(*this);
+		return const_cast<Tag*>(matcher.first(context));
+	}
+	
+	const Tag* Query::first(const Tag* context) const{
+		QueryMatcher matcher(*this);
+		return matcher.first(context);
+	}
+	
+	std::size_t Query::all(Tag* context, std::vector<Tag*>& output) const{
+		QueryMatcher matcher(*this);
+		return matcher.all(context, output);
+	}
+	
+	std::size_t Query::all(const Tag* context, std::vector<const Tag*>& output) const{
+		QueryMatcher matcher(*this);
+		return matcher.all(context, output);
+	}
+	
+	std::size_t Query::count(const Tag* context) const{
+		QueryMatcher matcher(*this);
+		return matcher.count(context);
+	}
+	
+//-------------------------------QueryMatcher---------------------------------------//
+	
+	//The tests of a step on a tag of a tree.
+	class TagElement{
+	public:
+		TagElement(const Tag* Tag, const AtomTable* Atoms):tag(Tag), atoms(Atoms){}
+		
+		bool hasName(const std::string& name, Atom atom) const{
+			if(atoms != NULL && tag->atoms == atoms && tag->atom != NoAtom){
+				return tag->atom == atom;
+			}
+			return tag->name == name;
+		}
+		
+		const std::string* attribute(const std::string& name) const{
+			return tag->attributes.get(name);
+		}
+		
+	private:
+		const Tag* tag;
+		const AtomTable* atoms;
+	};
+	
+	//The tests of a step on the element just started by a Reader.
+	class ReaderElement{
+	public:
+		ReaderElement(const Reader& Owner):reader(Owner){}
+		
+		bool hasName(const std::string& name, Atom) const{
+			return reader.name() == name;
+		}
+		
+		const StringRef* attribute(const std::string& name) const{
+			return reader.attribute(name);
+		}
+		
+	private:
+		const Reader& reader;
+	};
+	
+	QueryMatcher::QueryMatcher(const Query& Query):query(Query), deadDepth(0), atoms(NULL){
+		reset();
+	}
+	
+	void QueryMatcher::reset(){
+		states.clear();
+		frames.clear();
+		positions.clear();
+		walk.clear();
+		deadDepth = 0;
+		atoms = NULL;
+		if(query.valid()){
+			//the children of the context can match the first step
+			frames.push_back(0);
+			states.push_back(0);
+			positions.assign(query.counters, 0);
+		}
+	}
+	
+	template<class Element>
+	static bool StepMatches(const QueryStep& step, Atom atom, const Element& element, unsigned int* positions){
+		if(!step.anyName && !element.hasName(step.name, atom)){
+			return false;
+		}
+		for(unsigned int i = 0; i < step.predicates.size(); ++i){
+			const QueryPredicate& predicate = step.predicates[i];
+			switch(predicate.type){
+				case QueryPredicate::ATTRIBUTE_EXISTS:
+					if(element.attribute(predicate.name) == NULL){
+						return false;
+					}
+					break;
+				case QueryPredicate::ATTRIBUTE_EQUALS:
+					if(element.attribute(predicate.name) == NULL || !(*element.attribute(predicate.name) == predicate.value)){
+						return false;
+					}
+					break;
+				case QueryPredicate::POSITION:
+					if(++positions[predicate.counter] != predicate.position){
+						return false;
+					}
+					break;
+			}
+		}
+		return true;
+	}
+	
+	//Add the state to the frame starting at begin, unless it is there already.
+	static void AddState(std::vector<unsigned int>& states, unsigned int begin, unsigned int state){
+		for(unsigned int i = begin; i < states.size(); ++i){
+			if(states[i] == state){
+				return;
+			}
+		}
+		states.push_back(state);
+	}
+	
+	template<class Element>
+	bool QueryMatcher::push(const Element& element){
+		if(deadDepth > 0 || frames.empty()){
+			++deadDepth;
+			return false;
+		}
+		const unsigned int parent = frames.size() - 1;
+		const unsigned int begin = frames[parent];
+		const unsigned int end = states.size();
+		const unsigned int last = query.steps.size() - 1;
+		bool matched = false;
+		
+		frames.push_back(end);
+		for(unsigned int i = begin; i < end; ++i){
+			const unsigned int state = states[i];
+			const QueryStep& step = query.steps[state];
+			//a descendant step can still match deeper down
+			if(step.descendant){
+				AddState(states, end, state);
+			}
+			if(StepMatches(step, stepAtoms.empty() ? NoAtom : stepAtoms[state], element, query.counters == 0 ? NULL : &positions[parent * query.counters])){
+				if(state == last){
+					matched = true;
+				}else{
+					AddState(states, end, state + 1);
+				}
+			}
+		}
+		
+		if(states.size() == end){
+			//nothing inside of the element can match
+			frames.pop_back();
+			++deadDepth;
+		}else{
+			positions.resize(positions.size() + query.counters, 0);
+		}
+		return matched;
+	}
+	
+	void QueryMatcher::pop(){
+		if(deadDepth > 0){
+			--deadDepth;
+		}else if(frames.size() > 1){
+			states.resize(frames.back());
+			frames.pop_back();
+			positions.resize(positions.size() - query.counters);
+		}
+	}
+	
+	bool QueryMatcher::startElement(const Reader& reader){
+		return push(ReaderElement(reader));
+	}
+	
+	void QueryMatcher::endElement(){
+		pop();
+	}
+	
+	void QueryMatcher::useAtoms(const Tag* context){
+		atoms = context->atoms;
+		stepAtoms.clear();
+		if(atoms != NULL){
+			for(unsigned int i = 0; i < query.steps.size(); ++i){
+				stepAtoms.push_back(query.steps[i].anyName ? NoAtom : atoms->find(query.steps[i].name));
+			}
+		}
+	}
+	
+	QueryMatcher::Position QueryMatcher::open(const Tag* tag) const{
+		Position position;
+		position.tag = tag;
+		position.index = 0;
+		//only children with the name of a single child step can match
+		const unsigned int begin = frames.back();
+		position.named = (states.size() - begin == 1 && !query.steps[states[begin]].descendant && !query.steps[states[begin]].anyName);
+		if(position.named){
+			const NamedChildren children = tag->childrenWithName(query.steps[states[begin]].name);
+			position.next = children.begin();
+			position.end = children.end();
+		}
+		return position;
+	}
+	
+	template<class Visitor>
+	void QueryMatcher::find(const Tag* context, Visitor& visit){
+		reset();
+		if(!query.valid() || context == NULL){
+			return;
+		}
+		useAtoms(context);
+		
+		walk.push_back(open(context));
+		while(!walk.empty()){
+			Position& position = walk.back();
+			const Tag* child = NULL;
+			if(position.named){
+				if(position.next != position.end){
+					child = *position.next;
+					++position.next;
+				}
+			}else{
+				const std::vector<Object*>& children = position.tag->children;
+				while(child == NULL && position.index < children.size()){
+					if(children[position.index]->getType() == XML_TAG){
+						child = (const Tag*)children[position.index];
+					}
+					++position.index;
+				}
+			}
+			
+			if(child == NULL){
+				walk.pop_back();
+				if(!walk.empty()){
+					pop();
+				}
+				continue;
+			}
+			if(push(TagElement(child, atoms)) && !visit(child)){
+				return;
+			}
+			if(deadDepth > 0){
+				//skip the children
+				pop();
+			}else{
+				walk.push_back(open(child));
+			}
+		}
+	}
+	
+	//Keeps the first match.
+	class FirstVisitor{
+	public:
+		const Tag* found;
+		
+		FirstVisitor():found(NULL){}
+		
+		bool operator()(const Tag* tag){
+			found = tag;
+			return false;
+		}
+	};
+	
+	//Appends every match to a vector.
+	template<class T>
+	class AllVisitor{
+	public:
+		std::vector<T*>& output;
+		std::size_t found;
+		
+		AllVisitor(std::vector<T*>& Output):output(Output), found(0){}
+		
+		bool operator()(const Tag* tag){
+			output.push_back(const_cast<T*>(tag));
+			++found;
+			return true;
+		}
+	};
+	
+	//Counts the matches.
+	class CountVisitor{
+	public:
+		std::size_t found;
+		
+		CountVisitor():found(0){}
+		
+		bool operator()(const Tag*){
+			++found;
+			return true;
+		}
+	};
+	
+	const Tag* QueryMatcher::first(const Tag* context){
+		FirstVisitor visitor;
+		find(context, visitor);
+		return visitor.found;
+	}
+	
+	std::size_t QueryMatcher::all(const Tag* context, std::vector<const Tag*>& output){
+		AllVisitor<const Tag> visitor(output);
+		find(context, visitor);
+		return visitor.found;
+	}
+	
+	std::size_t QueryMatcher::all(Tag* context, std::vector<Tag*>& output){
+		AllVisitor<Tag> visitor(output);
+		find(context, visitor);
+		return visitor.found;
+	}
+	
+	std::size_t QueryMatcher::count(const Tag* context){
+		CountVisitor visitor;
+		find(context, visitor);
+		return visitor.found;
+	}
+	
+}; //end namespace XML
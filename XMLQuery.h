@@ -0,0 +1,137 @@
+#ifndef _XML_QUERY_H
+#define _XML_QUERY_H
+
+#include "XML.h"
+
+namespace XML{
+	
+	class Reader;
+	class QueryMatcher;
+	
+	//A test on an element, in brackets after the name of a step.
+	struct QueryPredicate{
+		enum TYPE{
+			ATTRIBUTE_EXISTS,	//[@name]
+			ATTRIBUTE_EQUALS,	//[@name='value'], the value is compared as it is in the source, like Tag::attributes
+			POSITION			//[n], the nth of the children of the same parent which passed the tests before it, from 1
+		};
+		
+		TYPE type;
+		std::string name;
+		std::string value;
+		unsigned int position;
+		//the counter of a positional predicate, among the positional predicates of the query
+		unsigned int counter;
+	};
+	
+	//The elements matched by one step of a path.
+	struct QueryStep{
+		//true after "//", the step matches any descendant of the context instead of only its children
+		bool descendant;
+		//"*" matches any name
+		std::string name;
+		bool anyName;
+		std::vector<QueryPredicate> predicates;
+	};
+	
+	//A path to elements in a subset of XPath, which is compiled once and can be used many times:
+	//  "a/b"				the b children of the a children of the context
+	//  "/a/b"				the same, a leading '/' stands for the context
+	//  "//b" "a//b"		descendants at any depth
+	//  "*"					any name
+	//  "b[@k]"				b elements with a k attribute
+	//  "b[@k='v']"			b elements whose k attribute is v, quoted with ' or "
+	//  "b[2]"				the second b child of every parent
+	//  "b[@k='v'][2]"		the second of the b children of every parent whose k attribute is v
+	//Evaluated against a tag, the context is the tag itself and the result is in document order.
+	//For a document use its root, so "/catalog/item" finds the item children of the top level catalog tag.
+	//The same query can be followed through a stream with a QueryMatcher, or a Splitter, without building a tree.
+	class Query{
+	public:
+		Query();
+		Query(const std::string& path);
+		
+		//Compile the path, returns false if it is not valid, then the query matches nothing.
+		bool compile(const std::string& path);
+		bool valid() const{	return !steps.empty();	}
+		const std::string& path() const{	return source;	}
+		
+		//The first matching tag, NULL if there is none.
+		Tag* first(Tag* context) const;
+		const Tag* first(const Tag* context) const;
+		//Append every matching tag to output, returns the number added.
+		std::size_t all(Tag* context, std::vector<Tag*>& output) const;
+		std::size_t all(const Tag* context, std::vector<const Tag*>& output) const;
+		std::size_t count(const Tag* context) const;
+		
+	private:
+		std::string source;
+		std::vector<QueryStep> steps;
+		//the number of positional predicates
+		unsigned int counters;
+		
+		friend class QueryMatcher;
+	};
+	
+	//Follows a query through a document one element at a time, keeping for every open element the steps its children can match.
+	//Nothing is allocated per element once its buffers have grown, so it can be kept to evaluate a query many times,
+	//on trees or on the events of a Reader. It refers to the query, which has to outlive it.
+	class QueryMatcher{
+	public:
+		QueryMatcher(const Query& query);
+		
+		//Start again at the context, before its first child.
+		void reset();
+		
+		//For the events of a Reader, call startElement for every EVENT_START_ELEMENT, which returns true if the element matches,
+		//and endElement for every EVENT_END_ELEMENT. The context is the document, so top level elements are its children.
+		bool startElement(const Reader& reader);
+		void endElement();
+		
+		//The same as Query::first, all and count, reusing the buffers of the matcher.
+		const Tag* first(const Tag* context);
+		std::size_t all(const Tag* context, std::vector<const Tag*>& output);
+		std::size_t all(Tag* context, std::vector<Tag*>& output);
+		std::size_t count(const Tag* context);
+		
+	private:
+		const Query& query;
+		
+		//the steps the children of every open element can match, frame i starts at frames[i] in states
+		std::vector<unsigned int> states;
+		std::vector<unsigned int> frames;
+		//the positional counters of every open element, query.counters for each one
+		std::vector<unsigned int> positions;
+		//the number of elements open inside of an element whose children can not match
+		unsigned int deadDepth;
+		
+		//the atoms of the step names in the table of the tree being searched
+		const AtomTable* atoms;
+		std::vector<Atom> stepAtoms;
+		
+		//a tag being searched, and the next of its children to visit
+		struct Position{
+			const Tag* tag;
+			unsigned int index;
+			//if true only the children with the name of the one step they can match are visited, through the index of the tag
+			bool named;
+			NamedChildren::iterator next;
+			NamedChildren::iterator end;
+		};
+		std::vector<Position> walk;
+		
+		//Push an element as a child of the last one, returns true if it matches.
+		template<class Element>
+		bool push(const Element& element);
+		void pop();
+		
+		void useAtoms(const Tag* context);
+		Position open(const Tag* tag) const;
+		//Visit the matching tags under the context in document order, until visit returns false.
+		template<class Visitor>
+		void find(const Tag* context, Visitor& visit);
+	};
+	
+}; //end namespace XML
+
+#endif //_XML_QUERY_H
@@ -0,0 +1,431 @@
+#include "XMLReader.h"
+#include "XMLScan.h"
+#include "XMLBuilder.h"
+#include "XMLArena.h"
+#include "XMLAtom.h"
+
+namespace XML{
+	
+	Reader::Reader(std::istream& Is, std::size_t bufferSize):is(&Is), buffer(bufferSize > 16 ? bufferSize : 16), windowBegin(NULL), windowEnd(NULL), final(false), consumed(0), current(EVENT_END), selfClosing(false), pendingEnd(false){
+		windowBegin = windowEnd = &buffer[0];
+		lexer.reset(windowBegin, windowEnd, false);
+	}
+	
+	Reader::Reader(const char* data, std::size_t length):is(NULL), windowBegin(data), windowEnd(data + length), final(true), consumed(0), current(EVENT_END), selfClosing(false), pendingEnd(false){
+		lexer.reset(windowBegin, windowEnd, true);
+	}
+	
+	//Move the unread input to the front of the buffer and read more after it.
+	//Returns false once the stream has ended.
+	bool Reader::fill(){
+		if(is == NULL || final){
+			return false;
+		}
+		const char* unread = lexer.position();
+		const std::size_t kept = windowEnd - unread;
+		consumed += unread - windowBegin;
+		if(kept > 0 && unread != &buffer[0]){
+			memmove(&buffer[0], unread, kept);
+		}
+		if(kept == buffer.size()){ //a single token bigger than the buffer
+			buffer.resize(buffer.size() * 2);
+		}
+		
+		is->read(&buffer[kept], buffer.size() - kept);
+		const std::size_t red = (std::size_t)is->gcount();
+		if(red == 0){
+			final = true;
+		}
+		windowBegin = &buffer[0];
+		windowEnd = windowBegin + kept + red;
+		lexer.reset(windowBegin, windowEnd, final);
+		return true;
+	}
+	
+	void Reader::setAttributes(){
+		attributeList.resize(lexer.attributes.size());
+		for(unsigned int i = 0; i < attributeList.size(); ++i){
+			const Span& attributeName = lexer.attributes[i].first;
+			const Span& value = lexer.attributes[i].second;
+			attributeList[i].name = StringRef(attributeName.begin, attributeName.end - attributeName.begin);
+			attributeList[i].value = StringRef(value.begin, value.end - value.begin, ScanForChar(value.begin, value.end, '&') != value.end);
+		}
+		selfClosing = lexer.selfClosing;
+	}
+	
+	const StringRef* Reader::attribute(const std::string& attributeName) const{
+		for(unsigned int i = 0; i < attributeList.size(); ++i){
+			if(attributeList[i].name == attributeName){
+				return &attributeList[i].value;
+			}
+		}
+		return NULL;
+	}
+	
+	Reader::EVENT Reader::next(){
+		if(pendingEnd){ //the second half of a self closing tag
+			pendingEnd = false;
+			attributeList.clear();
+			return current = EVENT_END_ELEMENT;
+		}
+		selfClosing = false;
+		
+		for(;;){
+			const Lexer::Token token = nextToken();
+			switch(token){
+				case Lexer::TOKEN_NONE:
+				case Lexer::TOKEN_MORE:
+					return current = EVENT_END;
+				case Lexer::TOKEN_TEXT:
+				case Lexer::TOKEN_CDATA:
+					//text outside of the elements is ignored
+					if(!openOffsets.empty()){
+						if(token == Lexer::TOKEN_TEXT && lexer.textEscaped){
+							scratch.clear();
+							AppendDeEscaped(scratch, lexer.text.begin, lexer.text.end);
+							textRef = StringRef(scratch.data(), scratch.length());
+						}else{
+							textRef = StringRef(lexer.text.begin, lexer.text.end - lexer.text.begin);
+						}
+						return current = EVENT_TEXT;
+					}
+					break;
+				case Lexer::TOKEN_DECLARATION:
+					setAttributes();
+					elementName = StringRef("?xml", 4);
+					return current = EVENT_DECLARATION;
+				case Lexer::TOKEN_START:
+					if(!lexer.name.empty()){
+						setAttributes();
+						elementName = StringRef(lexer.name.begin, lexer.name.end - lexer.name.begin);
+						if(selfClosing){
+							pendingEnd = true;
+						}else{
+							openOffsets.push_back(openNames.length());
+							openNames.append(lexer.name.begin, lexer.name.end);
+						}
+						return current = EVENT_START_ELEMENT;
+					}
+					break;
+				case Lexer::TOKEN_END:
+					//end tags which do not match the open element are ignored
+					if(!openOffsets.empty()){
+						const std::size_t offset = openOffsets.back();
+						const std::size_t length = openNames.length() - offset;
+						if(length == (std::size_t)(lexer.name.end - lexer.name.begin) && memcmp(openNames.data() + offset, lexer.name.begin, length) == 0){
+							openOffsets.pop_back();
+							openNames.resize(offset);
+							attributeList.clear();
+							elementName = StringRef(lexer.name.begin, length);
+							return current = EVENT_END_ELEMENT;
+						}
+					}
+					break;
+			}
+		}
+	}
+	
+	Lexer::Token Reader::nextToken(){
+		for(;;){
+			const Lexer::Token token = lexer.next();
+			if(token != Lexer::TOKEN_MORE && token != Lexer::TOKEN_NONE){
+				return token;
+			}else if(!fill()){
+				return Lexer::TOKEN_NONE;
+			}
+		}
+	}
+	
+	void Reader::closeElement(){
+		if(pendingEnd){
+			pendingEnd = false;
+		}else if(!openOffsets.empty()){
+			openNames.resize(openOffsets.back());
+			openOffsets.pop_back();
+		}
+		attributeList.clear();
+		elementName = StringRef();
+		current = EVENT_END_ELEMENT;
+	}
+	
+	void Reader::restart(){
+		openNames.clear();
+		openOffsets.clear();
+		attributeList.clear();
+		elementName = StringRef();
+		current = EVENT_END;
+		selfClosing = false;
+		pendingEnd = false;
+		consumed = 0;
+	}
+	
+	void Reader::parse(Handler& handler){
+		for(;;){
+			switch(next()){
+				case EVENT_START_ELEMENT:
+					handler.startElement(elementName);
+					for(unsigned int i = 0; i < attributeList.size(); ++i){
+						handler.attribute(attributeList[i].name, attributeList[i].value);
+					}
+					break;
+				case EVENT_END_ELEMENT:
+					handler.endElement(elementName);
+					break;
+				case EVENT_TEXT:
+					handler.text(textRef);
+					break;
+				case EVENT_DECLARATION:
+					break;
+				case EVENT_END:
+					return;
+			}
+		}
+	}
+	
+//-------------------------------Splitter---------------------------------------//
+	
+	//Gives the Reader's tokens to ReadContent.
+	class ReaderSource{
+	public:
+		ReaderSource(Reader& Owner):owner(Owner){}
+		
+		Lexer::Token next(Lexer&){
+			return owner.nextToken();
+		}
+		
+	private:
+		Reader& owner;
+	};
+	
+	//A path without a leading '/' matches at any depth.
+	static std::string SplitterPath(const std::string& path){
+		return (!path.empty() && path[0] == '/') ? path : "//" + path;
+	}
+	
+	Splitter::Splitter(std::istream& is, const std::string& path, std::size_t bufferSize):reader(is, bufferSize), query(SplitterPath(path)), matcher(query), matches(0){}
+	
+	Splitter::Splitter(const char* data, std::size_t length, const std::string& path):reader(data, length), query(SplitterPath(path)), matcher(query), matches(0){}
+	
+	Splitter::Splitter(std::istream& is, const Query& Query, std::size_t bufferSize):reader(is, bufferSize), query(Query), matcher(query), matches(0){}
+	
+	Splitter::Splitter(const char* data, std::size_t length, const Query& Query):reader(data, length), query(Query), matcher(query), matches(0){}
+	
+	Tag* Splitter::next(){
+		Tag* output = new Tag();
+		if(!next(output)){
+			delete output;
+			output = NULL;
+		}
+		return output;
+	}
+	
+	bool Splitter::next(Tag* output){
+		Reader::EVENT event;
+		while((event = reader.next()) != Reader::EVENT_END){
+			if(event == Reader::EVENT_END_ELEMENT){
+				matcher.endElement();
+			}else if(event == Reader::EVENT_START_ELEMENT && matcher.startElement(reader)){
+				output->clear();
+				SetName(output, reader.lexer.name);
+				SetAttributes(output, reader.lexer);
+				if(!reader.selfClosing){
+					ReaderSource source(reader);
+					ReadContent(output, source, reader.lexer);
+				}
+				reader.closeElement();
+				matcher.endElement();
+				++matches;
+				return true;
+			}
+		}
+		return false;
+	}
+	
+//-------------------------------PushParser---------------------------------------//
+	
+	//How much is added at once to text which was cut off, enough to finish an escape string or to tell text from markup.
+	static const std::size_t TextStep = 16;
+	
+	PushParser::PushParser(const std::string& RootName, bool UseArena):handler(NULL), rootName(RootName), useArena(UseArena), reader(NULL, 0), builder(output), markup(MARKUP_NONE), quote(0), lastMark(0), depth(0), matched(0), finished(false), fed(0){
+		start();
+	}
+	
+	PushParser::PushParser(Handler& Handler):handler(&Handler), useArena(false), reader(NULL, 0), builder(output), markup(MARKUP_NONE), quote(0), lastMark(0), depth(0), matched(0), finished(false), fed(0){
+		start();
+	}
+	
+	PushParser::~PushParser(){
+		output.deleteTags();
+	}
+	
+	void PushParser::start(){
+		output = Document();
+		if(handler == NULL){
+			if(useArena){
+				output.arena = new Arena();
+			}
+			output.atoms = new AtomTable();
+			output.createRoot(rootName);
+		}
+		builder.reset();
+		reader.restart();
+		pending.clear();
+		markup = MARKUP_NONE;
+		finished = false;
+		fed = 0;
+	}
+	
+	void PushParser::reset(){
+		output.deleteTags();
+		start();
+	}
+	
+	const char* PushParser::read(const char* begin, const char* end, bool final){
+		Lexer& lexer = reader.lexer;
+		lexer.reset(begin, end, final);
+		if(handler != NULL){
+			//the reader has no stream to fill from, so it stops where the input was cut off
+			reader.parse(*handler);
+		}else{
+			Lexer::Token token;
+			while((token = lexer.next()) != Lexer::TOKEN_NONE && token != Lexer::TOKEN_MORE){
+				builder.add(token, lexer);
+			}
+		}
+		return lexer.position();
+	}
+	
+	void PushParser::startMarkup(){
+		markup = MARKUP_NONE;
+		quote = lastMark = 0;
+		depth = 0;
+		matched = 0;
+		if(pending.length() < 2 || pending[0] != '<' || IsSpace(pending[1])){
+			return;
+		}
+		if(pending[1] == '/'){
+			markup = MARKUP_END_TAG;
+		}else if(pending[1] == '?'){
+			markup = MARKUP_INSTRUCTION;
+		}else if(pending[1] != '!'){
+			markup = MARKUP_TAG;
+		}else if(pending.length() < 9){
+			//the lexer needs 9 characters to tell a comment from CDATA, they are added a few at a time like text
+			return;
+		}else if(pending.compare(0, 4, "<!--") == 0){
+			markup = MARKUP_COMMENT;
+		}else if(pending.compare(0, 9, "<![CDATA[") == 0){
+			markup = MARKUP_CDATA;
+		}else{
+			markup = MARKUP_DOCTYPE;
+		}
+		//the lexer has already found that the markup does not end in pending, this only sets where the search is
+		scanMarkup(pending.data(), pending.data() + pending.length(), 0);
+	}
+	
+	const char* PushParser::scanMarkup(const char* begin, const char* end, std::size_t offset){
+		for(const char* s = begin; s < end; ++s){
+			const char c = *s;
+			const std::size_t index = offset + (s - begin);
+			switch(markup){
+				case MARKUP_TAG:
+					//like Lexer::readAttributes, a quote only starts a value after '='
+					if(quote != 0){
+						if(c == quote){
+							quote = 0;
+							lastMark = c;
+						}
+					}else if(c == '>'){
+						return s + 1;
+					}else if((c == '"' || c == '\'') && lastMark == '='){
+						quote = c;
+					}else if(!IsSpace(c)){
+						lastMark = c;
+					}
+					break;
+				case MARKUP_END_TAG:
+					if(c == '>'){
+						return s + 1;
+					}
+					break;
+				case MARKUP_DOCTYPE:
+					if(index < 2){
+						break;
+					}else if(c == '['){
+						++depth;
+					}else if(c == ']'){
+						--depth;
+					}else if(c == '>' && depth <= 0){
+						return s + 1;
+					}
+					break;
+				default:{
+					//the ending, which starts after the opening, like in Lexer::next
+					const char mark = (markup == MARKUP_COMMENT) ? '-' : (markup == MARKUP_CDATA) ? ']' : '?';
+					const std::size_t first = (markup == MARKUP_COMMENT) ? 4 : (markup == MARKUP_CDATA) ? 9 : 2;
+					const std::size_t length = (markup == MARKUP_INSTRUCTION) ? 1 : 2;
+					if(index < first){
+						break;
+					}else if(c == '>' && matched == length){
+						return s + 1;
+					}else if(c == mark){
+						if(matched < length){
+							++matched;
+						}
+					}else{
+						matched = 0;
+					}
+				}
+			}
+		}
+		return NULL;
+	}
+	
+	void PushParser::feed(const char* data, std::size_t length){
+		if(finished){
+			return;
+		}
+		fed += length;
+		const char* end = data + length;
+		
+		//finish the token which was cut off, adding only as much to it as it may need
+		while(!pending.empty() && data < end){
+			const char* next;
+			if(markup != MARKUP_NONE){
+				next = scanMarkup(data, end, pending.length());
+				if(next == NULL){
+					pending.append(data, end);
+					return;
+				}
+			}else{
+				next = ((std::size_t)(end - data) > TextStep) ? data + TextStep : end;
+			}
+			pending.append(data, next);
+			data = next;
+			const char* stop = read(pending.data(), pending.data() + pending.length(), false);
+			pending.erase(0, stop - pending.data());
+			startMarkup();
+		}
+		
+		//the rest is read where it is, keeping only the end of it
+		if(data < end){
+			pending.assign(read(data, end, false), end);
+			startMarkup();
+		}
+	}
+	
+	Document PushParser::finish(){
+		if(!finished){
+			read(pending.data(), pending.data() + pending.length(), true);
+			pending.clear();
+			markup = MARKUP_NONE;
+			finished = true;
+		}
+		//the document goes to the caller, leaving an empty one
+		Document result;
+		result.swap(output);
+		result.deleteTagsOnDestruction = Document::OwnedByDefault;
+		return result;
+	}
+	
+}; //end namespace XML
@@ -0,0 +1,228 @@
+#ifndef _XML_READER_H
+#define _XML_READER_H
+
+#include "XMLView.h"
+#include "XMLLexer.h"
+#include "XMLQuery.h"
+#include "XMLBuilder.h"
+
+namespace XML{
+	
+	class Reader;
+	class Splitter;
+	class PushParser;
+	class ReaderSource;
+	
+	//Callbacks for Reader::parse, every one does nothing by default.
+	//The references are only valid during the call.
+	class Handler{
+	public:
+		virtual ~Handler(){}
+		
+		virtual void startElement(const StringRef& /*name*/){}
+		//Called for each attribute after startElement, the value is as it is in the source, like Tag::attributes.
+		virtual void attribute(const StringRef& /*name*/, const StringRef& /*value*/){}
+		//The text is decoded, it may come in several pieces.
+		virtual void text(const StringRef& /*text*/){}
+		//Also called for self closing tags.
+		virtual void endElement(const StringRef& /*name*/){}
+	};
+	
+	//Pull parser which reads a document one event at a time.
+	//A stream is read in chunks through a buffer which only grows if a single tag does not fit in it,
+	//so documents of any size are read in constant memory, and nothing is allocated per event once the buffers have grown.
+	//Everything returned by the accessors is only valid until the next call to next().
+	class Reader{
+	public:
+		enum EVENT{
+			EVENT_END,				//the end of the document
+			EVENT_DECLARATION,		//the <?xml ...?> declaration, with its attributes
+			EVENT_START_ELEMENT,	//a start tag or a self closing tag, with its attributes
+			EVENT_END_ELEMENT,		//an end tag, or the end of a self closing tag
+			EVENT_TEXT				//decoded text inside of an element, long text may come in several pieces
+		};
+		
+		//Read from a stream in chunks of bufferSize.
+		Reader(std::istream& is, std::size_t bufferSize = 65536);
+		//Read from a buffer in memory, which is not copied.
+		Reader(const char* data, std::size_t length);
+		
+		EVENT next();
+		EVENT event() const{	return current;	}
+		
+		//The name of the element, for EVENT_START_ELEMENT and EVENT_END_ELEMENT.
+		const StringRef& name() const{	return elementName;	}
+		
+		//The attributes of the element or the declaration.
+		unsigned int attributeCount() const{	return attributeList.size();	}
+		const ViewAttribute& attributeAt(unsigned int index) const{	return attributeList[index];	}
+		//get the value of the attribute, NULL if the element does not have it.
+		const StringRef* attribute(const std::string& attributeName) const;
+		
+		//True for both events of a self closing tag.
+		bool isSelfClosing() const{	return selfClosing;	}
+		
+		//The decoded text, for EVENT_TEXT.
+		const StringRef& text() const{	return textRef;	}
+		
+		//The number of open elements, including the one just started.
+		unsigned int depth() const{	return openOffsets.size() + ((current == EVENT_START_ELEMENT && selfClosing) ? 1 : 0);	}
+		
+		//The number of bytes read so far.
+		std::size_t bytesRead() const{	return consumed + (lexer.position() - windowBegin);	}
+		
+		//Read the rest of the document, calling the handler for each event.
+		void parse(Handler& handler);
+		
+	private:
+		Lexer lexer;
+		std::istream* is;
+		std::vector<char> buffer;
+		const char* windowBegin;
+		const char* windowEnd;
+		bool final;
+		std::size_t consumed;
+		
+		EVENT current;
+		StringRef elementName;
+		std::vector<ViewAttribute> attributeList;
+		bool selfClosing;
+		bool pendingEnd;
+		StringRef textRef;
+		std::string scratch;
+		
+		//the names of the open elements, one after the other
+		std::string openNames;
+		std::vector<std::size_t> openOffsets;
+		
+		bool fill();
+		void setAttributes();
+		
+		//The next token, reading more of the stream as needed. Never returns TOKEN_MORE.
+		Lexer::Token nextToken();
+		//Finish the element just started, after its content has been read by someone else.
+		void closeElement();
+		//Forget the open elements, to read another document.
+		void restart();
+		
+		friend class Splitter;
+		friend class PushParser;
+		friend class ReaderSource;
+		
+		//not copyable
+		Reader(const Reader& other);
+		Reader& operator=(const Reader& other);
+	};
+	
+	//Reads every element matching a path from a document, building a Tag for each one and skipping everything else.
+	//The path is a Query, which is relative to the document unless it starts with '/':
+	//  "record"			every record element, at any depth
+	//  "feed/record"		every record element whose parent is a feed element
+	//  "/feed/record"		only the record elements just inside of the root feed element
+	//  "record[@type='a']"	every record element whose type attribute is a
+	//Elements inside of a match are part of that match, and are not matched themselves.
+	//The tags are built exactly like Tag::FromStream would build them.
+	class Splitter{
+	public:
+		Splitter(std::istream& is, const std::string& path, std::size_t bufferSize = 65536);
+		Splitter(const char* data, std::size_t length, const std::string& path);
+		//The query is evaluated from the document, like QueryMatcher::startElement.
+		Splitter(std::istream& is, const Query& query, std::size_t bufferSize = 65536);
+		Splitter(const char* data, std::size_t length, const Query& query);
+		
+		//Read the next match into a new Tag, returns NULL when there are no more.
+		Tag* next();
+		//Read the next match into output, which is cleared first, returns false when there are no more.
+		bool next(Tag* output);
+		
+		//The number of elements matched so far.
+		std::size_t count() const{	return matches;	}
+		
+	private:
+		Reader reader;
+		Query query;
+		QueryMatcher matcher;
+		std::size_t matches;
+	};
+	
+	//Reads a document from fragments of any size as they arrive, for input which can not be waited on, like a non blocking socket.
+	//A token cut off by the end of a fragment is kept until the rest of it is fed, only that part of the input is copied.
+	//Markup is only read again once what can end it has arrived, like "-->" for a comment or a '>' outside of quotes for a tag,
+	//and the search for it goes on from where the last fragment ended, so every fragment costs time in proportion to its size.
+	//It builds the same tree as Document::FromBuffer, or passes the same events to a handler as Reader::parse,
+	//though text may be split where the fragments were.
+	class PushParser{
+	public:
+		//Build a Document, like Document::FromBuffer.
+		PushParser(const std::string& rootName = "_root", bool useArena = false);
+		//Call the handler for every event instead, like Reader::parse.
+		PushParser(Handler& handler);
+		~PushParser();
+		
+		//Read the next fragment of the document, the data is not needed after the call.
+		void feed(const char* data, std::size_t length);
+		void feed(const std::string& data){	feed(data.data(), data.length());	}
+		
+		//The input has ended, read what is left and return the document, which then belongs to the caller like one from Document::FromBuffer.
+		//It has no root when a handler was given. Nothing more is read until reset() is called.
+		Document finish();
+		
+		//Start on a new document, deleting the tags of the last one unless finish() returned it.
+		void reset();
+		
+		//The document read so far, the last tags may still be open. It is empty once finish() has returned it.
+		const Document& document() const{	return output;	}
+		
+		//The number of bytes fed so far, and the number which were read to the end of a token.
+		std::size_t bytesFed() const{	return fed;	}
+		std::size_t bytesRead() const{	return fed - pending.length();	}
+		
+	private:
+		Handler* handler;
+		std::string rootName;
+		bool useArena;
+		
+		//the lexer of the reader is used for trees too
+		Reader reader;
+		Document output;
+		DocumentBuilder builder;
+		
+		//the end of the input which did not make a whole token yet
+		std::string pending;
+		//the markup which pending starts with, or MARKUP_NONE for text and markup which is too short to tell
+		enum MARKUP{
+			MARKUP_NONE,
+			MARKUP_TAG,
+			MARKUP_END_TAG,
+			MARKUP_COMMENT,
+			MARKUP_CDATA,
+			MARKUP_INSTRUCTION,
+			MARKUP_DOCTYPE
+		};
+		MARKUP markup;
+		//where the search for the end of the markup is: the quote of the attribute value a tag is in, or 0,
+		//the last character of a tag which was not a space, the depth of the brackets of a doctype,
+		//and how many characters of "-->", "]]>" or "?>" were just seen
+		char quote;
+		char lastMark;
+		int depth;
+		std::size_t matched;
+		bool finished;
+		std::size_t fed;
+		
+		void start();
+		//Read the tokens in [begin,end), returns where the tokens which were cut off start.
+		const char* read(const char* begin, const char* end, bool final);
+		//Find out which markup pending starts with, and search all of it for the end of the markup.
+		void startMarkup();
+		//Search [begin,end), which comes offset characters into the markup, for its end, returns the position after it or NULL.
+		const char* scanMarkup(const char* begin, const char* end, std::size_t offset);
+		
+		//not copyable
+		PushParser(const PushParser& other);
+		PushParser& operator=(const PushParser& other);
+	};
+	
+}; //end namespace XML
+
+#endif //_XML_READER_H
@@ -0,0 +1,159 @@
+#include "XMLScan.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define XML_SCAN_SSE2
+#include <emmintrin.h>
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define XML_SCAN_AVX2
+#include <immintrin.h>
+#define XML_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace XML{
+	
+	//The character sets
+	static const char TextSet[] = {'<', '&'};
+	static const char EscapeSet[] = {'"', '\'', '&', '>', '<'};
+	static const char NameEndSet[] = {' ', '\t', '\n', '\r', '=', '>', '/', '?'};
+	
+	inline unsigned int LowestBit(unsigned int mask){
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return index;
+#else
+		return __builtin_ctz(mask);
+#endif
+	}
+	
+	template<int N>
+	const char* ScanScalar(const char* p, const char* end, const char* set){
+		for(; p < end; ++p){
+			for(int i = 0; i < N; ++i){
+				if(*p == set[i])	return p;
+			}
+		}
+		return end;
+	}
+	
+#ifdef XML_SCAN_SSE2
+	template<int N>
+	const char* ScanSSE2(const char* p, const char* end, const char* set){
+		__m128i chars[N];
+		for(int i = 0; i < N; ++i){
+			chars[i] = _mm_set1_epi8(set[i]);
+		}
+		while(end - p >= 16){
+			const __m128i block = _mm_loadu_si128((const __m128i*)p);
+			__m128i match = _mm_cmpeq_epi8(block, chars[0]);
+			for(int i = 1; i < N; ++i){
+				match = _mm_or_si128(match, _mm_cmpeq_epi8(block, chars[i]));
+			}
+			const unsigned int mask = (unsigned int)_mm_movemask_epi8(match);
+			if(mask != 0){
+				return p + LowestBit(mask);
+			}
+			p += 16;
+		}
+		return ScanScalar<N>(p, end, set);
+	}
+#endif
+	
+#ifdef XML_SCAN_AVX2
+	template<int N>
+	XML_TARGET_AVX2 const char* ScanAVX2(const char* p, const char* end, const char* set){
+		__m256i chars[N];
+		for(int i = 0; i < N; ++i){
+			chars[i] = _mm256_set1_epi8(set[i]);
+		}
+		while(end - p >= 32){
+			const __m256i block = _mm256_loadu_si256((const __m256i*)p);
+			__m256i match = _mm256_cmpeq_epi8(block, chars[0]);
+			for(int i = 1; i < N; ++i){
+				match = _mm256_or_si256(match, _mm256_cmpeq_epi8(block, chars[i]));
+			}
+			const unsigned int mask = (unsigned int)_mm256_movemask_epi8(match);
+			if(mask != 0){
+				return p + LowestBit(mask);
+			}
+			p += 32;
+		}
+		return ScanSSE2<N>(p, end, set);
+	}
+#endif
+	
+	SCAN_LEVEL SupportedScanLevel(){
+#if defined(XML_SCAN_AVX2)
+		__builtin_cpu_init();
+		if(__builtin_cpu_supports("avx2")){
+			return SCAN_AVX2;
+		}
+		return SCAN_SSE2;
+#elif defined(XML_SCAN_SSE2)
+		return SCAN_SSE2;
+#else
+		return SCAN_SCALAR;
+#endif
+	}
+	
+	static SCAN_LEVEL& CurrentScanLevel(){
+		static SCAN_LEVEL level = SupportedScanLevel();
+		return level;
+	}
+	
+	SCAN_LEVEL GetScanLevel(){
+		return CurrentScanLevel();
+	}
+	
+	bool SetScanLevel(SCAN_LEVEL level){
+		if(level > SupportedScanLevel()){
+			return false;
+		}
+		CurrentScanLevel() = level;
+		return true;
+	}
+	
+	template<int N>
+	inline const char* Scan(const char* begin, const char* end, const char* set){
+		switch(CurrentScanLevel()){
+#ifdef XML_SCAN_AVX2
+			case SCAN_AVX2:
+				return ScanAVX2<N>(begin, end, set);
+#endif
+#ifdef XML_SCAN_SSE2
+			case SCAN_SSE2:
+				return ScanSSE2<N>(begin, end, set);
+#endif
+			default:
+				return ScanScalar<N>(begin, end, set);
+		}
+	}
+	
+	const char* ScanForChar(const char* begin, const char* end, char c){
+		//the C library already has a vectorized search for a single character
+		if(begin >= end){
+			return end;
+		}
+		const char* fnd = (const char*)memchr(begin, c, end - begin);
+		return (fnd == NULL) ? end : fnd;
+	}
+	
+	const char* ScanForText(const char* begin, const char* end){
+		return Scan<2>(begin, end, TextSet);
+	}
+	
+	const char* ScanForEscape(const char* begin, const char* end){
+		return Scan<5>(begin, end, EscapeSet);
+	}
+	
+	const char* ScanForNameEnd(const char* begin, const char* end){
+		return Scan<8>(begin, end, NameEndSet);
+	}
+	
+}; //end namespace XML
@@ -0,0 +1,39 @@
+#ifndef _XML_SCAN_H
+#define _XML_SCAN_H
+
+#include <cstddef>
+
+namespace XML{
+	
+	//Character class scanning for the parser and the escape functions.
+	//SSE2 and AVX2 versions are chosen at run time when the processor supports them, with a scalar fallback.
+	//Every function returns a pointer to the first matching character in [begin,end), or end if there is none.
+	
+	enum SCAN_LEVEL{
+		SCAN_SCALAR,
+		SCAN_SSE2,
+		SCAN_AVX2
+	};
+	
+	//The best level supported by the processor, and the level in use, which starts out as the best.
+	SCAN_LEVEL SupportedScanLevel();
+	SCAN_LEVEL GetScanLevel();
+	
+	//Use a lower level, for benchmarks and testing. Returns false if the level is not supported.
+	bool SetScanLevel(SCAN_LEVEL level);
+	
+	//Find c.
+	const char* ScanForChar(const char* begin, const char* end, char c);
+	
+	//Find the end of character data, '<', or an escape string, '&'.
+	const char* ScanForText(const char* begin, const char* end);
+	
+	//Find a character which has to be escaped, any of escapeCharacters.
+	const char* ScanForEscape(const char* begin, const char* end);
+	
+	//Find a character which can end a name: white space, '=', '>', '/' or '?'.
+	const char* ScanForNameEnd(const char* begin, const char* end);
+	
+}; //end namespace XML
+
+#endif //_XML_SCAN_H
@@ -0,0 +1,222 @@
+#include "XMLStats.h"
+#include "XMLBuilder.h"
+#include <ctime>
+
+#ifdef XML_CPP11
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <sys/time.h>
+#define XML_STATS_GETTIMEOFDAY
+#elif defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#define XML_STATS_PERFORMANCE_COUNTER
+#endif
+
+namespace XML{
+
+//-------------------------------ParseStats---------------------------------------//
+	
+	ParseStats::ParseStats(){
+		clear();
+	}
+	
+	void ParseStats::clear(){
+		documents = 0;
+		bytes = 0;
+		elements = 0;
+		attributes = 0;
+		textNodes = 0;
+		entities = 0;
+		maxDepth = 0;
+		treeBytes = 0;
+		seconds = 0;
+		tokenizeSeconds = 0;
+		unescapeSeconds = 0;
+		buildSeconds = 0;
+	}
+	
+	void ParseStats::add(const ParseStats& other){
+		documents += other.documents;
+		bytes += other.bytes;
+		elements += other.elements;
+		attributes += other.attributes;
+		textNodes += other.textNodes;
+		entities += other.entities;
+		if(other.maxDepth > maxDepth)	maxDepth = other.maxDepth;
+		treeBytes += other.treeBytes;
+		seconds += other.seconds;
+		tokenizeSeconds += other.tokenizeSeconds;
+		unescapeSeconds += other.unescapeSeconds;
+		buildSeconds += other.buildSeconds;
+	}
+	
+	std::ostream& ParseStats::writeToStream(std::ostream& os) const{
+		os << "{\"documents\":" << documents << ",\"bytes\":" << bytes;
+		os << ",\"elements\":" << elements << ",\"attributes\":" << attributes << ",\"text_nodes\":" << textNodes;
+		os << ",\"entities\":" << entities << ",\"max_depth\":" << maxDepth << ",\"tree_bytes\":" << treeBytes;
+		os << ",\"seconds\":" << seconds << ",\"tokenize_seconds\":" << tokenizeSeconds;
+		os << ",\"unescape_seconds\":" << unescapeSeconds << ",\"build_seconds\":" << buildSeconds << "}";
+		return os;
+	}
+	
+	std::ostream& operator<<(std::ostream& os, const ParseStats& stats){
+		return stats.writeToStream(os);
+	}
+	
+//-------------------------------Collection---------------------------------------//
+
+#ifdef XML_CPP11
+	static std::atomic<bool> enabled(false);
+	static std::mutex lock;
+	static thread_local ParseStats last;
+#else
+	static bool enabled = false;
+	static ParseStats last;
+#endif
+	static ParseStatsCallback callback = NULL;
+	static void* callbackContext = NULL;
+	
+	static ParseStats& Total(){
+		static ParseStats total;
+		return total;
+	}
+	
+	void EnableParseStats(bool enable){
+		enabled = enable;
+	}
+	
+	bool ParseStatsEnabled(){
+		return enabled;
+	}
+	
+	void SetParseStatsCallback(ParseStatsCallback Callback, void* context){
+#ifdef XML_CPP11
+		std::lock_guard<std::mutex> guard(lock);
+#endif
+		callback = Callback;
+		callbackContext = context;
+	}
+	
+	ParseStats LastParseStats(){
+		return last;
+	}
+	
+	ParseStats TotalParseStats(){
+#ifdef XML_CPP11
+		std::lock_guard<std::mutex> guard(lock);
+#endif
+		return Total();
+	}
+	
+	void ResetParseStats(){
+#ifdef XML_CPP11
+		std::lock_guard<std::mutex> guard(lock);
+#endif
+		Total().clear();
+	}
+	
+//-------------------------------Measuring---------------------------------------//
+	
+	//Wall clock time, clock() would only count the processor time of the process.
+	double StatsSeconds(){
+#ifdef XML_CPP11
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#elif defined(XML_STATS_GETTIMEOFDAY)
+		timeval now;
+		gettimeofday(&now, NULL);
+		return now.tv_sec + now.tv_usec * 1e-6;
+#elif defined(XML_STATS_PERFORMANCE_COUNTER)
+		LARGE_INTEGER now, frequency;
+		QueryPerformanceCounter(&now);
+		QueryPerformanceFrequency(&frequency);
+		return (double)now.QuadPart / frequency.QuadPart;
+#else
+		return (double)time(NULL);
+#endif
+	}
+	
+	void ParseTimer::finish(ParseStats& stats) const{
+		const double seconds = StatsSeconds() - startSeconds;
+		const unsigned long long ticks = StatsTicks() - startTicks;
+		const double secondsPerTick = (ticks > 0) ? seconds / ticks : 0;
+		stats.seconds = seconds;
+		stats.tokenizeSeconds = tokenize * secondsPerTick;
+		stats.unescapeSeconds = unescape * secondsPerTick;
+		stats.buildSeconds = build * secondsPerTick;
+	}
+	
+	std::size_t CountEntities(const Span& text){
+		std::size_t count = 0;
+		for(const char* s = text.begin; s < text.end; ++s){
+			if(*s == '&')	++count;
+		}
+		return count;
+	}
+	
+	//The heap memory of a string, nothing if it fits in the string itself.
+	static std::size_t StringBytes(const std::string& str){
+		static const std::size_t inlineCapacity = std::string().capacity();
+		return (str.capacity() > inlineCapacity) ? str.capacity() + 1 : 0;
+	}
+	
+	//Count the tags and strings under the tag, and estimate their size, the children of the tag are at depth 1.
+	static void CountTree(const Tag* top, ParseStats& stats){
+		std::vector<std::pair<const Tag*, std::size_t> > open(1, std::make_pair(top, (std::size_t)0));
+		while(!open.empty()){
+			const Tag* tag = open.back().first;
+			const std::size_t depth = open.back().second + 1;
+			open.pop_back();
+			
+			stats.treeBytes += sizeof(Tag) + StringBytes(tag->name) + tag->children.capacity() * sizeof(Object*);
+			if(tag->attributes.size() > Attributes::InlineCapacity){
+				stats.treeBytes += tag->attributes.size() * sizeof(Attributes::value_type);
+			}
+			//the keys are shared names, held once by the atoms of the document
+			for(Attributes::const_iterator it = tag->attributes.begin(); it != tag->attributes.end(); ++it){
+				stats.treeBytes += StringBytes(it->second);
+			}
+			
+			for(unsigned int i = 0; i < tag->children.size(); ++i){
+				const Object* child = tag->children[i];
+				if(child->getType() == XML_TAG){
+					++stats.elements;
+					stats.attributes += ((const Tag*)child)->attributes.size();
+					if(depth > stats.maxDepth)	stats.maxDepth = depth;
+					open.push_back(std::make_pair((const Tag*)child, depth));
+				}else{
+					++stats.textNodes;
+					stats.treeBytes += sizeof(String) + StringBytes(child->name);
+				}
+			}
+		}
+	}
+	
+	void RecordParseStats(const Document& document, ParseStats& stats){
+		stats.documents = 1;
+		if(document.declaration != NULL){
+			CountTree(document.declaration, stats);
+		}
+		if(document.root != NULL){
+			CountTree(document.root, stats);
+		}
+		
+		last = stats;
+		ParseStatsCallback call;
+		void* context;
+		{
+#ifdef XML_CPP11
+			std::lock_guard<std::mutex> guard(lock);
+#endif
+			Total().add(stats);
+			call = callback;
+			context = callbackContext;
+		}
+		if(call != NULL){
+			call(stats, context);
+		}
+	}
+	
+}; //end namespace XML
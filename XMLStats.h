@@ -0,0 +1,73 @@
+#ifndef _XML_STATS_H
+#define _XML_STATS_H
+
+#include <cstddef>
+#include <ostream>
+
+namespace XML{
+	
+	//What reading a document did, and where the time went.
+	//While statistics are enabled every document read by Document::FromBuffer, FromStream, FromFile, FromBufferParallel
+	//or a BatchParser is measured, and its statistics are kept for the thread which read it and added to a total for every thread.
+	//Otherwise the parsers only check that they are disabled, once per document.
+	//Measuring costs two readings of the processor's time stamp counter per token, and a walk over the tree.
+	struct ParseStats{
+		//the number of documents, 1 for one parse
+		std::size_t documents;
+		//the bytes read
+		std::size_t bytes;
+		//the tags, their attributes and the strings created
+		std::size_t elements;
+		std::size_t attributes;
+		std::size_t textNodes;
+		//the escape strings and character references decoded in text
+		std::size_t entities;
+		//the deepest tag, a top level tag is at depth 1
+		std::size_t maxDepth;
+		//an estimate of the size of the tree, from a walk over it after the parse: its objects, its child and attribute lists
+		//and the strings which do not fit in their objects. It is not the bytes allocated while reading, which also include
+		//what an arena keeps spare, the atoms and the buffers of the parser.
+		std::size_t treeBytes;
+		
+		//the time spent reading, from the start to the end of the parse
+		double seconds;
+		//and the part of it spent in the lexer, in decoding text, and in building tags and strings from the tokens
+		//FromBufferParallel does not split the time of a document it reads on several threads into these phases
+		double tokenizeSeconds;
+		double unescapeSeconds;
+		double buildSeconds;
+		
+		ParseStats();
+		
+		void clear();
+		
+		//Add the statistics of other, maxDepth becomes the larger of the two.
+		void add(const ParseStats& other);
+		
+		//Write the statistics as a JSON object, for the metrics of a service.
+		std::ostream& writeToStream(std::ostream& os) const;
+	};
+	
+	std::ostream& operator<<(std::ostream& os, const ParseStats& stats);
+	
+	//Called on the thread which read the document, after each document is measured.
+	typedef void (*ParseStatsCallback)(const ParseStats& stats, void* context);
+	
+	//Start or stop measuring, they are disabled by default.
+	void EnableParseStats(bool enable = true);
+	bool ParseStatsEnabled();
+	
+	//Call the callback for every document measured, NULL to stop. The callback is called by every thread which reads,
+	//it can look for pathological documents as they are read.
+	void SetParseStatsCallback(ParseStatsCallback callback, void* context = NULL);
+	
+	//The statistics of the last document measured on this thread. Without C++11 it is the last one of any thread.
+	ParseStats LastParseStats();
+	
+	//The sum of the statistics of every document measured on any thread since the last reset.
+	ParseStats TotalParseStats();
+	void ResetParseStats();
+	
+}; //end namespace XML
+
+#endif //_XML_STATS_H
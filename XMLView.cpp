@@ -0,0 +1,241 @@
+#include "XMLView.h"
+#include "XMLFile.h"
+#include "XMLLexer.h"
+#include "XMLScan.h"
+
+namespace XML{
+	
+//-----------------------------------STRING-REF-------------------------------------------//
+	
+	std::string StringRef::decoded() const{
+		std::string output;
+		appendDecoded(output);
+		return output;
+	}
+	
+	void StringRef::appendDecoded(std::string& output) const{
+		if(needsUnescape){
+			AppendDeEscaped(output, data, data + length);
+		}else{
+			output.append(data, length);
+		}
+	}
+	
+	bool StringRef::operator==(const std::string& str) const{
+		return length == str.length() && memcmp(data, str.data(), length) == 0;
+	}
+	
+	bool StringRef::operator==(const char* str) const{
+		const std::size_t strLength = strlen(str);
+		return length == strLength && memcmp(data, str, length) == 0;
+	}
+	
+	std::ostream& operator<<(std::ostream& os, const StringRef& ref){
+		return os.write(ref.data, ref.length);
+	}
+	
+//-----------------------------------VIEW-NODE--------------------------------------------//
+	
+	const StringRef* ViewNode::attribute(const std::string& attributeName) const{
+		for(unsigned int i = 0; i < attributeCount; ++i){
+			if(attributes[i].name == attributeName){
+				return &attributes[i].value;
+			}
+		}
+		return NULL;
+	}
+	
+	const ViewNode* ViewNode::childWithName(const std::string& childName) const{
+		for(const ViewNode* child = firstChild; child != NULL; child = child->next){
+			if(child->type == XML_TAG && child->name == childName){
+				return child;
+			}
+		}
+		return NULL;
+	}
+	
+	const ViewNode* ViewNode::childWithName(Atom childAtom) const{
+		for(const ViewNode* child = firstChild; child != NULL; child = child->next){
+			if(child->atom == childAtom && child->type == XML_TAG){
+				return child;
+			}
+		}
+		return NULL;
+	}
+	
+	const ViewNode* ViewNode::nextWithName() const{
+		for(const ViewNode* sibling = next; sibling != NULL; sibling = sibling->next){
+			if(sibling->atom == atom && sibling->type == XML_TAG){
+				return sibling;
+			}
+		}
+		return NULL;
+	}
+	
+	std::string ViewNode::text() const{
+		std::string output;
+		for(const ViewNode* child = firstChild; child != NULL; child = child->next){
+			if(child->type == XML_STRING){
+				child->name.appendDecoded(output);
+			}
+		}
+		return output;
+	}
+	
+	std::ostream& ViewNode::writeToStream(std::ostream& os) const{
+		if(type == XML_STRING){
+			return os << EscapeString(name.decoded());
+		}
+		
+		os << '<' << name;
+		for(unsigned int i = 0; i < attributeCount; ++i){
+			os << ' ' << attributes[i].name;
+			if(!attributes[i].value.empty()){
+				os << "=\"" << attributes[i].value << '"';
+			}
+		}
+		
+		if(firstChild == NULL && selfClosing){ //close self
+			os << " />";
+		}else{
+			os << '>';
+			for(const ViewNode* child = firstChild; child != NULL; child = child->next){
+				child->writeToStream(os);
+			}
+			os << "</" << name << '>';
+		}
+		return os;
+	}
+	
+//-----------------------------------READ-ONLY-DOCUMENT-----------------------------------//
+	
+	ReadOnlyDocument::ReadOnlyDocument():declaration(NULL), root(NULL), source(NULL){}
+	
+	ReadOnlyDocument::~ReadOnlyDocument(){
+		if(source != NULL){
+			delete source;
+		}
+	}
+	
+	ViewNode* ReadOnlyDocument::newNode(XML_OBJECT_TYPE type, ViewNode* parent){
+		ViewNode* node = (ViewNode*)arena.allocate(sizeof(ViewNode));
+		node->type = type;
+		node->name = StringRef();
+		node->atom = NoAtom;
+		node->parent = parent;
+		node->firstChild = NULL;
+		node->next = NULL;
+		node->attributes = NULL;
+		node->attributeCount = 0;
+		node->selfClosing = false;
+		return node;
+	}
+	
+	//Copy the attribute references of the last token into the arena.
+	static void SetAttributes(ViewNode* node, const Lexer& lexer, Arena& arena){
+		node->attributeCount = lexer.attributes.size();
+		node->selfClosing = lexer.selfClosing;
+		if(node->attributeCount > 0){
+			ViewAttribute* attributes = (ViewAttribute*)arena.allocate(sizeof(ViewAttribute) * node->attributeCount);
+			for(unsigned int i = 0; i < node->attributeCount; ++i){
+				const Span& name = lexer.attributes[i].first;
+				const Span& value = lexer.attributes[i].second;
+				attributes[i].name = StringRef(name.begin, name.end - name.begin);
+				attributes[i].value = StringRef(value.begin, value.end - value.begin, ScanForChar(value.begin, value.end, '&') != value.end);
+			}
+			node->attributes = attributes;
+		}
+	}
+	
+	void ReadOnlyDocument::read(const char* data, std::size_t length){
+		ViewNode* top = newNode(XML_TAG, NULL);
+		top->name = StringRef("_root", 5);
+		top->atom = atomTable.intern("_root", 5);
+		root = top;
+		
+		//the open tags, and the last child of each of them
+		std::vector<ViewNode*> open(1, top);
+		std::vector<ViewNode*> last(1, (ViewNode*)NULL);
+		bool first = true;
+		
+		Lexer lexer;
+		lexer.reset(data, data + length);
+		Lexer::Token token;
+		while((token = lexer.next()) != Lexer::TOKEN_NONE){
+			ViewNode* node = NULL;
+			switch(token){
+				case Lexer::TOKEN_TEXT:
+				case Lexer::TOKEN_CDATA:
+					//text outside of the top level tags is ignored
+					if(open.size() > 1){
+						const std::size_t textLength = lexer.text.end - lexer.text.begin;
+						node = newNode(XML_STRING, open.back());
+						node->name = StringRef(lexer.text.begin, textLength, token == Lexer::TOKEN_TEXT && lexer.textEscaped);
+					}
+					break;
+				case Lexer::TOKEN_DECLARATION:
+					if(first){
+						ViewNode* tag = newNode(XML_TAG, NULL);
+						tag->name = StringRef("?xml", 4);
+						tag->atom = atomTable.intern("?xml", 4);
+						SetAttributes(tag, lexer, arena);
+						tag->selfClosing = false;
+						declaration = tag;
+						first = false;
+					}
+					break;
+				case Lexer::TOKEN_START:
+					if(!lexer.name.empty()){
+						first = false;
+						node = newNode(XML_TAG, open.back());
+						node->name = StringRef(lexer.name.begin, lexer.name.end - lexer.name.begin);
+						node->atom = atomTable.intern(lexer.name.begin, lexer.name.end - lexer.name.begin);
+						SetAttributes(node, lexer, arena);
+					}
+					break;
+				case Lexer::TOKEN_END:
+					//end tags which do not match the open tag are ignored
+					if(open.size() > 1 && open.back()->name.length == (std::size_t)(lexer.name.end - lexer.name.begin) && memcmp(open.back()->name.data, lexer.name.begin, open.back()->name.length) == 0){
+						open.pop_back();
+						last.pop_back();
+					}
+					break;
+				case Lexer::TOKEN_NONE:
+				case Lexer::TOKEN_MORE:
+					break;
+			}
+			
+			if(node != NULL){
+				if(last.back() == NULL){
+					open.back()->firstChild = node;
+				}else{
+					last.back()->next = node;
+				}
+				last.back() = node;
+				if(node->type == XML_TAG && !node->selfClosing){
+					open.push_back(node);
+					last.push_back(NULL);
+				}
+			}
+		}
+	}
+	
+	ReadOnlyDocument* ReadOnlyDocument::FromBuffer(const char* data, std::size_t length){
+		ReadOnlyDocument* output = new ReadOnlyDocument();
+		output->read(data, length);
+		return output;
+	}
+	
+	ReadOnlyDocument* ReadOnlyDocument::FromFile(const std::string& path){
+		MappedFile* file = new MappedFile();
+		if(!file->open(path)){
+			delete file;
+			return NULL;
+		}
+		ReadOnlyDocument* output = new ReadOnlyDocument();
+		output->source = file;
+		output->read(file->data(), file->size());
+		return output;
+	}
+	
+}; //end namespace XML
@@ -0,0 +1,121 @@
+#ifndef _XML_VIEW_H
+#define _XML_VIEW_H
+
+#include "XML.h"
+#include "XMLArena.h"
+#include "XMLAtom.h"
+
+namespace XML{
+	
+	//A reference to characters in the source of a read only document.
+	struct StringRef{
+		const char* data;
+		std::size_t length;
+		//true if the characters contain escape strings, which are only decoded when asked for.
+		bool needsUnescape;
+		
+		StringRef():data(NULL), length(0), needsUnescape(false){}
+		StringRef(const char* Data, std::size_t Length, bool NeedsUnescape = false):data(Data), length(Length), needsUnescape(NeedsUnescape){}
+		
+		bool empty() const{	return length == 0;	}
+		
+		//The characters as they are in the source.
+		std::string str() const{	return std::string(data, length);	}
+		
+		//The characters with the escape strings decoded.
+		std::string decoded() const;
+		void appendDecoded(std::string& output) const;
+		
+		bool operator==(const std::string& str) const;
+		bool operator==(const char* str) const;
+		bool operator!=(const std::string& str) const{	return !(*this == str);	}
+		bool operator!=(const char* str) const{	return !(*this == str);	}
+		
+		friend std::ostream& operator<<(std::ostream& os, const StringRef& ref);
+	};
+	
+	struct ViewAttribute{
+		StringRef name;
+		//as it is in the source, like Tag::attributes
+		StringRef value;
+	};
+	
+	//A node of a read only document, either a tag or a string.
+	//Like Object::name, name holds the text of a string.
+	struct ViewNode{
+		XML_OBJECT_TYPE type;
+		StringRef name;
+		//The atom of the name in the atoms of the document, NoAtom for strings.
+		Atom atom;
+		
+		const ViewNode* parent;
+		const ViewNode* firstChild;
+		const ViewNode* next;
+		
+		const ViewAttribute* attributes;
+		unsigned int attributeCount;
+		bool selfClosing;
+		
+		bool isTag() const{	return type == XML_TAG;	}
+		bool isString() const{	return type == XML_STRING;	}
+		
+		//get the value of the attribute, NULL if the tag does not have it.
+		const StringRef* attribute(const std::string& attributeName) const;
+		
+		//get the first child with name
+		const ViewNode* childWithName(const std::string& childName) const;
+		const ViewNode* childWithName(Atom childAtom) const;
+		
+		//get the next sibling tag with the same name
+		const ViewNode* nextWithName() const;
+		
+		//The decoded text of the string children.
+		std::string text() const;
+		
+		//Write the node as it was read, like Tag::writeToStream writes a tag read by Document::FromBuffer:
+		//only tags read as <name/> close themselves, <name></name> stays as it is.
+		//A Tag without children, built by hand, is written as <name /> instead.
+		std::ostream& writeToStream(std::ostream& os) const;
+	};
+	
+	//A document which is only read, parsed without copying anything out of its source.
+	//Names, attributes and text reference the source, which has to outlive the document unless it was read with FromFile.
+	//Strings are not combined across comments or CDATA sections, and no empty strings are added in front of markup.
+	class ReadOnlyDocument{
+	public:
+		~ReadOnlyDocument();
+		
+		//The declaration tag, NULL if the document does not have one.
+		const ViewNode* declaration;
+		
+		//A tag named "_root" which holds every top level tag.
+		const ViewNode* root;
+		
+		//The names of the tags, ViewNode::atom is their atom in it.
+		const AtomTable& atoms() const{	return atomTable;	}
+		
+		//Read a document from a buffer in memory, the buffer is not copied.
+		static ReadOnlyDocument* FromBuffer(const char* data, std::size_t length);
+		
+		//Read a document from a file, which is memory mapped and kept alive by the document.
+		//Returns NULL if the file could not be opened.
+		static ReadOnlyDocument* FromFile(const std::string& path);
+		
+	private:
+		Arena arena;
+		AtomTable atomTable;
+		MappedFile* source;
+		
+		ReadOnlyDocument();
+		
+		void read(const char* data, std::size_t length);
+		ViewNode* newNode(XML_OBJECT_TYPE type, ViewNode* parent);
+		
+		//not copyable
+		ReadOnlyDocument(const ReadOnlyDocument& other);
+		ReadOnlyDocument& operator=(const ReadOnlyDocument& other);
+	};
+	
+}; //end namespace XML
+
+#endif //_XML_VIEW_H
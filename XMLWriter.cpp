@@ -0,0 +1,127 @@
+#include "XMLWriter.h"
+
+namespace XML{
+	
+	Writer::Writer(OutputBuffer& Output):output(&Output), ownOutput(NULL), startOpen(false), started(false){}
+	
+	Writer::Writer(std::ostream& os, std::size_t chunkSize):output(NULL), ownOutput(NULL), startOpen(false), started(false){
+		output = ownOutput = new OutputBuffer(os, chunkSize);
+	}
+	
+	Writer::Writer(int fd, std::size_t chunkSize):output(NULL), ownOutput(NULL), startOpen(false), started(false){
+		output = ownOutput = new OutputBuffer(fd, chunkSize);
+	}
+	
+	Writer::Writer(OutputCallback callback, void* context, std::size_t chunkSize):output(NULL), ownOutput(NULL), startOpen(false), started(false){
+		output = ownOutput = new OutputBuffer(callback, context, chunkSize);
+	}
+	
+	Writer::~Writer(){
+		finish();
+		if(ownOutput != NULL){
+			delete ownOutput;
+		}
+	}
+	
+	void Writer::closeStart(){
+		if(startOpen){
+			output->put('>');
+			startOpen = false;
+		}
+	}
+	
+	bool Writer::declaration(const std::string& version, const std::string& encoding){
+		if(started){
+			return false;
+		}
+		output->write("<?xml version=\"", 15);
+		output->writeEscaped(version);
+		output->put('"');
+		if(!encoding.empty()){
+			output->write(" encoding=\"", 11);
+			output->writeEscaped(encoding);
+			output->put('"');
+		}
+		output->write("?>", 2);
+		started = true;
+		return true;
+	}
+	
+	bool Writer::startElement(const char* name, std::size_t length){
+		if(length == 0){
+			return false;
+		}
+		closeStart();
+		output->put('<');
+		output->write(name, length);
+		openOffsets.push_back(openNames.length());
+		openNames.append(name, length);
+		startOpen = true;
+		started = true;
+		return true;
+	}
+	
+	bool Writer::attribute(const char* name, std::size_t nameLength, const char* value, std::size_t valueLength){
+		if(!startOpen || nameLength == 0){
+			return false;
+		}
+		output->put(' ');
+		output->write(name, nameLength);
+		output->write("=\"", 2);
+		output->writeEscaped(value, valueLength);
+		output->put('"');
+		return true;
+	}
+	
+	bool Writer::text(const char* data, std::size_t length){
+		if(openOffsets.empty()){
+			return false;
+		}
+		//nothing is written, so the element can still be <name />
+		if(length == 0){
+			return true;
+		}
+		closeStart();
+		output->writeEscaped(data, length);
+		return true;
+	}
+	
+	bool Writer::raw(const char* data, std::size_t length){
+		closeStart();
+		output->write(data, length);
+		started = true;
+		return true;
+	}
+	
+	bool Writer::endElement(){
+		if(openOffsets.empty()){
+			return false;
+		}
+		const std::size_t offset = openOffsets.back();
+		if(startOpen){
+			output->write(" />", 3);
+			startOpen = false;
+		}else{
+			output->write("</", 2);
+			output->write(openNames.data() + offset, openNames.length() - offset);
+			output->put('>');
+		}
+		openNames.resize(offset);
+		openOffsets.pop_back();
+		return true;
+	}
+	
+	bool Writer::element(const std::string& name, const std::string& value){
+		if(!startElement(name)){
+			return false;
+		}
+		text(value);
+		return endElement();
+	}
+	
+	bool Writer::finish(){
+		while(endElement()){}
+		return output->flush();
+	}
+	
+}; //end namespace XML
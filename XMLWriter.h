@@ -0,0 +1,82 @@
+#ifndef _XML_WRITER_H
+#define _XML_WRITER_H
+
+#include "XMLOutput.h"
+#include <string>
+#include <vector>
+
+namespace XML{
+	
+	//Writes a document one piece at a time, without building tags, in memory which only grows with the depth of the elements.
+	//Text and attribute values are escaped like EscapeString, elements are closed in the right order, and an element
+	//which is ended right after it was started is written as <name />, like Tag does.
+	//The output goes through an OutputBuffer, which passes it on to a stream, a file descriptor or a callback in large chunks.
+	//Calls which do not fit where the writer is, like an attribute after text or ending an element when none is open, return false and write nothing.
+	class Writer{
+	public:
+		//Write to a buffer, which has to outlive the writer.
+		Writer(OutputBuffer& output);
+		//Write to a stream, a file descriptor or a callback, in chunks of chunkSize.
+		Writer(std::ostream& os, std::size_t chunkSize = 65536);
+		Writer(int fd, std::size_t chunkSize = 65536);
+		Writer(OutputCallback callback, void* context, std::size_t chunkSize = 65536);
+		//Ends every open element and flushes the output.
+		~Writer();
+		
+		//Write the <?xml ?> declaration, which has to come first.
+		bool declaration(const std::string& version = "1.0", const std::string& encoding = "");
+		
+		bool startElement(const char* name, std::size_t length);
+		bool startElement(const std::string& name){	return startElement(name.data(), name.length());	}
+		
+		//Add an attribute to the element just started, before anything is written inside of it.
+		bool attribute(const char* name, std::size_t nameLength, const char* value, std::size_t valueLength);
+		bool attribute(const std::string& name, const std::string& value){	return attribute(name.data(), name.length(), value.data(), value.length());	}
+		
+		//Write text inside of the open element, escaping it.
+		bool text(const char* data, std::size_t length);
+		bool text(const std::string& str){	return text(str.data(), str.length());	}
+		
+		//Write text which is already escaped, or markup, as it is.
+		bool raw(const char* data, std::size_t length);
+		bool raw(const std::string& str){	return raw(str.data(), str.length());	}
+		
+		//End the innermost open element.
+		bool endElement();
+		
+		//An element holding only text, <name>text</name>.
+		bool element(const std::string& name, const std::string& value);
+		
+		//End every open element and flush the output, returns false if writing has failed.
+		bool finish();
+		
+		//The number of open elements.
+		std::size_t depth() const{	return openOffsets.size();	}
+		
+		//false once writing to the sink has failed.
+		bool good() const{	return output->good();	}
+		
+	private:
+		OutputBuffer* output;
+		//the buffer when the writer made it
+		OutputBuffer* ownOutput;
+		
+		//the names of the open elements, one after the other
+		std::string openNames;
+		std::vector<std::size_t> openOffsets;
+		//true while the start tag of the innermost element is not closed, so attributes can be added and it can still become <name />
+		bool startOpen;
+		//true once anything is written
+		bool started;
+		
+		//Close the start tag of the innermost element, before something is written inside of it.
+		void closeStart();
+		
+		//not copyable
+		Writer(const Writer& other);
+		Writer& operator=(const Writer& other);
+	};
+	
+}; //end namespace XML
+
+#endif //_XML_WRITER_H
@@ -0,0 +1,1145 @@
+//Measures the throughput and the allocations of the readers, the writers and the lookups on synthetic corpora.
+//Every measurement is printed as a JSON object on a line of its own, so runs can be kept and compared between releases:
+//	{"benchmark":"parse.buffer","corpus":"wide","threads":1,"runs":5,"seconds":0.021500,"bytes":4000120,"mb_per_s":186.05,"allocations":84012,"allocated_bytes":5120044,"ok":true}
+//seconds is the best of the runs, allocations are counted on the last one, once the buffers which are kept have grown.
+//Every result is checked against what Document::FromBuffer reads, ok is false if they differ and the exit status is then 1.
+//Usage: Benchmark [scale] [prefix]
+//scale multiplies the size of the corpora, about 4 MB each by default, and only the benchmarks whose names start with prefix are run.
+//Built by the CMake build of the repository root, or with:
+//	g++ -O2 -std=c++11 -pthread -I. bench/Benchmark.cpp XML*.cpp -o Benchmark
+
+#include "../XML.h"
+#include "../XMLAtom.h"
+#include "../XMLBatch.h"
+#include "../XMLBind.h"
+#include "../XMLCache.h"
+#include "../XMLCompact.h"
+#include "../XMLOutput.h"
+#include "../XMLQuery.h"
+#include "../XMLReader.h"
+#include "../XMLStats.h"
+#include "../XMLWriter.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef XML_CPP11
+#include <atomic>
+#include <chrono>
+#include <thread>
+#endif
+
+//-------------------------------Allocations---------------------------------------//
+
+#ifdef XML_CPP11
+static std::atomic<unsigned long> allocationCount(0);
+static std::atomic<unsigned long long> allocatedBytes(0);
+#define BENCHMARK_THROWS_BAD_ALLOC
+#define BENCHMARK_THROWS_NOTHING noexcept
+#else
+static unsigned long allocationCount = 0;
+static unsigned long long allocatedBytes = 0;
+#define BENCHMARK_THROWS_BAD_ALLOC throw(std::bad_alloc)
+#define BENCHMARK_THROWS_NOTHING throw()
+#endif
+
+//Kept out of line, otherwise GCC sees malloc paired with operator delete, or operator new with free, where they are inlined.
+#ifdef __GNUC__
+#define BENCHMARK_NOINLINE __attribute__((noinline))
+#else
+#define BENCHMARK_NOINLINE
+#endif
+
+BENCHMARK_NOINLINE void* operator new(std::size_t size) BENCHMARK_THROWS_BAD_ALLOC{
+	++allocationCount;
+	allocatedBytes += size;
+	void* p = malloc(size == 0 ? 1 : size);
+	if(p == NULL){
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void* operator new[](std::size_t size) BENCHMARK_THROWS_BAD_ALLOC{
+	return operator new(size);
+}
+
+BENCHMARK_NOINLINE void operator delete(void* p) BENCHMARK_THROWS_NOTHING{
+	free(p);
+}
+
+void operator delete[](void* p) BENCHMARK_THROWS_NOTHING{
+	operator delete(p);
+}
+
+//-------------------------------Corpora---------------------------------------//
+
+static const char* Words[] = {"lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing", "elit", "sed", "do"};
+static const unsigned int NumberOfWords = sizeof(Words) / sizeof(Words[0]);
+
+static const char* Word(){
+	return Words[rand() % NumberOfWords];
+}
+
+static std::string Number(std::size_t n){
+	char buffer[32];
+	sprintf(buffer, "%lu", (unsigned long)n);
+	return buffer;
+}
+
+//The documents of one kind, and what they should be read as.
+struct Corpus{
+	const char* name;
+	std::string data;
+	//every document of the corpus, one after the other in data
+	std::vector<XML::Buffer> documents;
+	//the documents read by Document::FromBuffer and written again
+	std::string expected;
+	//the number of tags in all of the documents
+	std::size_t tags;
+	//the number of repeated records the generator wrote, which the lookups look for
+	std::size_t records;
+	
+	Corpus(const char* Name):name(Name), tags(0), records(0){}
+};
+
+static std::size_t CountTags(const XML::Tag* tag){
+	std::size_t count = 0;
+	for(unsigned int i = 0; i < tag->children.size(); ++i){
+		if(tag->children[i]->getType() == XML::XML_TAG){
+			count += 1 + CountTags((const XML::Tag*)tag->children[i]);
+		}
+	}
+	return count;
+}
+
+//Split data into its documents, given where each one starts, and read them for the checks.
+static void Finish(Corpus& corpus, const std::vector<std::size_t>& starts){
+	for(std::size_t i = 0; i < starts.size(); ++i){
+		const std::size_t end = (i + 1 < starts.size()) ? starts[i + 1] : corpus.data.length();
+		corpus.documents.push_back(XML::Buffer(corpus.data.data() + starts[i], end - starts[i]));
+	}
+	std::ostringstream os;
+	for(std::size_t i = 0; i < corpus.documents.size(); ++i){
+		XML::Document document = XML::Document::FromBuffer(corpus.documents[i].data, corpus.documents[i].length);
+		document.writeToStream(os);
+		corpus.tags += CountTags(document.root);
+		document.deleteTags();
+	}
+	corpus.expected = os.str();
+}
+
+//Records nested 128 levels deep.
+static void Deep(Corpus& corpus, std::size_t size){
+	std::string& output = corpus.data;
+	output = "<?xml version=\"1.0\"?>\n<deep>\n";
+	while(output.length() < size){
+		for(unsigned int depth = 0; depth < 128; ++depth){
+			output += "<level depth=\"" + Number(depth) + "\">";
+			output += Word();
+		}
+		for(unsigned int depth = 0; depth < 128; ++depth){
+			output += "</level>";
+		}
+		output += '\n';
+		++corpus.records;
+	}
+	output += "</deep>\n";
+	Finish(corpus, std::vector<std::size_t>(1, 0));
+}
+
+//A flat catalog of items with 20 children each, ten of them named "tag".
+static void Wide(Corpus& corpus, std::size_t size){
+	std::string& output = corpus.data;
+	output = "<?xml version=\"1.0\"?>\n<catalog>\n";
+	while(output.length() < size){
+		output += "<item id=\"" + Number(corpus.records) + "\">";
+		for(unsigned int field = 0; field < 10; ++field){
+			output += "<f" + Number(field) + ">";
+			output += Word();
+			output += "</f" + Number(field) + "><tag>";
+			output += Word();
+			output += "</tag>";
+		}
+		output += "</item>\n";
+		++corpus.records;
+	}
+	output += "</catalog>\n";
+	Finish(corpus, std::vector<std::size_t>(1, 0));
+}
+
+//Self closing tags with many long attribute values, some of them escaped.
+static void Attributes(Corpus& corpus, std::size_t size){
+	std::string& output = corpus.data;
+	output = "<?xml version=\"1.0\"?>\n<records>\n";
+	while(output.length() < size){
+		output += "<record";
+		for(unsigned int a = 0; a < 6; ++a){
+			output += " attribute" + Number(a) + "=\"";
+			for(unsigned int w = 0; w < 6; ++w){
+				output += Word();
+				output += (w == 3 && a % 2 == 0) ? " &quot;" : " ";
+			}
+			output += '"';
+		}
+		output += "/>\n";
+		++corpus.records;
+	}
+	output += "</records>\n";
+	Finish(corpus, std::vector<std::size_t>(1, 0));
+}
+
+//Long paragraphs of text with entities and character references.
+static void Text(Corpus& corpus, std::size_t size){
+	static const char* Entities[] = {" &amp; ", " &lt;b&gt; ", " &#233; ", " &quot;", "&apos; "};
+	std::string& output = corpus.data;
+	output = "<?xml version=\"1.0\"?>\n<document>\n";
+	while(output.length() < size){
+		output += "<p>";
+		for(unsigned int w = 0; w < 200; ++w){
+			output += Word();
+			output += (w % 20 == 19) ? Entities[(w / 20) % 5] : " ";
+		}
+		output += "</p>\n";
+		++corpus.records;
+	}
+	output += "</document>\n";
+	Finish(corpus, std::vector<std::size_t>(1, 0));
+}
+
+//A large comment full of '>', then records with comments, CDATA, processing instructions and attribute values holding '>' and the
+//start of their endings, for the readers which have to find where markup ends when it is cut off.
+//They also hold "<record", which FromBufferParallel looks for to split the records, so some of the places it tries are inside of them.
+static void Markup(Corpus& corpus, std::size_t size){
+	std::string& output = corpus.data;
+	output = "<?xml version=\"1.0\"?>\n<markup>\n<!--";
+	while(output.length() < size / 4){
+		output += Word();
+		output += " -> <record> ";
+	}
+	output += "-->\n";
+	while(output.length() < size){
+		output += "<record note=\"a -> <record b\" id='" + Number(corpus.records) + "'><!-- <record " + Word() + " -- > --><![CDATA[<record " + Word() + " ]> ]]]><?note <record " + Word() + " ? > ?>";
+		output += Word();
+		output += "</record>\n";
+		++corpus.records;
+	}
+	output += "</markup>\n";
+	Finish(corpus, std::vector<std::size_t>(1, 0));
+}
+
+//Many small messages, each a document of its own.
+static void Tiny(Corpus& corpus, std::size_t size){
+	std::string& output = corpus.data;
+	std::vector<std::size_t> starts;
+	while(output.length() < size){
+		starts.push_back(output.length());
+		output += "<?xml version=\"1.0\"?>\n<message id=\"" + Number(corpus.records) + "\" type=\"note\"><from>";
+		output += Word();
+		output += "</from><to>";
+		output += Word();
+		output += "</to><body>";
+		output += Word();
+		output += " &amp; ";
+		output += Word();
+		output += "</body></message>\n";
+		++corpus.records;
+	}
+	Finish(corpus, starts);
+}
+
+//-------------------------------Measurements---------------------------------------//
+
+static const unsigned int Runs = 5;
+static std::string prefix;
+static bool failed = false;
+
+static double Now(){
+#ifdef XML_CPP11
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#else
+	return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+static unsigned int HardwareThreads(){
+#ifdef XML_CPP11
+	const unsigned int threads = std::thread::hardware_concurrency();
+	return threads == 0 ? 1 : threads;
+#else
+	return 1;
+#endif
+}
+
+//Something to measure, only run() is timed.
+class Benchmark{
+public:
+	const char* name;
+	
+	Benchmark(const char* Name):name(Name){}
+	virtual ~Benchmark(){}
+	
+	//Called before every run.
+	virtual void prepare(){}
+	virtual void run() = 0;
+	//Called after every run, check the result and throw it away, returns false if it is wrong.
+	virtual bool finish() = 0;
+	
+	//What one run does, for the rates, 0 if it does not apply.
+	virtual std::size_t bytes() const{	return 0;	}
+	virtual std::size_t operations() const{	return 0;	}
+	virtual unsigned int threads() const{	return 1;	}
+};
+
+static void Measure(Benchmark& benchmark, const Corpus& corpus){
+	if(strncmp(benchmark.name, prefix.c_str(), prefix.length()) != 0){
+		return;
+	}
+	double best = 1e30;
+	unsigned long allocations = 0;
+	unsigned long long allocated = 0;
+	bool ok = true;
+	for(unsigned int run = 0; run < Runs; ++run){
+		benchmark.prepare();
+		const unsigned long allocationsBefore = allocationCount;
+		const unsigned long long allocatedBefore = allocatedBytes;
+		const double start = Now();
+		benchmark.run();
+		const double seconds = Now() - start;
+		allocations = allocationCount - allocationsBefore;
+		allocated = allocatedBytes - allocatedBefore;
+		if(seconds < best)	best = seconds;
+		ok = benchmark.finish() && ok;
+	}
+	if(best <= 0)	best = 1e-9;
+	
+	printf("{\"benchmark\":\"%s\",\"corpus\":\"%s\",\"threads\":%u,\"runs\":%u,\"seconds\":%.6f", benchmark.name, corpus.name, benchmark.threads(), Runs, best);
+	if(benchmark.bytes() != 0){
+		printf(",\"bytes\":%lu,\"mb_per_s\":%.2f", (unsigned long)benchmark.bytes(), benchmark.bytes() / 1e6 / best);
+	}
+	if(benchmark.operations() != 0){
+		printf(",\"operations\":%lu,\"ops_per_s\":%.0f", (unsigned long)benchmark.operations(), benchmark.operations() / best);
+	}
+	printf(",\"allocations\":%lu,\"allocated_bytes\":%llu,\"ok\":%s}\n", allocations, allocated, ok ? "true" : "false");
+	fflush(stdout);
+	failed = failed || !ok;
+}
+
+//-------------------------------Readers---------------------------------------//
+
+//Reads every document of a corpus into a Document, which is checked by writing it again.
+class ParseBenchmark : public Benchmark{
+public:
+	ParseBenchmark(const char* Name, const Corpus& Corpus):Benchmark(Name), corpus(Corpus){}
+	
+	void prepare(){
+		documents.reserve(corpus.documents.size());
+	}
+	
+	void run(){
+		for(std::size_t i = 0; i < corpus.documents.size(); ++i){
+			documents.push_back(read(i));
+		}
+	}
+	
+	bool finish(){
+		std::ostringstream os;
+		for(std::size_t i = 0; i < documents.size(); ++i){
+			documents[i].writeToStream(os);
+			documents[i].deleteTags();
+		}
+		documents.clear();
+		return os.str() == corpus.expected;
+	}
+	
+	std::size_t bytes() const{	return corpus.data.length();	}
+	
+protected:
+	const Corpus& corpus;
+	std::vector<XML::Document> documents;
+	
+	virtual XML::Document read(std::size_t i) = 0;
+};
+
+class BufferParse : public ParseBenchmark{
+public:
+	BufferParse(const char* Name, const Corpus& Corpus, bool UseArena):ParseBenchmark(Name, Corpus), useArena(UseArena){}
+	
+protected:
+	bool useArena;
+	
+	XML::Document read(std::size_t i){
+		return XML::Document::FromBuffer(corpus.documents[i].data, corpus.documents[i].length, "_root", useArena);
+	}
+};
+
+//FromBuffer with the statistics enabled, which are checked against the corpus.
+class StatsParse : public BufferParse{
+public:
+	StatsParse(const Corpus& Corpus):BufferParse("parse.stats", Corpus, false){}
+	
+	void prepare(){
+		BufferParse::prepare();
+		XML::ResetParseStats();
+		XML::EnableParseStats();
+	}
+	
+	bool finish(){
+		XML::EnableParseStats(false);
+		const XML::ParseStats stats = XML::TotalParseStats();
+		return stats.documents == corpus.documents.size() && stats.bytes == corpus.data.length() && stats.elements == corpus.tags && BufferParse::finish();
+	}
+};
+
+class StreamParse : public ParseBenchmark{
+public:
+	StreamParse(const Corpus& Corpus):ParseBenchmark("parse.stream", Corpus){}
+	
+	void prepare(){
+		ParseBenchmark::prepare();
+		for(std::size_t i = 0; i < corpus.documents.size(); ++i){
+			streams.push_back(new std::istringstream(std::string(corpus.documents[i].data, corpus.documents[i].length)));
+		}
+	}
+	
+	bool finish(){
+		for(std::size_t i = 0; i < streams.size(); ++i){
+			delete streams[i];
+		}
+		streams.clear();
+		return ParseBenchmark::finish();
+	}
+	
+protected:
+	std::vector<std::istringstream*> streams;
+	
+	XML::Document read(std::size_t i){
+		return XML::Document::FromStream(*streams[i]);
+	}
+};
+
+class ParallelParse : public ParseBenchmark{
+public:
+	ParallelParse(const Corpus& Corpus, unsigned int ThreadCount):ParseBenchmark("parse.parallel", Corpus), threadCount(ThreadCount){}
+	
+	unsigned int threads() const{	return threadCount;	}
+	
+protected:
+	unsigned int threadCount;
+	
+	XML::Document read(std::size_t i){
+		return XML::Document::FromBufferParallel(corpus.documents[i].data, corpus.documents[i].length, threadCount);
+	}
+};
+
+//Fed in fragments of the size of a network packet, or in small ones which cut off most of the markup.
+class PushParse : public ParseBenchmark{
+public:
+	PushParse(const char* Name, const Corpus& Corpus, std::size_t FragmentSize):ParseBenchmark(Name, Corpus), fragmentSize(FragmentSize){}
+	
+protected:
+	std::size_t fragmentSize;
+	XML::PushParser parser;
+	
+	XML::Document read(std::size_t i){
+		const XML::Buffer& buffer = corpus.documents[i];
+		parser.reset();
+		for(std::size_t offset = 0; offset < buffer.length; offset += fragmentSize){
+			parser.feed(buffer.data + offset, (buffer.length - offset < fragmentSize) ? buffer.length - offset : fragmentSize);
+		}
+		return parser.finish();
+	}
+};
+
+class CompactParse : public Benchmark{
+public:
+	CompactParse(const Corpus& Corpus):Benchmark("parse.compact"), corpus(Corpus){}
+	
+	void run(){
+		for(std::size_t i = 0; i < corpus.documents.size(); ++i){
+			documents.push_back(XML::CompactDocument::FromBuffer(corpus.documents[i].data, corpus.documents[i].length));
+		}
+	}
+	
+	bool finish(){
+		std::ostringstream os;
+		for(std::size_t i = 0; i < documents.size(); ++i){
+			XML::Document document = documents[i]->toDocument();
+			document.writeToStream(os);
+			document.deleteTags();
+			delete documents[i];
+		}
+		documents.clear();
+		return os.str() == corpus.expected;
+	}
+	
+	std::size_t bytes() const{	return corpus.data.length();	}
+	
+private:
+	const Corpus& corpus;
+	std::vector<XML::CompactDocument*> documents;
+};
+
+//Loads a snapshot of every document, written once by CompactDocument::writeSnapshot, checked by expanding it back into tags.
+//The rate is of the XML the snapshots replace, so it compares with the parsers.
+class SnapshotLoad : public Benchmark{
+public:
+	SnapshotLoad(const char* Name, const Corpus& Corpus, bool Verify):Benchmark(Name), corpus(Corpus), verify(Verify){
+		for(std::size_t i = 0; i < corpus.documents.size(); ++i){
+			XML::CompactDocument* document = XML::CompactDocument::FromBuffer(corpus.documents[i].data, corpus.documents[i].length);
+			std::ostringstream os;
+			document->writeSnapshot(os);
+			snapshots.push_back(os.str());
+			delete document;
+		}
+	}
+	
+	void run(){
+		for(std::size_t i = 0; i < snapshots.size(); ++i){
+			documents.push_back(XML::CompactDocument::FromSnapshot(snapshots[i].data(), snapshots[i].length(), verify));
+		}
+	}
+	
+	bool finish(){
+		std::ostringstream os;
+		bool loaded = true;
+		for(std::size_t i = 0; i < documents.size(); ++i){
+			if(documents[i] == NULL){
+				loaded = false;
+				continue;
+			}
+			XML::Document document = documents[i]->toDocument();
+			document.writeToStream(os);
+			document.deleteTags();
+			delete documents[i];
+		}
+		documents.clear();
+		return loaded && os.str() == corpus.expected;
+	}
+	
+	std::size_t bytes() const{	return corpus.data.length();	}
+	
+private:
+	const Corpus& corpus;
+	bool verify;
+	std::vector<std::string> snapshots;
+	std::vector<XML::CompactDocument*> documents;
+};
+
+//Pulls the events of every document without building anything, checked by counting the elements.
+class ReaderParse : public Benchmark{
+public:
+	ReaderParse(const Corpus& Corpus):Benchmark("parse.reader"), corpus(Corpus), elements(0){}
+	
+	void run(){
+		for(std::size_t i = 0; i < corpus.documents.size(); ++i){
+			XML::Reader reader(corpus.documents[i].data, corpus.documents[i].length);
+			XML::Reader::EVENT event;
+			while((event = reader.next()) != XML::Reader::EVENT_END){
+				if(event == XML::Reader::EVENT_START_ELEMENT){
+					++elements;
+				}
+			}
+		}
+	}
+	
+	bool finish(){
+		const bool ok = (elements == corpus.tags);
+		elements = 0;
+		return ok;
+	}
+	
+	std::size_t bytes() const{	return corpus.data.length();	}
+	
+private:
+	const Corpus& corpus;
+	std::size_t elements;
+};
+
+//Every document of the corpus in one batch, the parser is kept from one run to the next.
+class BatchParse : public Benchmark{
+public:
+	BatchParse(const Corpus& Corpus):Benchmark("parse.batch"), corpus(Corpus){}
+	
+	void run(){
+		parser.parse(corpus.documents);
+	}
+	
+	bool finish(){
+		std::ostringstream os;
+		for(std::size_t i = 0; i < parser.size(); ++i){
+			parser.document(i).writeToStream(os);
+		}
+		return os.str() == corpus.expected;
+	}
+	
+	std::size_t bytes() const{	return corpus.data.length();	}
+	unsigned int threads() const{	return parser.threadCount();	}
+	
+private:
+	const Corpus& corpus;
+	XML::BatchParser parser;
+};
+
+//-------------------------------Writers---------------------------------------//
+
+class WriteBenchmark : public Benchmark{
+public:
+	//To a std::ostringstream, or to an OutputBuffer in memory, which is kept from one run to the next.
+	WriteBenchmark(const char* Name, const Corpus& Corpus, bool ToBuffer):Benchmark(Name), corpus(Corpus), toBuffer(ToBuffer), document(XML::Document::FromBuffer(Corpus.data.data(), Corpus.data.length())){}
+	
+	~WriteBenchmark(){
+		document.deleteTags();
+	}
+	
+	void prepare(){
+		stream.str("");
+		buffer.clear();
+	}
+	
+	void run(){
+		if(toBuffer){
+			document.writeToBuffer(buffer);
+		}else{
+			document.writeToStream(stream);
+		}
+	}
+	
+	bool finish(){
+		return (toBuffer ? buffer.str() : stream.str()) == corpus.expected;
+	}
+	
+	std::size_t bytes() const{	return corpus.expected.length();	}
+	
+private:
+	const Corpus& corpus;
+	bool toBuffer;
+	XML::Document document;
+	std::ostringstream stream;
+	XML::OutputBuffer buffer;
+};
+
+//Document::writeToBufferParallel on a number of threads, to an OutputBuffer in memory which is kept from one run to the next.
+class ParallelWrite : public Benchmark{
+public:
+	ParallelWrite(const Corpus& Corpus, unsigned int ThreadCount):Benchmark("write.parallel"), corpus(Corpus), threadCount(ThreadCount), document(XML::Document::FromBuffer(Corpus.data.data(), Corpus.data.length())){}
+	
+	~ParallelWrite(){
+		document.deleteTags();
+	}
+	
+	void prepare(){
+		buffer.clear();
+	}
+	
+	void run(){
+		document.writeToBufferParallel(buffer, threadCount);
+	}
+	
+	bool finish(){
+		return buffer.str() == corpus.expected;
+	}
+	
+	std::size_t bytes() const{	return corpus.expected.length();	}
+	unsigned int threads() const{	return threadCount;	}
+	
+private:
+	const Corpus& corpus;
+	unsigned int threadCount;
+	XML::Document document;
+	XML::OutputBuffer buffer;
+};
+
+//Copies every document of a corpus from a Reader to a Writer, so nothing grows with the size of the document.
+//Checked against the documents written by Document::writeToStream.
+class WriterBenchmark : public Benchmark{
+public:
+	WriterBenchmark(const Corpus& Corpus):Benchmark("write.writer"), corpus(Corpus){}
+	
+	void prepare(){
+		buffer.clear();
+	}
+	
+	void run(){
+		XML::Writer writer(buffer);
+		std::string value;
+		for(std::size_t i = 0; i < corpus.documents.size(); ++i){
+			XML::Reader reader(corpus.documents[i].data, corpus.documents[i].length);
+			XML::Reader::EVENT event;
+			while((event = reader.next()) != XML::Reader::EVENT_END){
+				switch(event){
+					case XML::Reader::EVENT_DECLARATION:
+						value.clear();
+						if(reader.attribute("version") != NULL){
+							reader.attribute("version")->appendDecoded(value);
+						}
+						buffer.write("<?xml version=\"", 15);
+						buffer.writeEscaped(value);
+						buffer.write("\"?>", 3);
+						break;
+					case XML::Reader::EVENT_START_ELEMENT:
+						writer.startElement(reader.name().data, reader.name().length);
+						for(unsigned int a = 0; a < reader.attributeCount(); ++a){
+							const XML::ViewAttribute& attribute = reader.attributeAt(a);
+							value.clear();
+							attribute.value.appendDecoded(value);
+							writer.attribute(attribute.name.data, attribute.name.length, value.data(), value.length());
+						}
+						break;
+					case XML::Reader::EVENT_END_ELEMENT:
+						writer.endElement();
+						break;
+					case XML::Reader::EVENT_TEXT:
+						writer.text(reader.text().data, reader.text().length);
+						break;
+					case XML::Reader::EVENT_END:
+						break;
+				}
+			}
+		}
+		writer.finish();
+	}
+	
+	bool finish(){
+		return buffer.str() == corpus.expected;
+	}
+	
+	std::size_t bytes() const{	return corpus.expected.length();	}
+	
+private:
+	const Corpus& corpus;
+	XML::OutputBuffer buffer;
+};
+
+//EscapeString or DeEscapeString on a whole corpus, checked against the text before it was escaped.
+class EscapeBenchmark : public Benchmark{
+public:
+	//reuse == true writes the result to a buffer which is kept from one run to the next.
+	EscapeBenchmark(const char* Name, const std::string& Input, const std::string& Original, bool Escape, bool Reuse):Benchmark(Name), input(Input), original(Original), escape(Escape), reuse(Reuse), result(NULL){}
+	
+	void run(){
+		if(reuse){
+			result = escape ? &XML::EscapeString(input, buffer) : &XML::DeEscapeString(input, buffer);
+		}else{
+			output = escape ? XML::EscapeString(input) : XML::DeEscapeString(input);
+			result = &output;
+		}
+	}
+	
+	bool finish(){
+		return (escape ? XML::DeEscapeString(*result) : *result) == original;
+	}
+	
+	std::size_t bytes() const{	return input.length();	}
+	
+private:
+	const std::string& input;
+	const std::string& original;
+	bool escape;
+	bool reuse;
+	std::string output;
+	std::string buffer;
+	const std::string* result;
+};
+
+//-------------------------------Lookups---------------------------------------//
+
+//Looks through the children of every record of the first top level tag, many times over.
+class LookupBenchmark : public Benchmark{
+public:
+	enum TYPE{
+		CHILD_WITH_NAME,		//childWithName(name) on every record
+		CHILD_WITH_ATOM,		//childWithName(atom) on every record
+		CHILDREN_WITH_NAME		//every tag of childrenWithName(name) of every record
+	};
+	
+	LookupBenchmark(const char* Name, const Corpus& Corpus, TYPE Type, const std::string& ChildName, std::size_t Expected):Benchmark(Name), type(Type), childName(ChildName), expected(Expected), found(0){
+		document = XML::Document::FromBuffer(Corpus.data.data(), Corpus.data.length());
+		atom = document.atoms->find(childName);
+		const XML::Tag* top = NULL;
+		for(unsigned int i = 0; top == NULL && i < document.root->children.size(); ++i){
+			if(document.root->children[i]->getType() == XML::XML_TAG){
+				top = (const XML::Tag*)document.root->children[i];
+			}
+		}
+		for(unsigned int i = 0; top != NULL && i < top->children.size(); ++i){
+			if(top->children[i]->getType() == XML::XML_TAG){
+				records.push_back((const XML::Tag*)top->children[i]);
+			}
+		}
+	}
+	
+	~LookupBenchmark(){
+		document.deleteTags();
+	}
+	
+	void run(){
+		for(unsigned int repeat = 0; repeat < Repeats; ++repeat){
+			for(std::size_t i = 0; i < records.size(); ++i){
+				switch(type){
+					case CHILD_WITH_NAME:
+						found += (records[i]->childWithName(childName) != NULL);
+						break;
+					case CHILD_WITH_ATOM:
+						found += (records[i]->childWithName(atom) != NULL);
+						break;
+					case CHILDREN_WITH_NAME:{
+						const XML::NamedChildren children = records[i]->childrenWithName(childName);
+						for(XML::NamedChildren::iterator it = children.begin(); it != children.end(); ++it){
+							++found;
+						}
+						break;
+					}
+				}
+			}
+		}
+	}
+	
+	bool finish(){
+		const bool ok = (found == expected * Repeats);
+		found = 0;
+		return ok;
+	}
+	
+	std::size_t operations() const{	return records.size() * Repeats;	}
+	
+private:
+	static const unsigned int Repeats = 20;
+	
+	TYPE type;
+	std::string childName;
+	XML::Atom atom;
+	std::size_t expected;
+	std::size_t found;
+	XML::Document document;
+	std::vector<const XML::Tag*> records;
+};
+
+//Counts the matches of a compiled query on the whole document.
+class QueryBenchmark : public Benchmark{
+public:
+	QueryBenchmark(const char* Name, const Corpus& Corpus, const std::string& path, std::size_t Expected):Benchmark(Name), query(path), matcher(query), expected(Expected), found(0), tags(Corpus.tags){
+		document = XML::Document::FromBuffer(Corpus.data.data(), Corpus.data.length());
+	}
+	
+	~QueryBenchmark(){
+		document.deleteTags();
+	}
+	
+	void run(){
+		found = matcher.count(document.root);
+	}
+	
+	bool finish(){
+		return found == expected;
+	}
+	
+	//the tags of the document, though the query may skip some of them
+	std::size_t operations() const{	return tags;	}
+	
+private:
+	XML::Query query;
+	XML::QueryMatcher matcher;
+	std::size_t expected;
+	std::size_t found;
+	std::size_t tags;
+	XML::Document document;
+};
+
+//-------------------------------Binding---------------------------------------//
+
+//An item of the wide corpus.
+struct Item{
+	int id;
+	std::string f0, f1, f2, f3, f4, f5, f6, f7, f8, f9;
+	std::vector<std::string> tags;
+	
+	Item():id(0){}
+	
+	template<class Binder> static void bind(Binder& binder){
+		binder.attribute("id", &Item::id);
+		binder.element("f0", &Item::f0);
+		binder.element("f1", &Item::f1);
+		binder.element("f2", &Item::f2);
+		binder.element("f3", &Item::f3);
+		binder.element("f4", &Item::f4);
+		binder.element("f5", &Item::f5);
+		binder.element("f6", &Item::f6);
+		binder.element("f7", &Item::f7);
+		binder.element("f8", &Item::f8);
+		binder.element("f9", &Item::f9);
+		binder.element("tag", &Item::tags);
+	}
+};
+
+struct Catalog{
+	std::vector<Item> items;
+	
+	template<class Binder> static void bind(Binder& binder){
+		binder.element("item", &Catalog::items);
+	}
+};
+
+//Fills the items of the wide corpus, with ReadStruct (bind) or by reading a Document and copying the fields out of its tags (dom).
+//Checked by writing the items with WriteStruct, which has to give the same XML both ways.
+class BindRead : public Benchmark{
+public:
+	BindRead(const char* Name, const Corpus& Corpus, bool UseDocument):Benchmark(Name), corpus(Corpus), useDocument(UseDocument){
+		Catalog catalog;
+		XML::ReadStruct(corpus.data.data(), corpus.data.length(), catalog);
+		expected = Write(catalog);
+	}
+	
+	void run(){
+		if(!useDocument){
+			XML::ReadStruct(corpus.data.data(), corpus.data.length(), catalog);
+			return;
+		}
+		static const std::string names[] = {"f0", "f1", "f2", "f3", "f4", "f5", "f6", "f7", "f8", "f9"};
+		XML::Document document = XML::Document::FromBuffer(corpus.data.data(), corpus.data.length());
+		const XML::Tag* top = document.root->childWithName("catalog");
+		const XML::NamedChildren items = top->childrenWithName("item");
+		for(XML::NamedChildren::iterator it = items.begin(); it != items.end(); ++it){
+			const XML::Tag* tag = *it;
+			catalog.items.push_back(Item());
+			Item& item = catalog.items.back();
+			item.id = atoi(tag->attributes.find("id")->second.c_str());
+			std::string* fields[] = {&item.f0, &item.f1, &item.f2, &item.f3, &item.f4, &item.f5, &item.f6, &item.f7, &item.f8, &item.f9};
+			for(unsigned int f = 0; f < 10; ++f){
+				const XML::Tag* field = tag->childWithName(names[f]);
+				if(field != NULL){
+					*fields[f] = field->firstText();
+				}
+			}
+			const XML::NamedChildren tags = tag->childrenWithName("tag");
+			for(XML::NamedChildren::iterator t = tags.begin(); t != tags.end(); ++t){
+				item.tags.push_back((*t)->firstText());
+			}
+		}
+		document.deleteTags();
+	}
+	
+	bool finish(){
+		const bool ok = (Write(catalog) == expected);
+		catalog.items.clear();
+		return ok;
+	}
+	
+	std::size_t bytes() const{	return corpus.data.length();	}
+	std::size_t operations() const{	return corpus.records;	}
+	
+private:
+	const Corpus& corpus;
+	bool useDocument;
+	std::string expected;
+	Catalog catalog;
+	
+	static std::string Write(const Catalog& catalog){
+		XML::OutputBuffer output;
+		XML::WriteStruct(output, "catalog", catalog);
+		return output.str();
+	}
+};
+
+//Writes the items of the wide corpus with WriteStruct, into a buffer which is kept from one run to the next.
+class BindWrite : public Benchmark{
+public:
+	BindWrite(const Corpus& Corpus):Benchmark("bind.write"), corpus(Corpus){
+		XML::ReadStruct(corpus.data.data(), corpus.data.length(), catalog);
+	}
+	
+	void prepare(){
+		output.clear();
+	}
+	
+	void run(){
+		XML::WriteStruct(output, "catalog", catalog);
+	}
+	
+	bool finish(){
+		Catalog again;
+		XML::ReadStruct(output.data(), output.size(), again);
+		return again.items.size() == catalog.items.size() && again.items.size() == corpus.records && again.items.back().tags == catalog.items.back().tags;
+	}
+	
+	std::size_t bytes() const{	return output.size();	}
+	
+private:
+	const Corpus& corpus;
+	Catalog catalog;
+	XML::OutputBuffer output;
+};
+
+//-------------------------------Cache---------------------------------------//
+
+//Asks a DocumentCache for a file holding the corpus, which is read the first time (cold) or already kept (warm).
+class CacheBenchmark : public Benchmark{
+public:
+	CacheBenchmark(const char* Name, const Corpus& Corpus, bool Cold):Benchmark(Name), corpus(Corpus), cold(Cold), path("Benchmark.cache.xml"), cache(0), found(0){
+		FILE* file = fopen(path.c_str(), "wb");
+		if(file != NULL){
+			fwrite(corpus.data.data(), 1, corpus.data.length(), file);
+			fclose(file);
+		}
+		cache.get(path);
+	}
+	
+	~CacheBenchmark(){
+		remove(path.c_str());
+	}
+	
+	void prepare(){
+		if(cold){
+			cache.clear();
+		}
+	}
+	
+	void run(){
+		for(unsigned int i = 0; i < repeats(); ++i){
+			const XML::DocumentHandle handle = cache.get(path);
+			found += (handle.valid() && !handle->root->children.empty());
+		}
+	}
+	
+	bool finish(){
+		const bool ok = (found == repeats());
+		found = 0;
+		return ok;
+	}
+	
+	std::size_t bytes() const{	return cold ? corpus.data.length() : 0;	}
+	std::size_t operations() const{	return cold ? 0 : repeats();	}
+	
+private:
+	static const unsigned int Repeats = 100000;
+	
+	const Corpus& corpus;
+	bool cold;
+	std::string path;
+	XML::DocumentCache cache;
+	std::size_t found;
+	
+	unsigned int repeats() const{	return cold ? 1 : Repeats;	}
+};
+
+//-------------------------------main---------------------------------------//
+
+static void MeasureReaders(const Corpus& corpus){
+	BufferParse buffer("parse.buffer", corpus, false);
+	Measure(buffer, corpus);
+	BufferParse arena("parse.arena", corpus, true);
+	Measure(arena, corpus);
+	StatsParse stats(corpus);
+	Measure(stats, corpus);
+	StreamParse stream(corpus);
+	Measure(stream, corpus);
+	PushParse push("parse.push", corpus, 1460);
+	Measure(push, corpus);
+	CompactParse compact(corpus);
+	Measure(compact, corpus);
+	SnapshotLoad snapshot("snapshot.load", corpus, true);
+	Measure(snapshot, corpus);
+	SnapshotLoad trusted("snapshot.load.trusted", corpus, false);
+	Measure(trusted, corpus);
+	ReaderParse reader(corpus);
+	Measure(reader, corpus);
+}
+
+//With fixed thread counts, so the documents are split and stitched together, and checked, even on a single core.
+//The corpora have to be larger than two pieces of FromBufferParallel, which is the case with the default scale.
+static void MeasureParallelReaders(const Corpus& corpus){
+	for(unsigned int threads = 2; threads <= 8 || threads <= HardwareThreads(); threads *= 2){
+		ParallelParse parallel(corpus, threads);
+		Measure(parallel, corpus);
+	}
+}
+
+static void MeasureWriters(const Corpus& corpus){
+	WriteBenchmark stream("write.stream", corpus, false);
+	Measure(stream, corpus);
+	WriteBenchmark buffer("write.buffer", corpus, true);
+	Measure(buffer, corpus);
+	WriterBenchmark writer(corpus);
+	Measure(writer, corpus);
+	//the scaling, from the sequential writer up to at least 4 threads, or every core
+	for(unsigned int threads = 1; threads <= 4 || threads <= HardwareThreads(); threads *= 2){
+		ParallelWrite parallel(corpus, threads);
+		Measure(parallel, corpus);
+	}
+}
+
+static void MeasureEscapes(const Corpus& corpus){
+	const std::string escaped = XML::EscapeString(corpus.data);
+	EscapeBenchmark escape("escape", corpus.data, corpus.data, true, false);
+	Measure(escape, corpus);
+	EscapeBenchmark escapeBuffer("escape.buffer", corpus.data, corpus.data, true, true);
+	Measure(escapeBuffer, corpus);
+	EscapeBenchmark deescape("deescape", escaped, corpus.data, false, false);
+	Measure(deescape, corpus);
+	EscapeBenchmark deescapeBuffer("deescape.buffer", escaped, corpus.data, false, true);
+	Measure(deescapeBuffer, corpus);
+}
+
+int main(int argc, char** argv){
+	const double scale = (argc > 1) ? atof(argv[1]) : 1;
+	if(argc > 2){
+		prefix = argv[2];
+	}
+	const std::size_t size = (std::size_t)(4e6 * (scale > 0 ? scale : 1));
+	srand(1);
+	
+	Corpus deep("deep"), wide("wide"), attributes("attributes"), text("text"), tiny("tiny"), markup("markup");
+	Deep(deep, size);
+	Wide(wide, size);
+	Attributes(attributes, size);
+	Text(text, size);
+	Tiny(tiny, size);
+	Markup(markup, size);
+	const Corpus* documents[] = {&deep, &wide, &attributes, &text};
+	
+	for(unsigned int i = 0; i < 4; ++i){
+		MeasureReaders(*documents[i]);
+		MeasureParallelReaders(*documents[i]);
+		MeasureWriters(*documents[i]);
+	}
+	MeasureReaders(tiny);
+	BatchParse batch(tiny);
+	Measure(batch, tiny);
+	//the time has to stay in proportion to the size when the large comment is fed a few bytes at a time
+	PushParse small("parse.push.small", markup, 16);
+	Measure(small, markup);
+	MeasureParallelReaders(markup);
+	
+	MeasureEscapes(text);
+	MeasureEscapes(attributes);
+	
+	LookupBenchmark child("lookup.childWithName", wide, LookupBenchmark::CHILD_WITH_NAME, "f7", wide.records);
+	Measure(child, wide);
+	LookupBenchmark atom("lookup.childWithName.atom", wide, LookupBenchmark::CHILD_WITH_ATOM, "f7", wide.records);
+	Measure(atom, wide);
+	LookupBenchmark children("lookup.childrenWithName", wide, LookupBenchmark::CHILDREN_WITH_NAME, "tag", wide.records * 10);
+	Measure(children, wide);
+	QueryBenchmark path("query.path", wide, "/catalog/item/tag", wide.records * 10);
+	Measure(path, wide);
+	QueryBenchmark descendant("query.descendant", deep, "//level[@depth='100']", deep.records);
+	Measure(descendant, deep);
+	
+	BindRead bind("bind.read", wide, false);
+	Measure(bind, wide);
+	BindRead dom("bind.read.dom", wide, true);
+	Measure(dom, wide);
+	BindWrite bindWrite(wide);
+	Measure(bindWrite, wide);
+	
+	CacheBenchmark cold("cache.get.cold", wide, true);
+	Measure(cold, wide);
+	CacheBenchmark warm("cache.get.warm", wide, false);
+	Measure(warm, wide);
+	
+	return failed ? 1 : 0;
+}
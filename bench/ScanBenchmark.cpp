@@ -0,0 +1,116 @@
+//Compares the scalar, SSE2 and AVX2 scanners on text heavy and attribute heavy input.
+//Built by the CMake build of the repository root, or with:
+//	g++ -O2 -I. bench/ScanBenchmark.cpp XML.cpp XMLArena.cpp XMLFile.cpp XMLLexer.cpp XMLScan.cpp XMLView.cpp -o ScanBenchmark
+
+#include "../XML.h"
+#include "../XMLScan.h"
+#include "../XMLView.h"
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+
+static const char* Words[] = {"lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing", "elit", "sed", "do"};
+static const unsigned int NumberOfWords = sizeof(Words) / sizeof(Words[0]);
+
+//Long runs of text with an escape string now and then.
+std::string TextHeavy(unsigned int paragraphs){
+	std::string output = "<document>\n";
+	for(unsigned int i = 0; i < paragraphs; ++i){
+		output += "<p>";
+		for(unsigned int w = 0; w < 200; ++w){
+			output += Words[rand() % NumberOfWords];
+			output += (w % 50 == 49) ? " &amp; " : " ";
+		}
+		output += "</p>\n";
+	}
+	output += "</document>\n";
+	return output;
+}
+
+//Many tags with many long attribute values and no text.
+std::string AttributeHeavy(unsigned int tags){
+	std::string output = "<document>\n";
+	char buffer[64];
+	for(unsigned int i = 0; i < tags; ++i){
+		output += "<record";
+		for(unsigned int a = 0; a < 6; ++a){
+			sprintf(buffer, " attribute%u=\"", a);
+			output += buffer;
+			for(unsigned int w = 0; w < 6; ++w){
+				output += Words[rand() % NumberOfWords];
+				output += ' ';
+			}
+			output += '"';
+		}
+		output += "/>\n";
+	}
+	output += "</document>\n";
+	return output;
+}
+
+double Seconds(clock_t start){
+	return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+//Best of a few runs, in MB/s.
+template<class Function>
+double Throughput(const std::string& input, Function function){
+	double best = 1e30;
+	for(int run = 0; run < 5; ++run){
+		clock_t start = clock();
+		function(input);
+		double seconds = Seconds(start);
+		if(seconds < best)	best = seconds;
+	}
+	return input.length() / 1e6 / (best > 0 ? best : 1e-9);
+}
+
+void ParseDocument(const std::string& input){
+	XML::Document document = XML::Document::FromBuffer(input.data(), input.length());
+	document.deleteTags();
+}
+
+void ParseReadOnly(const std::string& input){
+	delete XML::ReadOnlyDocument::FromBuffer(input.data(), input.length());
+}
+
+void Escape(const std::string& input){
+	XML::EscapeString(input);
+}
+
+static std::size_t sink = 0;
+
+void CountMarkup(const std::string& input){
+	const char* p = input.data();
+	const char* end = p + input.length();
+	while((p = XML::ScanForText(p, end)) != end){
+		++sink;
+		++p;
+	}
+}
+
+//The search the escape functions used before the scanner.
+void CountMarkupFind(const std::string& input){
+	std::size_t p = input.find_first_of("<&");
+	while(p != std::string::npos){
+		++sink;
+		p = input.find_first_of("<&", p + 1);
+	}
+}
+
+int main(){
+	srand(1);
+	const std::string text = TextHeavy(20000);
+	const std::string attributes = AttributeHeavy(100000);
+	const char* levels[] = {"scalar", "sse2", "avx2"};
+	
+	printf("%-8s %-12s %12s %12s %12s %12s\n", "level", "input", "scan MB/s", "escape MB/s", "tag MB/s", "view MB/s");
+	printf("%-8s %-12s %12.1f\n", "find", "text", Throughput(text, CountMarkupFind));
+	for(int level = XML::SCAN_SCALAR; level <= XML::SupportedScanLevel(); ++level){
+		XML::SetScanLevel((XML::SCAN_LEVEL)level);
+		printf("%-8s %-12s %12.1f %12.1f %12.1f %12.1f\n", levels[level], "text", Throughput(text, CountMarkup), Throughput(text, Escape), Throughput(text, ParseDocument), Throughput(text, ParseReadOnly));
+		printf("%-8s %-12s %12.1f %12.1f %12.1f %12.1f\n", levels[level], "attributes", Throughput(attributes, CountMarkup), Throughput(attributes, Escape), Throughput(attributes, ParseDocument), Throughput(attributes, ParseReadOnly));
+	}
+	return (sink == 0);
+}
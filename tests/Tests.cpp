@@ -0,0 +1,1032 @@
+//Checks of behaviour which the benchmarks do not cover, run by ctest. Each check prints what failed, and the exit status is 1 if any did.
+//The allocations are counted, so leaks are found without a sanitizer, though the checks can also be built with one:
+//	cmake -S . -B build -DCMAKE_CXX_FLAGS=-fsanitize=address && cmake --build build && ctest --test-dir build
+//Built by the CMake build of the repository root, or with:
+//	g++ -std=c++11 -pthread -I. tests/Tests.cpp XML*.cpp -o Tests
+
+#include "../XML.h"
+#include "../XMLReader.h"
+#include "../XMLCompact.h"
+#include "../XMLView.h"
+#include "../XMLQuery.h"
+#include "../XMLBind.h"
+#include "../XMLWriter.h"
+#include "../XMLStats.h"
+#include "../XMLBatch.h"
+#include "../XMLCache.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+
+#ifdef XML_CPP11
+#include <atomic>
+#include <thread>
+#include <utility>
+#endif
+
+//-------------------------------Allocations---------------------------------------//
+
+#ifdef XML_CPP11
+static std::atomic<long> liveAllocations(0);
+#define TESTS_THROWS_BAD_ALLOC
+#define TESTS_THROWS_NOTHING noexcept
+#else
+static long liveAllocations = 0;
+#define TESTS_THROWS_BAD_ALLOC throw(std::bad_alloc)
+#define TESTS_THROWS_NOTHING throw()
+#endif
+
+void* operator new(std::size_t size) TESTS_THROWS_BAD_ALLOC{
+	void* p = malloc(size == 0 ? 1 : size);
+	if(p == NULL){
+		throw std::bad_alloc();
+	}
+	++liveAllocations;
+	return p;
+}
+
+void* operator new[](std::size_t size) TESTS_THROWS_BAD_ALLOC{
+	return operator new(size);
+}
+
+void operator delete(void* p) TESTS_THROWS_NOTHING{
+	if(p != NULL){
+		--liveAllocations;
+		free(p);
+	}
+}
+
+void operator delete[](void* p) TESTS_THROWS_NOTHING{
+	operator delete(p);
+}
+
+//-------------------------------Checks---------------------------------------//
+
+static unsigned int failures = 0;
+
+#define CHECK(condition)	\
+	if(!(condition)){	\
+		printf("%s:%d: %s failed\n", __FILE__, __LINE__, #condition);	\
+		++failures;	\
+	}
+	
+static std::string Write(const XML::Document& document){
+	std::ostringstream os;
+	document.writeToStream(os);
+	return os.str();
+}
+
+//-------------------------------Escapes---------------------------------------//
+
+//Escape strings and numeric character references are decoded to UTF-8, anything which is not a whole valid reference is kept.
+static void CharacterReferences(){
+	CHECK(XML::DeEscapeString("a &lt; b &amp;&amp; c &gt; d") == "a < b && c > d");
+	CHECK(XML::DeEscapeString("&quot;&apos;") == "\"'");
+	CHECK(XML::DeEscapeString("&#65;&#x42;&#X43;") == "ABC");
+	CHECK(XML::DeEscapeString("&#xE9;&#x20AC;&#x1F600;") == "\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80");
+	
+	//truncated, malformed or out of range
+	CHECK(XML::DeEscapeString("&am") == "&am");
+	CHECK(XML::DeEscapeString("x&am") == "x&am");
+	CHECK(XML::DeEscapeString("&amp") == "&amp");
+	CHECK(XML::DeEscapeString("&#xZZ;") == "&#xZZ;");
+	CHECK(XML::DeEscapeString("&#65") == "&#65");
+	CHECK(XML::DeEscapeString("&#;&#x;&#0;") == "&#;&#x;&#0;");
+	CHECK(XML::DeEscapeString("&#xD800;&#x110000;") == "&#xD800;&#x110000;");
+	CHECK(XML::DeEscapeString("&unknown; & &") == "&unknown; & &");
+	
+	//decoded in place the same way
+	std::string inPlace = "&#xZZ;&lt;&am&#x41;";
+	XML::DeEscapeInPlace(inPlace);
+	CHECK(inPlace == "&#xZZ;<&amA");
+	
+	//nothing past the end is read, so a reference cut by it is kept
+	const std::string amp = "&amp;";
+	std::string cut;
+	XML::AppendDeEscaped(cut, amp.data(), amp.data() + 3);
+	CHECK(cut == "&am");
+	
+	//text read by the parser, which writes back what it decoded escaped again
+	const std::string input = "<r>&#66;&lt;&#xZZ;&am</r>";
+	XML::Document document = XML::Document::FromBuffer(input.data(), input.length());
+	CHECK(document.root->childWithName("r")->children[0]->name == "B<&#xZZ;&am");
+	CHECK(Write(document) == "<?xml version=\"1.0\"?><r>B&lt;&amp;#xZZ;&amp;am</r>");
+	document.deleteTags();
+}
+
+//-------------------------------Document---------------------------------------//
+
+#ifdef XML_CPP11
+//A document built by hand owns its tags, which are deleted when another document is read into it.
+static void DocumentOwnsTagsBuiltByHand(){
+	const long before = liveAllocations;
+	{
+		XML::Document document;
+		document.createRoot("old")->addChildTag("c");
+		std::istringstream is("<new><d/></new>");
+		is >> document;
+		CHECK(Write(document) == "<?xml version=\"1.0\"?><new><d /></new>");
+		
+		XML::Document other;
+		other.createRoot("other")->addChildTag("e");
+		other = std::move(document);
+		CHECK(Write(other) == "<?xml version=\"1.0\"?><new><d /></new>");
+	}
+	CHECK(liveAllocations == before);
+}
+
+static void StringMovedToItself(){
+	XML::String text("some text");
+	XML::String& same = text;
+	text = std::move(same);
+	CHECK(text.name == "some text");
+}
+#endif
+
+//A file which cannot be opened gives an empty document, which writes nothing, as does a document never read.
+static void MissingFileReadsEmpty(){
+	XML::Document missing = XML::Document::FromFile("tests/no such file.xml");
+	CHECK(missing.root != NULL && missing.root->children.empty());
+	CHECK(Write(missing) == "");
+	missing.deleteTags();
+	
+	XML::Document named = XML::Document::FromFile("tests/no such file.xml", "top", true);
+	CHECK(named.root != NULL && named.root->name == "top");
+	named.deleteTags();
+	
+	XML::Document never;
+	CHECK(Write(never) == "");
+}
+
+//-------------------------------Attributes---------------------------------------//
+
+//The keys of a tag, in order.
+static std::string Keys(const XML::Attributes& attributes){
+	std::string keys;
+	for(XML::Attributes::const_iterator it = attributes.begin(); it != attributes.end(); ++it){
+		keys += it->first.str() + ";";
+	}
+	return keys;
+}
+
+//Attributes keep the order they were added in through replacement and erase, also past the inline one.
+static void AttributesKeepOrder(){
+	XML::Tag tag("t");
+	tag.attributes["c"] = "3";
+	tag.attributes["a"] = "1";
+	tag.attributes["b"] = "2";
+	CHECK(Keys(tag.attributes) == "c;a;b;");
+	
+	//replacing a value keeps its place, insert does not replace
+	tag.attributes["a"] = "one";
+	CHECK(!tag.attributes.insert(std::make_pair(std::string("c"), std::string("three"))).second);
+	CHECK(tag.attributes.insert(std::make_pair(std::string("d"), std::string("4"))).second);
+	CHECK(Keys(tag.attributes) == "c;a;b;d;");
+	CHECK(*tag.attributes.get("a") == "one" && *tag.attributes.get("c") == "3");
+	std::ostringstream os;
+	tag.writeToStream(os);
+	CHECK(os.str() == "<t c=\"3\" a=\"one\" b=\"2\" d=\"4\" />");
+	
+	//erase keeps the order of the others
+	CHECK(tag.attributes.erase("a") == 1);
+	CHECK(tag.attributes.erase("a") == 0);
+	CHECK(Keys(tag.attributes) == "c;b;d;");
+	tag.attributes.erase(tag.attributes.begin());
+	CHECK(Keys(tag.attributes) == "b;d;");
+	CHECK(tag.attributes.get("c") == NULL && tag.attributes.count("b") == 1);
+	tag.attributes.erase(tag.attributes.begin() + 1);
+	CHECK(Keys(tag.attributes) == "b;" && tag.attributes.size() == 1);
+	
+	//copies compare equal, and a map keeps every attribute
+	XML::Attributes copied = tag.attributes;
+	copied["e"] = "5";
+	CHECK(copied != tag.attributes);
+	copied.erase("e");
+	CHECK(copied == tag.attributes);
+	std::map<std::string, std::string> map;
+	map["y"] = "2";
+	map["x"] = "1";
+	XML::Attributes fromMap(map);
+	CHECK(Keys(fromMap) == "x;y;");
+#ifdef XML_CPP11
+	//moving takes the inline attribute as well as an array
+	XML::Attributes moved(std::move(copied));
+	CHECK(Keys(moved) == "b;" && copied.empty());
+	moved = std::move(fromMap);
+	CHECK(Keys(moved) == "x;y;" && fromMap.empty());
+#endif
+	tag.attributes.clear();
+	CHECK(tag.attributes.empty() && Keys(tag.attributes) == "");
+}
+
+//Tags read with atoms share the keys of their attributes, which outlive the document in a copy of a tag.
+static void AttributeKeysShared(){
+	const std::string input = "<r><a id=\"1\" kind=\"x\"/><b id=\"2\"/></r>";
+	XML::Document document = XML::Document::FromBuffer(input.data(), input.length());
+	const XML::Tag* r = document.root->childWithName("r");
+	const XML::Tag* a = r->childWithName("a");
+	const XML::Tag* b = r->childWithName("b");
+	CHECK(a->attributes.begin()->first == "id");
+	CHECK(a->attributes.begin()->first.data() == b->attributes.begin()->first.data());
+	CHECK(*b->attributes.get("id") == "2");
+	
+	XML::Tag copied(*a);
+	document.deleteTags();
+	CHECK(copied.attributes.begin()->first == std::string("id"));
+	CHECK((copied.attributes.begin() + 1)->first == "kind");
+	std::map<std::string, std::string> map = copied.attributes;
+	CHECK(map.size() == 2 && map["kind"] == "x");
+}
+
+//-------------------------------Child index---------------------------------------//
+
+//A tag wide enough for an index, with children named c0 to c9 four times over, and a string between every two.
+static void AddWideChildren(XML::Tag& tag){
+	for(unsigned int i = 0; i < 40; ++i){
+		tag.addChildTag("c" + std::string(1, (char)('0' + i % 10)));
+		tag.addChildString(" ");
+	}
+}
+
+//Children replaced, swapped, renamed or removed through the children vector are noticed by the lookups which reach them,
+//which never read the deleted children. Under a sanitizer a use after free fails the check.
+static void ChildIndexNoticesReplacedChildren(){
+	XML::Tag tag("wide");
+	AddWideChildren(tag);
+	CHECK(tag.childWithName("c5") == tag.children[10]);
+	
+	//the first c5 deleted and replaced in place by a tag with another name
+	delete tag.children[10];
+	tag.children[10] = new XML::Tag("x", &tag);
+	CHECK(tag.childWithName("c5") == tag.children[30]);
+	CHECK(tag.childWithName("x") == tag.children[10]);
+	CHECK(tag.lastChildWithName("x") == tag.children[10]);
+	
+	//the last c3 swapped with a string
+	std::swap(tag.children[66], tag.children[67]);
+	CHECK(tag.lastChildWithName("c3") == tag.children[67]);
+	CHECK(tag.childrenWithName("c3").size() == 4);
+	
+	//a child renamed directly, and another removed from the vector
+	tag.children[0]->name = "renamed";
+	CHECK(tag.childWithName("c0") == tag.children[20]);
+	CHECK(tag.childWithName("renamed") == tag.children[0]);
+	delete tag.children[2];
+	tag.children.erase(tag.children.begin() + 2);
+	CHECK(tag.childWithName("c1") == tag.children[21]);
+	CHECK(tag.childrenWithName("c1").size() == 3);
+}
+
+//Children added, released or cleared through the tag keep the lookups right, before and after the index exists.
+static void ChildIndexFollowsTagChanges(){
+	XML::Tag tag("wide");
+	AddWideChildren(tag);
+	CHECK(tag.childrenWithName("c2").size() == 4);
+	
+	//added after the index was built, at the end and by firstText at the front
+	XML::Tag* added = tag.addChildTag("c2");
+	CHECK(tag.lastChildWithName("c2") == added);
+	CHECK(tag.childrenWithName("c2").size() == 5);
+	XML::Tag* fresh = tag.addChildTag("new");
+	CHECK(tag.childWithName("new") == fresh);
+	tag.firstText() = "first";
+	CHECK(tag.childWithName("c0") == tag.children[1]);
+	
+	//released children are no longer found, and the others move down
+	XML::Object* released = tag.releaseChild(1);
+	CHECK(released != NULL && released->parent == NULL);
+	delete released;
+	CHECK(tag.childWithName("c0") == tag.children[20]);
+	CHECK(tag.childrenWithName("c0").size() == 3);
+	released = tag.releaseChild(tag.children.size() - 1);
+	CHECK(released == fresh);
+	delete released;
+	CHECK(tag.childWithName("new") == NULL);
+	CHECK(tag.releaseChild(tag.children.size()) == NULL);
+	
+	//cleared and filled again
+	tag.clearChildren();
+	CHECK(tag.childWithName("c2") == NULL && tag.lastChildWithName("c2") == NULL);
+	AddWideChildren(tag);
+	CHECK(tag.childWithName("c2") == tag.children[4]);
+	CHECK(tag.lastChildWithName("c2") == tag.children[64]);
+	
+	//and the same after invalidateIndex and buildIndex
+	tag.invalidateIndex();
+	CHECK(tag.childWithName("c7") == tag.children[14]);
+	tag.buildIndex();
+	CHECK(tag.childrenWithName("c7").size() == 4);
+}
+
+//A document read with atoms keys the index by them, lookups by atom and by name agree through renames, and a child without an atom.
+static void ChildIndexKeyedByAtoms(){
+	std::string input = "<wide>";
+	for(unsigned int i = 0; i < 40; ++i){
+		input += "<c" + std::string(1, (char)('0' + i % 10)) + "/>.";
+	}
+	input += "</wide>";
+	//an empty string comes first, so tag i is child 2 * i + 1
+	XML::Document document = XML::Document::FromBuffer(input.data(), input.length());
+	XML::Tag& tag = *document.root->childWithName("wide");
+	CHECK(tag.children.size() == 81);
+	const XML::Atom c5 = document.atoms->find("c5");
+	CHECK(tag.childWithName(c5) == tag.children[11]);
+	CHECK(tag.lastChildWithName(c5) == tag.children[71]);
+	CHECK(tag.childWithName("c5") == tag.children[11]);
+	CHECK(tag.childWithName("missing") == NULL);
+	CHECK(tag.childrenWithName(c5).size() == 4);
+	
+	//renamed with setName, and replaced in place by a tag with the same name and another atom
+	((XML::Tag*)tag.children[11])->setName("x");
+	CHECK(tag.childWithName(c5) == tag.children[31]);
+	CHECK(tag.childWithName("x") == tag.children[11]);
+	CHECK(tag.childWithName(document.atoms->find("x")) == tag.children[11]);
+	((XML::Tag*)tag.children[71])->setName("c6");
+	CHECK(tag.lastChildWithName(c5) == tag.children[51]);
+	CHECK(tag.childrenWithName("c6").size() == 5);
+	
+	//a child without an atom, the index is then keyed by names
+	tag.addChild(new XML::Tag("c5"));
+	CHECK(tag.lastChildWithName("c5") == tag.children.back());
+	CHECK(tag.lastChildWithName(c5) == tag.children[51]);
+	CHECK(tag.childWithName(c5) == tag.children[31]);
+	document.deleteTags();
+}
+
+#ifdef XML_CPP11
+//Const lookups from several threads on tags which were never searched, so every thread races to build the same indexes.
+static void ChildIndexSharedBetweenThreads(){
+	XML::Tag top("top");
+	for(unsigned int i = 0; i < 200; ++i){
+		AddWideChildren(*top.addChildTag("wide"));
+	}
+	const XML::Tag& shared = top;
+	std::atomic<unsigned int> found(0);
+	std::vector<std::thread> threads;
+	for(unsigned int t = 0; t < 4; ++t){
+		threads.push_back(std::thread([&shared, &found](){
+			for(XML::NamedChildren::iterator it = shared.childrenWithName("wide").begin(); it != shared.childrenWithName("wide").end(); ++it){
+				const XML::Tag* wide = *it;
+				if(wide->childWithName("c9") == wide->children[18] && wide->childrenWithName("c4").size() == 4){
+					++found;
+				}
+			}
+		}));
+	}
+	for(unsigned int t = 0; t < threads.size(); ++t){
+		threads[t].join();
+	}
+	CHECK(found == 4 * 200);
+}
+#endif
+
+//-------------------------------Query---------------------------------------//
+
+static const char* QueryInput = "<catalog><item k=\"a\" id=\"1\"><name>x</name></item><item id=\"2\"/><item k=\"a\" id=\"3\"><item k=\"a\" id=\"4\"/></item>"
+	"<other k=\"b\" id=\"5\"/><group><item k=\"a\" id=\"6\"/><item id=\"7\"/><item k=\"a\" id=\"8\"/></group></catalog>";
+	
+//The ids of the tags the path finds under context, in order, or "invalid".
+static std::string QueryIds(const std::string& path, const XML::Tag* context){
+	XML::Query query(path);
+	if(!query.valid()){
+		return "invalid";
+	}
+	std::vector<const XML::Tag*> found;
+	query.all(context, found);
+	std::string ids;
+	for(unsigned int i = 0; i < found.size(); ++i){
+		const std::string* id = found[i]->attributes.get("id");
+		ids += (ids.empty() ? "" : ",") + (id == NULL ? std::string("?") : *id);
+	}
+	return ids;
+}
+
+//Predicates test attributes, and positions count the children of each parent which passed the predicates before them.
+static void QueryPredicatesAndPositions(){
+	const std::string input = QueryInput;
+	XML::Document document = XML::Document::FromBuffer(input.data(), input.length());
+	const XML::Tag* root = document.root;
+	CHECK(QueryIds("/catalog/item", root) == "1,2,3");
+	CHECK(QueryIds("catalog/item[@k]", root) == "1,3");
+	CHECK(QueryIds("catalog/item[@k='a']", root) == "1,3");
+	CHECK(QueryIds("catalog/item[@k=\"a\"]", root) == "1,3");
+	CHECK(QueryIds("catalog/*[@k='b']", root) == "5");
+	CHECK(QueryIds("//*[@id='7']", root) == "7");
+	CHECK(QueryIds("//item", root) == "1,2,3,4,6,7,8");
+	CHECK(QueryIds("catalog//item[@k='a']", root) == "1,3,4,6,8");
+	
+	//positions
+	CHECK(QueryIds("catalog/item[2]", root) == "2");
+	CHECK(QueryIds("catalog/*[4]", root) == "5");
+	CHECK(QueryIds("catalog/item[4]", root) == "");
+	CHECK(QueryIds("*/group/item[2]", root) == "7");
+	//counted for every parent
+	CHECK(QueryIds("//item[1]", root) == "1,4,6");
+	CHECK(QueryIds("//item[@k='a'][2]", root) == "3,8");
+	//only the predicates before a position filter what it counts
+	CHECK(QueryIds("catalog/item[@k][2]", root) == "3");
+	CHECK(QueryIds("catalog/item[1][@k='a']", root) == "1");
+	CHECK(QueryIds("catalog/item[2][@k='a']", root) == "");
+	
+	CHECK(QueryIds("item[", root) == "invalid");
+	CHECK(QueryIds("a[@k='v", root) == "invalid");
+	CHECK(QueryIds("", root) == "invalid");
+	
+	//first and count, and a matcher used twice
+	const XML::Query second("//item[@k='a'][2]");
+	CHECK(second.first(root) != NULL && *second.first(root)->attributes.get("id") == "3");
+	CHECK(second.count(root) == 2);
+	CHECK(XML::Query("catalog/item[4]").first(root) == NULL);
+	XML::QueryMatcher matcher(second);
+	CHECK(matcher.count(root) == 2);
+	CHECK(matcher.count(root->childWithName("catalog")->childWithName("group")) == 1);
+	CHECK(matcher.count(root) == 2);
+	document.deleteTags();
+}
+
+//-------------------------------Reader---------------------------------------//
+
+static const char* FeedInput = "<?xml version=\"1.0\"?><feed><record id=\"1\" type=\"a\">one &amp; two</record><!-- c -->"
+	"<record id=\"2\"/><record id=\"3\" type=\"b\"><![CDATA[x<y]]></record></feed>";
+static const char* FeedEvents = "D version=1.0@0|S:feed@1|S:record id=1 type=a@2|T:one & two|E:record@1|S:record id=2/@2|E:record/@1|"
+	"S:record id=3 type=b@2|T:x<y|E:record@1|E:feed@0|";
+	
+//The events of the reader as text, with the pieces of a text joined, and the depth after every event.
+static std::string Events(XML::Reader& reader){
+	std::string log;
+	bool text = false;
+	for(XML::Reader::EVENT event = reader.next(); event != XML::Reader::EVENT_END; event = reader.next()){
+		if(event == XML::Reader::EVENT_TEXT){
+			log += (text ? "" : "T:") + reader.text().str();
+			text = true;
+			continue;
+		}
+		log += text ? "|" : "";
+		text = false;
+		if(event == XML::Reader::EVENT_DECLARATION){
+			log += "D";
+		}else{
+			log += ((event == XML::Reader::EVENT_START_ELEMENT) ? "S:" : "E:") + reader.name().str();
+		}
+		for(unsigned int i = 0; i < reader.attributeCount(); ++i){
+			log += " " + reader.attributeAt(i).name.str() + "=" + reader.attributeAt(i).value.str();
+		}
+		char depth[16];
+		sprintf(depth, "@%u|", reader.depth());
+		log += (reader.isSelfClosing() ? "/" : "") + std::string(depth);
+	}
+	return log;
+}
+
+//Records the events of Reader::parse.
+class LogHandler : public XML::Handler{
+public:
+	std::string log;
+	
+	void startElement(const XML::StringRef& name){	log += "S:" + name.str() + "|";	}
+	void attribute(const XML::StringRef& name, const XML::StringRef& value){	log += name.str() + "=" + value.str() + "|";	}
+	void text(const XML::StringRef& text){	log += text.str();	}
+	void endElement(const XML::StringRef& name){	log += "|E:" + name.str() + "|";	}
+};
+
+//The same events come from a buffer and from a stream read in chunks of any size, even when a tag or a reference is cut by a chunk.
+static void ReaderEventsAcrossChunks(){
+	const std::string input = FeedInput;
+	XML::Reader buffered(input.data(), input.length());
+	CHECK(Events(buffered) == FeedEvents);
+	CHECK(buffered.bytesRead() == input.length());
+	for(std::size_t size = 1; size <= 40; ++size){
+		std::istringstream is(input);
+		XML::Reader chunked(is, size);
+		CHECK(Events(chunked) == FeedEvents);
+		CHECK(chunked.bytesRead() == input.length());
+	}
+	
+	//long text and a tag larger than the buffer, which grows for it
+	std::string text, attributes;
+	for(unsigned int i = 0; i < 100; ++i){
+		text += "some text &amp; ";
+		attributes += " a" + std::string(1, (char)('a' + i % 26)) + std::string(1, (char)('a' + i / 26)) + "=\"v\"";
+	}
+	const std::string large = "<r" + attributes + ">" + text + "</r>";
+	std::istringstream is(large);
+	XML::Reader chunked(is, 64);
+	CHECK(chunked.next() == XML::Reader::EVENT_START_ELEMENT && chunked.attributeCount() == 100);
+	CHECK(chunked.attribute("azc") != NULL && *chunked.attribute("azc") == "v");
+	std::string decoded;
+	while(chunked.next() == XML::Reader::EVENT_TEXT){
+		decoded += chunked.text().str();
+	}
+	CHECK(chunked.event() == XML::Reader::EVENT_END_ELEMENT && decoded == XML::DeEscapeString(text));
+	
+	//the handler sees the same
+	std::istringstream handled(input);
+	XML::Reader reader(handled, 16);
+	LogHandler handler;
+	reader.parse(handler);
+	CHECK(handler.log == "S:feed|S:record|id=1|type=a|one & two|E:record|S:record|id=2||E:record|S:record|id=3|type=b|x<y|E:record||E:feed|");
+}
+
+//The ids of every tag the splitter builds.
+static std::string SplitIds(XML::Splitter& splitter){
+	std::string ids;
+	while(XML::Tag* tag = splitter.next()){
+		const std::string* id = tag->attributes.get("id");
+		ids += (id == NULL) ? "?" : *id;
+		delete tag;
+	}
+	return ids;
+}
+
+//The splitter builds the matching elements the way FromBuffer does, from a buffer or a stream in chunks.
+static void SplitterMatchesRecords(){
+	const std::string input = FeedInput;
+	XML::Splitter all(input.data(), input.length(), "record");
+	CHECK(SplitIds(all) == "123" && all.count() == 3);
+	XML::Splitter typed(input.data(), input.length(), "record[@type='b']");
+	CHECK(SplitIds(typed) == "3");
+	XML::Splitter rooted(input.data(), input.length(), "/feed/record[2]");
+	CHECK(SplitIds(rooted) == "2");
+	XML::Splitter none(input.data(), input.length(), "/record");
+	CHECK(SplitIds(none) == "" && none.count() == 0);
+	for(std::size_t size = 1; size <= 40; size += 3){
+		std::istringstream is(input);
+		XML::Splitter chunked(is, "feed/record", size);
+		CHECK(SplitIds(chunked) == "123");
+	}
+	
+	//a query is relative to the document, so it needs "//" to match at any depth
+	XML::Splitter top(input.data(), input.length(), XML::Query("record"));
+	CHECK(SplitIds(top) == "");
+	
+	//the tags are the ones FromBuffer builds
+	XML::Document document = XML::Document::FromBuffer(input.data(), input.length());
+	const XML::Tag* feed = document.root->childWithName("feed");
+	XML::Splitter splitter(input.data(), input.length(), XML::Query("//record"));
+	XML::Tag output;
+	for(unsigned int i = 0; i < 3; ++i){
+		CHECK(splitter.next(&output));
+		std::ostringstream split, read;
+		output.writeToStream(split);
+		feed->children[2 * i + 1]->writeToStream(read);
+		CHECK(split.str() == read.str());
+	}
+	CHECK(!splitter.next(&output));
+	document.deleteTags();
+}
+
+//-------------------------------FromBufferParallel---------------------------------------//
+
+//Read documents larger than two of its pieces on fixed thread counts, so they are split even on a single core.
+//The records hold "<record" in comments, CDATA and attribute values, where a split would be wrong, and the same as FromBuffer has to come out.
+static void ParallelReadMatches(const std::string& input){
+	XML::Document read = XML::Document::FromBuffer(input.data(), input.length());
+	const std::string expected = Write(read);
+	read.deleteTags();
+	for(unsigned int threads = 2; threads <= 8; threads *= 2){
+		XML::Document parallel = XML::Document::FromBufferParallel(input.data(), input.length(), threads);
+		CHECK(Write(parallel) == expected);
+		parallel.deleteTags();
+	}
+}
+
+static void FromBufferParallelSplits(){
+	std::string records;
+	for(unsigned int i = 0; records.length() < 3000000; ++i){
+		records += "<record id=\"";
+		records += (char)('a' + i % 26);
+		records += "\" note=\"<record>\"><!-- <record> --><![CDATA[<record> ]]><?pi <record ?>text &amp; <b>more</b></record>\n";
+	}
+	//the records as children of the root, and as top level tags
+	ParallelReadMatches("<?xml version=\"1.0\"?><records>" + records + "</records>");
+	ParallelReadMatches(records);
+	//a comment and CDATA longer than a piece at the start, so the first split is inside of them
+	std::string tags;
+	while(tags.length() < 1200000){
+		tags += "<record> ";
+	}
+	ParallelReadMatches("<records><!--" + tags + "-->" + records + "</records>");
+	ParallelReadMatches("<records><![CDATA[" + tags + "]]>" + records + "</records>");
+}
+
+//-------------------------------PushParser---------------------------------------//
+
+//A megabyte long comment full of '>', then CDATA and a processing instruction like it, fed 16 bytes at a time.
+//When every '>' made the parser lex the whole comment again this took minutes, now it takes milliseconds.
+static void PushParserFeedsLongMarkup(){
+	std::string input = "<r><!--";
+	while(input.length() < 1000000){
+		input += "a -> b ";
+	}
+	input += "--><![CDATA[";
+	for(unsigned int i = 0; i < 10000; ++i){
+		input += "]> ";
+	}
+	input += "]]><?note";
+	for(unsigned int i = 0; i < 10000; ++i){
+		input += " ? >";
+	}
+	input += "?><e a=\"> >\"/></r>";
+	
+	XML::PushParser parser;
+	for(std::size_t offset = 0; offset < input.length(); offset += 16){
+		parser.feed(input.data() + offset, (input.length() - offset < 16) ? input.length() - offset : 16);
+	}
+	XML::Document pushed = parser.finish();
+	XML::Document read = XML::Document::FromBuffer(input.data(), input.length());
+	CHECK(Write(pushed) == Write(read));
+	pushed.deleteTags();
+	read.deleteTags();
+}
+
+//-------------------------------CompactDocument---------------------------------------//
+
+//The tree under a tag, with every string quoted, so empty strings show.
+static std::string Describe(const XML::Tag* tag){
+	std::string output = tag->name + "(";
+	for(unsigned int i = 0; i < tag->children.size(); ++i){
+		const XML::Object* child = tag->children[i];
+		output += (child->getType() == XML::XML_TAG) ? Describe((const XML::Tag*)child) : "'" + child->name + "'";
+	}
+	return output + ")";
+}
+
+//Empty strings are flags instead of nodes, and come back where they were when the document is expanded, from a snapshot too.
+static void CompactDocumentKeepsEmptyStrings(){
+	const std::string input = "<a><b></b><c/>text<d><![CDATA[]]></d><e> <f/></e></a>";
+	XML::Document read = XML::Document::FromBuffer(input.data(), input.length());
+	XML::CompactDocument* compact = XML::CompactDocument::FromBuffer(input.data(), input.length());
+	CHECK(compact->size() == 10);
+	CHECK(compact->root().firstChild().childWithName("d").firstChild().valid() == false);
+	
+	std::ostringstream os;
+	CHECK(compact->writeSnapshot(os));
+	const std::string snapshot = os.str();
+	XML::CompactDocument* loaded = XML::CompactDocument::FromSnapshot(snapshot.data(), snapshot.length());
+	CHECK(loaded != NULL);
+	for(unsigned int i = 0; i < 2 && loaded != NULL; ++i){
+		XML::Document expanded = (i == 0 ? compact : loaded)->toDocument();
+		CHECK(Describe(expanded.root) == Describe(read.root));
+		CHECK(Write(expanded) == Write(read));
+		CHECK(Write(expanded).find("<b></b>") != std::string::npos);
+		expanded.deleteTags();
+	}
+	delete loaded;
+	delete compact;
+	
+	//a tree built by hand can hold empty strings next to each other, or after other strings
+	XML::Tag* a = (XML::Tag*)read.root->children[0];
+	XML::Tag* e = (a->children.size() == 9 && a->children[7]->getType() == XML::XML_TAG) ? (XML::Tag*)a->children[7] : NULL;
+	CHECK(e != NULL && e->name == "e");
+	if(e != NULL){
+		e->addChildString("");
+		e->addChildString("");
+		e->addChildString("x");
+		e->addChildString("");
+	}
+	compact = XML::CompactDocument::FromDocument(read);
+	XML::Document copied = compact->toDocument();
+	CHECK(Describe(copied.root) == Describe(read.root));
+	copied.deleteTags();
+	delete compact;
+	read.deleteTags();
+}
+
+//-------------------------------ReadOnlyDocument---------------------------------------//
+
+//Empty elements are written the way they were read, which is what a document read by FromBuffer writes.
+static void ViewNodeWritesTagsAsRead(){
+	const std::string input = "<r><a></a><b/><c x=\"1\"></c><d> </d><e><![CDATA[]]></e></r>";
+	const std::string expected = "<r><a></a><b /><c x=\"1\"></c><d> </d><e></e></r>";
+	XML::ReadOnlyDocument* view = XML::ReadOnlyDocument::FromBuffer(input.data(), input.length());
+	std::ostringstream os;
+	view->root->firstChild->writeToStream(os);
+	CHECK(os.str() == expected);
+	delete view;
+	
+	XML::Document read = XML::Document::FromBuffer(input.data(), input.length());
+	std::ostringstream tag;
+	read.root->children[0]->writeToStream(tag);
+	CHECK(tag.str() == expected);
+	read.deleteTags();
+	
+	//a tag built without children closes itself
+	XML::Tag built("a");
+	std::ostringstream empty;
+	built.writeToStream(empty);
+	CHECK(empty.str() == "<a />");
+}
+
+//-------------------------------Bind---------------------------------------//
+
+struct BindAuthor{
+	int born;
+	std::string name;
+	
+	BindAuthor():born(0){}
+	
+	template<class Binder> static void bind(Binder& binder){
+		binder.attribute("born", &BindAuthor::born);
+		binder.text(&BindAuthor::name);
+	}
+};
+
+struct BindBook{
+	int id;
+	bool inPrint;
+	std::string title;
+	double price;
+	std::vector<std::string> tags;
+	BindAuthor author;
+	std::vector<BindAuthor> editors;
+	
+	BindBook():id(0), inPrint(false), price(0){}
+	
+	template<class Binder> static void bind(Binder& binder){
+		binder.attribute("id", &BindBook::id);
+		binder.attribute("inPrint", &BindBook::inPrint);
+		binder.element("title", &BindBook::title);
+		binder.element("price", &BindBook::price);
+		binder.element("tag", &BindBook::tags);
+		binder.element("author", &BindBook::author);
+		binder.element("editor", &BindBook::editors);
+	}
+};
+
+static std::string WriteBook(const BindBook& book){
+	std::ostringstream os;
+	XML::WriteStruct(os, "book", book);
+	return os.str();
+}
+
+//A struct with vectors of values and of structs, and a struct inside of it, is written escaped and read back the same.
+static void BindRoundTrip(){
+	BindBook book;
+	book.id = 7;
+	book.inPrint = true;
+	book.title = "Fish & \"Chips\" <2>";
+	book.price = 12.5;
+	book.tags.push_back("a");
+	book.tags.push_back("b<c");
+	book.author.born = 1950;
+	book.author.name = "Ann";
+	BindAuthor editor;
+	editor.born = 1;
+	editor.name = "E1";
+	book.editors.push_back(editor);
+	editor.born = 2;
+	editor.name = "E2";
+	book.editors.push_back(editor);
+	
+	const std::string written = WriteBook(book);
+	CHECK(written == "<book id=\"7\" inPrint=\"true\"><title>Fish &amp; &quot;Chips&quot; &lt;2&gt;</title><price>12.5</price>"
+		"<tag>a</tag><tag>b&lt;c</tag><author born=\"1950\">Ann</author><editor born=\"1\">E1</editor><editor born=\"2\">E2</editor></book>");
+		
+	BindBook read;
+	CHECK(XML::ReadStruct(written.data(), written.length(), read));
+	CHECK(read.id == 7 && read.inPrint && read.title == book.title && read.price == 12.5);
+	CHECK(read.tags == book.tags);
+	CHECK(read.author.born == 1950 && read.author.name == "Ann");
+	CHECK(read.editors.size() == 2);
+	for(unsigned int i = 0; i < 2 && i < read.editors.size(); ++i){
+		CHECK(read.editors[i].born == book.editors[i].born && read.editors[i].name == book.editors[i].name);
+	}
+	CHECK(WriteBook(read) == written);
+	
+	//unknown attributes and elements are skipped, with the fields inside of them, and missing fields keep their value
+	const std::string input = "<book id=\"3\" other=\"x\"><skip><title>no</title></skip><title>T &amp; U</title><tag>x</tag></book>";
+	BindBook partial;
+	partial.price = 4;
+	CHECK(XML::ReadStruct(input.data(), input.length(), partial));
+	CHECK(partial.id == 3 && partial.title == "T & U" && partial.price == 4);
+	CHECK(partial.tags.size() == 1 && partial.tags[0] == "x");
+	
+	//a document which ends inside of the element, or holds none
+	const std::string cut = "<book><title>T</title>";
+	BindBook unread;
+	CHECK(XML::ReadStruct(cut.data(), cut.length(), unread) == false);
+	CHECK(XML::ReadStruct("", 0, unread) == false);
+}
+
+//-------------------------------Writer---------------------------------------//
+
+static bool RefuseOutput(const char* /*data*/, std::size_t /*length*/, void* /*context*/){
+	return false;
+}
+
+//Empty elements close themselves, text and attributes are escaped, and calls which do not fit where the writer is return false and write nothing.
+static void WriterClosesAndRefuses(){
+	std::ostringstream os;
+	{
+		//chunks smaller than the output, so it is passed on in several
+		XML::Writer writer(os, 16);
+		CHECK(writer.endElement() == false);
+		CHECK(writer.text("top") == false);
+		CHECK(writer.declaration());
+		CHECK(writer.declaration() == false);
+		CHECK(writer.startElement("r"));
+		CHECK(writer.attribute("a", "1 < 2 & \"3\""));
+		CHECK(writer.attribute("", "x") == false);
+		CHECK(writer.startElement("empty"));
+		CHECK(writer.text(""));
+		CHECK(writer.endElement());
+		CHECK(writer.startElement("") == false);
+		CHECK(writer.element("t", "a<b>&c"));
+		CHECK(writer.startElement("open"));
+		CHECK(writer.text("x"));
+		CHECK(writer.attribute("late", "1") == false);
+		CHECK(writer.depth() == 2);
+		CHECK(writer.finish());
+		CHECK(writer.depth() == 0);
+		CHECK(writer.endElement() == false);
+	}
+	CHECK(os.str() == "<?xml version=\"1.0\"?><r a=\"1 &lt; 2 &amp; &quot;3&quot;\"><empty /><t>a&lt;b&gt;&amp;c</t><open>x</open></r>");
+	
+	//the elements still open are ended when the writer is destroyed
+	std::ostringstream unfinished;
+	{
+		XML::Writer writer(unfinished);
+		writer.startElement("a");
+		writer.startElement("b");
+		writer.text("c");
+	}
+	CHECK(unfinished.str() == "<a><b>c</b></a>");
+	
+	//a sink which fails is reported by finish and good
+	XML::Writer refused(RefuseOutput, NULL);
+	refused.element("a", "b");
+	CHECK(refused.finish() == false);
+	CHECK(refused.good() == false);
+}
+
+//-------------------------------ParseStats---------------------------------------//
+
+static void CountStats(const XML::ParseStats& /*stats*/, void* context){
+	++*(unsigned int*)context;
+}
+
+//The counts of a document match its tree, the totals add up every document, and nothing is measured once they are disabled.
+static void ParseStatsCountTree(){
+	//the tree holds 6 strings, with the empty ones before b, c and d
+	const std::string input = "<a x=\"1\" y=\"2\"><b>t &amp; &#65;</b><c z=\"3\"><d/></c>tail</a>";
+	unsigned int callbacks = 0;
+	XML::ResetParseStats();
+	XML::SetParseStatsCallback(CountStats, &callbacks);
+	XML::EnableParseStats();
+	CHECK(XML::ParseStatsEnabled());
+	
+	XML::Document first = XML::Document::FromBuffer(input.data(), input.length());
+	const XML::ParseStats last = XML::LastParseStats();
+	CHECK(last.documents == 1 && last.bytes == input.length());
+	CHECK(last.elements == 4 && last.attributes == 3 && last.textNodes == 6);
+	CHECK(last.entities == 2 && last.maxDepth == 3);
+	CHECK(last.treeBytes > 0);
+#ifdef XML_CPP11
+	CHECK(last.seconds > 0);
+#endif
+	
+	XML::Document second = XML::Document::FromBuffer(input.data(), input.length());
+	XML::EnableParseStats(false);
+	XML::Document unmeasured = XML::Document::FromBuffer(input.data(), input.length());
+	const XML::ParseStats total = XML::TotalParseStats();
+	CHECK(total.documents == 2 && total.bytes == 2 * input.length());
+	CHECK(total.elements == 8 && total.attributes == 6 && total.textNodes == 12 && total.entities == 4);
+	CHECK(total.maxDepth == 3 && total.treeBytes == 2 * last.treeBytes);
+	CHECK(callbacks == 2);
+	
+	XML::SetParseStatsCallback(NULL);
+	XML::ResetParseStats();
+	CHECK(XML::TotalParseStats().documents == 0 && XML::TotalParseStats().bytes == 0);
+	first.deleteTags();
+	second.deleteTags();
+	unmeasured.deleteTags();
+}
+
+//-------------------------------BatchParser---------------------------------------//
+
+//The name of the first tag of a document, "" if it has none.
+static std::string FirstTagName(const XML::Document& document){
+	for(unsigned int i = 0; i < document.root->children.size(); ++i){
+		if(document.root->children[i]->getType() == XML::XML_TAG){
+			return document.root->children[i]->name;
+		}
+	}
+	return "";
+}
+
+//Each buffer without a tag is a failure of its own, the others are read, and every document has a root either way.
+static void BatchParserReportsFailures(){
+	const std::string inputs[] = {"<a>1</a>", "", "just text", "<?xml version=\"1.0\"?>", "<b x=\"2\"><c/></b>", "   ", "<open>", "<!-- c -->"};
+	const bool failed[] = {false, true, true, true, false, true, false, true};
+	const char* names[] = {"a", "", "", "", "b", "", "open", ""};
+	std::vector<XML::Buffer> buffers;
+	//enough documents for every thread to have some, with the failures at known places
+	for(unsigned int i = 0; i < 64; ++i){
+		buffers.push_back(XML::Buffer(inputs[i % 8]));
+	}
+	XML::BatchParser parser(3);
+	CHECK(parser.parse(buffers) == 40);
+	CHECK(parser.size() == 64);
+	for(unsigned int i = 0; i < parser.size(); ++i){
+		CHECK(parser.failed(i) == failed[i % 8]);
+		CHECK(parser.document(i).root != NULL);
+		CHECK(FirstTagName(parser.document(i)) == names[i % 8]);
+	}
+	
+	//the next batch replaces the previous one
+	CHECK(parser.parse(&buffers[1], 4) == 3);
+	CHECK(parser.size() == 4);
+	CHECK(parser.failed(0) && parser.failed(2) && !parser.failed(3));
+	CHECK(FirstTagName(parser.document(3)) == "b");
+	CHECK(parser.parse(NULL, 0) == 0 && parser.size() == 0);
+}
+
+//-------------------------------DocumentCache---------------------------------------//
+
+static void WriteFile(const char* path, const std::string& content){
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file << content;
+}
+
+//A changed file is swapped for a new version by refresh, while handles to the old version keep it, and an unchanged or deleted file keeps its version.
+static void DocumentCacheRefreshesAndSwaps(){
+	const char* path = "tests_cache.xml";
+	std::remove(path);
+	XML::DocumentHandle kept;
+	{
+		XML::DocumentCache cache(0);
+		CHECK(cache.get(path).valid() == false);
+		CHECK(cache.size() == 0);
+		
+		WriteFile(path, "<a>1</a>");
+		XML::DocumentHandle first = cache.get(path);
+		CHECK(first.valid() && first.version() == 1);
+		CHECK(cache.size() == 1);
+		CHECK(first.valid() && FirstTagName(*first) == "a");
+		CHECK(first.valid() && &cache.get(path).document() == &first.document());
+		CHECK(cache.refresh() == 0);
+		
+		//a different size, so the change is seen even where modification times are coarse
+		WriteFile(path, "<b>22</b>");
+		CHECK(cache.get(path).version() == 1);
+		CHECK(cache.refresh() == 1);
+		XML::DocumentHandle second = cache.get(path);
+		CHECK(second.valid() && second.version() == 2 && FirstTagName(*second) == "b");
+		CHECK(second.valid() && second.signature().size == 9);
+		CHECK(first.valid() && first.version() == 1 && FirstTagName(*first) == "a");
+		
+		//the same content written again is not read again, and a deleted file keeps the last version
+		WriteFile(path, "<b>22</b>");
+		CHECK(cache.refresh() == 0);
+		std::remove(path);
+		CHECK(cache.refresh() == 0);
+		CHECK(cache.get(path).version() == 2);
+		
+		cache.remove(path);
+		CHECK(cache.size() == 0);
+		kept = second;
+	}
+	//and after the cache is gone
+	CHECK(kept.valid() && kept.version() == 2 && FirstTagName(*kept) == "b");
+}
+
+//-------------------------------main---------------------------------------//
+
+int main(){
+	CharacterReferences();
+#ifdef XML_CPP11
+	DocumentOwnsTagsBuiltByHand();
+	StringMovedToItself();
+#endif
+	MissingFileReadsEmpty();
+	AttributesKeepOrder();
+	AttributeKeysShared();
+	ChildIndexNoticesReplacedChildren();
+	ChildIndexFollowsTagChanges();
+	ChildIndexKeyedByAtoms();
+#ifdef XML_CPP11
+	ChildIndexSharedBetweenThreads();
+#endif
+	QueryPredicatesAndPositions();
+	ReaderEventsAcrossChunks();
+	SplitterMatchesRecords();
+	FromBufferParallelSplits();
+	PushParserFeedsLongMarkup();
+	CompactDocumentKeepsEmptyStrings();
+	ViewNodeWritesTagsAsRead();
+	BindRoundTrip();
+	WriterClosesAndRefuses();
+	ParseStatsCountTree();
+	BatchParserReportsFailures();
+	DocumentCacheRefreshesAndSwaps();
+	
+	if(failures != 0){
+		printf("%u checks failed\n", failures);
+		return 1;
+	}
+	printf("all checks passed\n");
+	return 0;
+}